@@ -0,0 +1,240 @@
+#ifndef BENCHSUPPORT_H
+#define BENCHSUPPORT_H
+
+#include "Budget.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+// Wall-clock stopwatch
+class Stopwatch {
+private:
+    chrono::steady_clock::time_point start;
+
+public:
+    Stopwatch() : start(chrono::steady_clock::now()) {}
+    void reset() { start = chrono::steady_clock::now(); }
+    double seconds() const {
+        return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    }
+};
+
+// Small deterministic generator so every run sees the same data
+class SplitMix64 {
+private:
+    uint64_t state;
+
+public:
+    explicit SplitMix64(uint64_t seed) : state(seed) {}
+
+    uint64_t next() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    // Uniform in (0, 1)
+    double uniform() { return (static_cast<double>(next() >> 11) + 0.5) / 9007199254740992.0; }
+
+    // Standard normal (Box-Muller)
+    double normal() { return sqrt(-2.0 * log(uniform())) * cos(6.283185307179586 * uniform()); }
+
+    // Whole-cent amount in [low, high) dollars
+    Money amount(int64_t low, int64_t high) {
+        return Money::fromCents(low * 100 + static_cast<int64_t>(next() % static_cast<uint64_t>((high - low) * 100)));
+    }
+};
+
+// Synthetic budgets for users x months
+inline vector<Budget> makeBudgets(size_t users, size_t months, uint64_t seed = 42) {
+    static const char* const monthNames[] = {"January", "February", "March", "April", "May", "June",
+                                             "July", "August", "September", "October", "November", "December"};
+    SplitMix64 rng(seed);
+    vector<Budget> budgets;
+    budgets.reserve(users * months);
+    for (size_t m = 0; m < months; m++) {
+        string month = string(monthNames[m % 12]) + " " + to_string(2020 + m / 12);
+        for (size_t u = 0; u < users; u++) {
+            Budget b("user" + to_string(u) + "@example.com", month);
+            b.setSalary(rng.amount(2000, 9000));
+            b.setFreelance(rng.amount(0, 1500));
+            b.setInvestments(rng.amount(0, 400));
+            b.setRent(rng.amount(600, 2500));
+            b.setGroceries(rng.amount(150, 800));
+            b.setUtilities(rng.amount(50, 300));
+            b.setTransportation(rng.amount(20, 400));
+            b.setEntertainment(rng.amount(0, 300));
+            b.setHealthcare(rng.amount(0, 250));
+            b.setShopping(rng.amount(0, 600));
+            b.setOtherExpenses(rng.amount(0, 200));
+            b.setSavingsGoal(rng.amount(100, 1500));
+            budgets.push_back(b);
+        }
+    }
+    return budgets;
+}
+
+// Shape of a synthetic budget history
+struct HistoryOptions {
+    size_t users;
+    size_t months;      // consecutive months starting January 2020
+    uint64_t seed;
+    double skew;        // Pareto shape of the income tail; lower means more very high earners
+
+    HistoryOptions(size_t u = 1000, size_t m = 24, uint64_t s = 42, double k = 2.5)
+        : users(u), months(m), seed(s), skew(k) {}
+};
+
+// Realistic histories for users x months, the same for the same options.
+// Salaries follow a Pareto tail and get a yearly raise; rent tracks
+// salary and rises each January; utilities are seasonal; a minority of
+// users freelance, invest or pay tuition; entertainment and shopping are
+// heavy tailed with a December peak; healthcare is usually small with
+// rare large bills. Budgets come out month by month.
+inline vector<Budget> makeHistory(const HistoryOptions& options) {
+    static const char* const monthNames[] = {"January", "February", "March", "April", "May", "June",
+                                             "July", "August", "September", "October", "November", "December"};
+    struct Profile {
+        string name;
+        double salary;
+        double rentShare;
+        double freelance;   // 0 for users without side income
+        double invested;    // 0 for users without investments
+        bool student;
+    };
+    SplitMix64 rng(options.seed);
+    vector<Profile> profiles(options.users);
+    for (size_t u = 0; u < options.users; u++) {
+        Profile& p = profiles[u];
+        p.name = "user" + to_string(u) + "@example.com";
+        p.salary = min(2200.0 * pow(rng.uniform(), -1.0 / options.skew), 60000.0);
+        p.rentShare = 0.22 + 0.14 * rng.uniform();
+        p.freelance = rng.uniform() < 0.3 ? p.salary * (0.05 + 0.3 * rng.uniform()) : 0;
+        p.invested = rng.uniform() < 0.25 ? p.salary * (2 + 20 * rng.uniform()) : 0;
+        p.student = rng.uniform() < 0.12;
+    }
+
+    auto money = [](double dollars) { return Money::fromCents(max<int64_t>(0, llround(dollars * 100))); };
+    vector<Budget> budgets;
+    budgets.reserve(options.users * options.months);
+    for (size_t m = 0; m < options.months; m++) {
+        int calendar = static_cast<int>(m % 12);
+        double years = static_cast<double>(m / 12);
+        double season = cos(6.283185307179586 * calendar / 12.0);  // +1 in January, -1 in July
+        string month = string(monthNames[calendar]) + " " + to_string(2020 + m / 12);
+        for (const Profile& p : profiles) {
+            Budget b(p.name, month);
+            double salary = p.salary * pow(1.03, years);
+            b.setSalary(money(salary));
+            if (p.freelance > 0 && rng.uniform() < 0.6) b.setFreelance(money(p.freelance * exp(0.6 * rng.normal())));
+            if (p.invested > 0) b.setInvestments(money(p.invested * 0.004 * (1 + 0.5 * rng.normal())));
+            if (rng.uniform() < 0.05) b.setOtherIncome(money(50 + 400 * rng.uniform()));
+
+            b.setRent(money(p.salary * p.rentShare * pow(1.04, years)));
+            b.setGroceries(money((280 + 0.04 * salary) * (1 + 0.12 * rng.normal())));
+            b.setUtilities(money((110 + 45 * fabs(season)) * (1 + 0.1 * rng.normal())));
+            b.setTransportation(money(60 + 160 * rng.uniform() + (rng.uniform() < 0.03 ? 600 : 0)));
+            double holiday = calendar == 11 ? 2.2 : calendar == 10 ? 1.3 : 1.0;
+            b.setEntertainment(money(0.02 * salary * exp(0.7 * rng.normal()) * holiday));
+            b.setShopping(money(0.04 * salary * exp(0.8 * rng.normal()) * holiday));
+            b.setHealthcare(money(rng.uniform() < 0.04 ? 300 + 3000 * rng.uniform() : 40 * rng.uniform()));
+            if (p.student && (calendar == 0 || calendar == 8)) b.setEducation(money(1500 + 3500 * rng.uniform()));
+            b.setOtherExpenses(money(30 + 120 * rng.uniform()));
+            b.setSavingsGoal(money(salary * (0.08 + 0.12 * rng.uniform())));
+            budgets.push_back(move(b));
+        }
+    }
+    return budgets;
+}
+
+// Heap allocations made by the program. The counting operator new is
+// compiled only into the one translation unit that defines
+// BENCH_COUNT_ALLOCATIONS before including this header.
+inline atomic<uint64_t> allocationCount(0);
+inline atomic<uint64_t> allocationBytes(0);
+
+#ifdef BENCH_COUNT_ALLOCATIONS
+// noinline keeps GCC from pairing the inlined malloc/free with new/delete
+__attribute__((noinline)) void* operator new(size_t size) {
+    allocationCount.fetch_add(1, memory_order_relaxed);
+    allocationBytes.fetch_add(size, memory_order_relaxed);
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw bad_alloc();
+}
+__attribute__((noinline)) void* operator new(size_t size, align_val_t align) {
+    allocationCount.fetch_add(1, memory_order_relaxed);
+    allocationBytes.fetch_add(size, memory_order_relaxed);
+    size_t alignment = static_cast<size_t>(align);
+    if (void* p = aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)) return p;
+    throw bad_alloc();
+}
+__attribute__((noinline)) void operator delete(void* p) noexcept { free(p); }
+__attribute__((noinline)) void operator delete(void* p, size_t) noexcept { free(p); }
+__attribute__((noinline)) void operator delete(void* p, align_val_t) noexcept { free(p); }
+__attribute__((noinline)) void operator delete(void* p, size_t, align_val_t) noexcept { free(p); }
+#endif
+
+struct BenchResult {
+    string name;
+    uint64_t ops;
+    double nsPerOp;
+    double allocsPerOp;
+    double bytesPerOp;
+};
+
+// Runs named benchmarks and reports them as JSON. Each body performs
+// opsPerRun operations; it is run once to warm up, then repeatedly until
+// minSeconds have passed, and the time and allocations are divided by
+// the operations performed.
+class BenchSuite {
+private:
+    vector<BenchResult> results;
+    double minSeconds;
+    string filter;
+
+public:
+    explicit BenchSuite(double seconds = 0.5, const string& only = "") : minSeconds(seconds), filter(only) {}
+
+    template<typename Body>
+    void run(const string& name, uint64_t opsPerRun, Body body) {
+        if (!filter.empty() && name.find(filter) == string::npos) return;
+        body();
+        uint64_t runs = 0;
+        uint64_t allocations = allocationCount.load();
+        uint64_t bytes = allocationBytes.load();
+        Stopwatch timer;
+        do {
+            body();
+            runs++;
+        } while (timer.seconds() < minSeconds);
+        double seconds = timer.seconds();
+        double ops = static_cast<double>(runs * opsPerRun);
+        results.push_back({name, runs * opsPerRun, seconds * 1e9 / ops, (allocationCount.load() - allocations) / ops,
+                           (allocationBytes.load() - bytes) / ops});
+        fprintf(stderr, "%-28s %12.1f ns/op %10.2f allocs/op %12.1f B/op\n", name.c_str(), results.back().nsPerOp,
+                results.back().allocsPerOp, results.back().bytesPerOp);
+    }
+
+    const vector<BenchResult>& getResults() const { return results; }
+
+    // {"config": {...}, "results": [{"name", "ops", "ns_per_op", ...}]}
+    // config holds already formatted "key": value pairs
+    void writeJson(FILE* out, const string& config) const {
+        fprintf(out, "{\n  \"config\": {%s},\n  \"results\": [", config.c_str());
+        for (size_t i = 0; i < results.size(); i++) {
+            const BenchResult& r = results[i];
+            fprintf(out, "%s\n    {\"name\": \"%s\", \"ops\": %llu, \"ns_per_op\": %.2f, \"allocs_per_op\": %.3f, "
+                    "\"bytes_per_op\": %.1f}", i ? "," : "", r.name.c_str(), static_cast<unsigned long long>(r.ops),
+                    r.nsPerOp, r.allocsPerOp, r.bytesPerOp);
+        }
+        fprintf(out, "\n  ]\n}\n");
+    }
+};
+
+#endif
@@ -0,0 +1,35 @@
+// AggregationEngine scaling: rollup time and speedup per thread count
+#include "AggregationEngine.h"
+#include "BenchSupport.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+int main(int argc, char* argv[]) {
+    size_t users = argc > 1 ? stoul(argv[1]) : 10000;
+    size_t months = argc > 2 ? stoul(argv[2]) : 100;
+    size_t maxThreads = argc > 3 ? stoul(argv[3]) : ThreadPool::defaultThreadCount();
+
+    BudgetLedger ledger;
+    for (const Budget& b : makeBudgets(users, months)) ledger.add(b);
+    printf("%zu records, %zu users, %zu months\n", ledger.size(), ledger.getUsers().size(), ledger.getMonths().size());
+
+    AggregationResult reference;
+    double baseline = 0;
+    for (size_t threads = 1; threads <= maxThreads; threads *= 2) {
+        AggregationEngine engine(threads);
+        Stopwatch timer;
+        AggregationResult result = engine.aggregate(ledger);
+        double seconds = timer.seconds();
+        if (threads == 1) {
+            reference = result;
+            baseline = seconds;
+        }
+        bool same = memcmp(result.users.data(), reference.users.data(), result.users.size() * sizeof(Rollup)) == 0 &&
+                    memcmp(result.months.data(), reference.months.data(), result.months.size() * sizeof(Rollup)) == 0;
+        printf("  %3zu threads  %8.3f s  %6.2fx  %8.2f M records/sec  %s\n", threads, seconds, baseline / seconds,
+               ledger.size() / seconds / 1e6, same ? "" : "RESULT MISMATCH");
+        if (threads < maxThreads && threads * 2 > maxThreads) threads = maxThreads / 2;
+    }
+    return 0;
+}
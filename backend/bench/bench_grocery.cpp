@@ -0,0 +1,60 @@
+// GroceryLedger vs a vector of string-keyed items: insert throughput and memory
+#include "GroceryLedger.h"
+#include "BenchSupport.h"
+#include <cstdio>
+#include <string>
+
+// The root grocery tracker's layout, plus the fields the ledger keeps
+struct StringItem {
+    string name;
+    string store;
+    uint32_t date;
+    float quantity;
+    float price;
+};
+
+int main(int argc, char* argv[]) {
+    size_t lines = argc > 1 ? stoul(argv[1]) : 20000000;
+    size_t distinctItems = argc > 2 ? stoul(argv[2]) : 5000;
+
+    vector<string> names;
+    for (size_t i = 0; i < distinctItems; i++) names.push_back("grocery item number " + to_string(i));
+    vector<string> storeNames = {"Corner Market", "FreshCo Superstore", "Farmers Market", "Discount Foods"};
+
+    SplitMix64 rng(7);
+    vector<uint32_t> picks(lines);
+    vector<Money> prices(lines);
+    for (size_t i = 0; i < lines; i++) {
+        picks[i] = static_cast<uint32_t>(rng.next() % distinctItems);
+        prices[i] = rng.amount(0, 40);
+    }
+
+    Expense groceries;
+    GroceryLedger ledger;
+    ledger.bind(groceries, 202405);
+    Stopwatch timer;
+    for (size_t i = 0; i < lines; i++) {
+        ledger.add(names[picks[i]], 1 + (i % 3) * 0.5, prices[i], storeNames[i % storeNames.size()], 20240501 + i % 28);
+    }
+    double ledgerSeconds = timer.seconds();
+
+    vector<StringItem> baseline;
+    timer.reset();
+    for (size_t i = 0; i < lines; i++) {
+        baseline.push_back({names[picks[i]], storeNames[i % storeNames.size()], static_cast<uint32_t>(20240501 + i % 28),
+                            1 + (i % 3) * 0.5f, static_cast<float>(prices[i].toDouble())});
+    }
+    float baselineTotal = 0;
+    for (const StringItem& item : baseline) baselineTotal += item.quantity * item.price;
+    double baselineSeconds = timer.seconds();
+
+    printf("%zu lines, %zu distinct items\n", lines, ledger.itemCount());
+    printf("  GroceryLedger        %8.2f M lines/sec  %6.1f bytes/line  total %s\n", lines / ledgerSeconds / 1e6,
+           static_cast<double>(ledger.bytesReserved()) / lines, ledger.getTotal().toString().c_str());
+    printf("  vector<StringItem>   %8.2f M lines/sec  %6.1f bytes/line + string heap  total %.2f (float)\n",
+           lines / baselineSeconds / 1e6, static_cast<double>(baseline.capacity() * sizeof(StringItem)) / lines,
+           baselineTotal);
+    printf("  Bound Expense groceries: %s (%s)\n", groceries.getGroceries().toString().c_str(),
+           groceries.getGroceries() == ledger.getMonthTotal(202405) ? "in sync" : "OUT OF SYNC");
+    return 0;
+}
@@ -0,0 +1,137 @@
+// History codec: encodes a multi-year synthetic history as text, as raw
+// delta/varint blocks and (with BUDGET_HAVE_ZLIB) deflated blocks, checks
+// the round trip and reports compression ratio and scan throughput of each
+// decoder against the text parser. GB/s is text-equivalent bytes per second.
+//   bench_history [users] [months] [runs]
+#include "FileHandler.h"
+#include "BenchSupport.h"
+#include <chrono>
+#include <cstdio>
+
+// Touches every field so no decoder can skip work
+struct ChecksumSink {
+    uint64_t sum = 0;
+    size_t records = 0;
+
+    void begin() { records++; }
+    void setText(int key, string_view value) { sum += value.size() * static_cast<uint64_t>(key); }
+    void setValue(int column, Money value) { sum += static_cast<uint64_t>(value.getCents()) * (column + 1); }
+    void commit(uint64_t, uint64_t) {}
+    void discard() {}
+    void reserve(size_t) {}
+};
+
+static uint64_t fileBytes(const string& path) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) return 0;
+    uint64_t size = streamSize(file);
+    fclose(file);
+    return size;
+}
+
+// Fastest of runs, in seconds
+template<typename Body>
+static double best(size_t runs, Body body) {
+    double fastest = 1e30;
+    for (size_t r = 0; r < runs; r++) {
+        auto start = chrono::steady_clock::now();
+        body();
+        fastest = min(fastest, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+    }
+    return fastest;
+}
+
+// Decoded records must be the input grouped by user, then in month order
+static size_t countMismatches(const vector<Budget>& input, const vector<Budget>& decoded) {
+    StringInterner users;
+    vector<uint32_t> userIds(input.size());
+    for (size_t i = 0; i < input.size(); i++) userIds[i] = users.intern(input[i].getUserName());
+    vector<size_t> order(input.size());
+    for (size_t i = 0; i < order.size(); i++) order[i] = i;
+    stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        if (userIds[a] != userIds[b]) return userIds[a] < userIds[b];
+        return HistoryStore::monthKey(input[a].getMonth()) < HistoryStore::monthKey(input[b].getMonth());
+    });
+
+    size_t mismatches = input.size() == decoded.size() ? 0 : 1;
+    for (size_t i = 0; i < order.size() && i < decoded.size(); i++) {
+        const Budget& a = input[order[i]];
+        const Budget& b = decoded[i];
+        if (a.getUserName() != b.getUserName() || a.getMonth() != b.getMonth()) mismatches++;
+        for (int c = 0; c < NUM_BUDGET_COLUMNS; c++) {
+            if (BudgetColumns::get(a, c) != BudgetColumns::get(b, c)) mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+int main(int argc, char* argv[]) {
+    HistoryOptions options(argc > 1 ? stoul(argv[1]) : 2000, argc > 2 ? stoul(argv[2]) : 120);
+    size_t runs = argc > 3 ? stoul(argv[3]) : 3;
+    vector<Budget> history = makeHistory(options);
+
+    const string textPath = "bench_history.tmp";
+    const string rawPath = "bench_history.bgth.tmp";
+    const string deflatePath = "bench_history.z.bgth.tmp";
+    remove(textPath.c_str());
+    {
+        FileHandler text(textPath);
+        if (!text.saveBudgets(history) || !text.flush()) return 1;
+    }
+    double textBytes = static_cast<double>(fileBytes(textPath));
+    printf("%zu budgets (%zu users x %zu months), text %.1f MB\n", history.size(), options.users, options.months,
+           textBytes / 1e6);
+
+    struct Variant {
+        const char* name;
+        string path;
+        bool compress;
+    };
+    vector<Variant> variants = {{"delta+varint", rawPath, false}};
+    if (HistoryStore::compressionAvailable()) variants.push_back({"delta+varint+deflate", deflatePath, true});
+
+    ChecksumSink reference;
+    double textSeconds = best(runs, [&] {
+        reference = ChecksumSink();
+        BudgetTextParser parser;
+        parser.parseFile(textPath, reference);
+    });
+    printf("  %-22s %8.1f MB  ratio %5.1fx  scan %6.2f GB/s  %5.1f M records/s\n", "text", textBytes / 1e6, 1.0,
+           textBytes / textSeconds / 1e9, reference.records / textSeconds / 1e6);
+
+    size_t mismatches = 0;
+    for (const Variant& v : variants) {
+        double encodeSeconds = best(1, [&] { HistoryStore::write(v.path, history, HistoryWriteOptions(v.compress)); });
+        double bytes = static_cast<double>(fileBytes(v.path));
+
+        ChecksumSink sink;
+        double seconds = best(runs, [&] {
+            sink = ChecksumSink();
+            HistoryReader reader;
+            if (!reader.open(v.path) || !reader.decode(sink)) mismatches++;
+        });
+        if (sink.sum != reference.sum || sink.records != reference.records) mismatches++;
+
+        FileHandler handler(v.path, HISTORY_FORMAT);
+        mismatches += countMismatches(history, handler.loadBudgets());
+        printf("  %-22s %8.1f MB  ratio %5.1fx  scan %6.2f GB/s  %5.1f M records/s  (%.0f MB/s of file, encode %.2f s)\n",
+               v.name, bytes / 1e6, textBytes / bytes, textBytes / seconds / 1e9, sink.records / seconds / 1e6,
+               bytes / seconds / 1e6, encodeSeconds);
+        remove(v.path.c_str());
+    }
+
+    // Whole-store loads into budgets, as the menu and reports see them
+    FileHandler text(textPath);
+    FileHandler compact(rawPath, HISTORY_FORMAT);
+    compact.saveBudgets(history);
+    size_t loaded = 0;
+    double textLoad = best(runs, [&] { loaded += text.loadBudgets().size(); });
+    double historyLoad = best(runs, [&] { loaded += compact.loadBudgets().size(); });
+    printf("  loadBudgets: text %.0f ms, history %.0f ms\n", textLoad * 1e3, historyLoad * 1e3);
+
+    remove(textPath.c_str());
+    remove(rawPath.c_str());
+    printf("  %zu mismatches (checksum %llu, %zu loaded)\n", mismatches,
+           static_cast<unsigned long long>(reference.sum), loaded);
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,172 @@
+// Load generator for the --serve JSON API: keep-alive clients issue a mix
+// of summary reads and budget updates, then report requests/sec and p50/p99
+// latency. Without a port it starts an in-process server on a temp file.
+//   bench_http [connections] [seconds] [write percent] [port]
+#include "BudgetApi.h"
+#include "BenchSupport.h"
+#include <cstdio>
+#include <string>
+
+#ifdef BUDGET_HAVE_EPOLL
+
+// One blocking keep-alive connection
+class Client {
+private:
+    int fd;
+    string response;
+
+public:
+    Client() : fd(-1) {}
+    ~Client() { if (fd >= 0) close(fd); }
+
+    bool connectTo(uint16_t port) {
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        return connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+    }
+
+    // Send a request and read the whole response; returns the status or -1
+    int roundTrip(const string& request) {
+        size_t sent = 0;
+        while (sent < request.size()) {
+            ssize_t n = send(fd, request.data() + sent, request.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) return -1;
+            sent += static_cast<size_t>(n);
+        }
+        response.clear();
+        size_t headerEnd = string::npos;
+        size_t total = 0;
+        char chunk[16384];
+        while (headerEnd == string::npos || response.size() < total) {
+            ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+            if (n <= 0) return -1;
+            response.append(chunk, static_cast<size_t>(n));
+            if (headerEnd == string::npos && (headerEnd = response.find("\r\n\r\n")) != string::npos) {
+                size_t length = response.find("Content-Length: ");
+                if (length == string::npos) return -1;
+                total = headerEnd + 4 + strtoul(response.c_str() + length + 16, nullptr, 10);
+            }
+        }
+        return atoi(response.c_str() + 9);
+    }
+};
+
+static string pathSegment(const string& text) {
+    string out;
+    for (char c : text) {
+        if (c == ' ') out += "%20";
+        else out += c;
+    }
+    return out;
+}
+
+int main(int argc, char* argv[]) {
+    size_t connections = argc > 1 ? stoul(argv[1]) : 16;
+    double seconds = argc > 2 ? stod(argv[2]) : 5;
+    unsigned writePercent = argc > 3 ? static_cast<unsigned>(stoul(argv[3])) : 10;
+    uint16_t port = argc > 4 ? static_cast<uint16_t>(stoul(argv[4])) : 0;
+
+    vector<Budget> budgets = makeBudgets(200, 24);
+    unique_ptr<FileHandler> handler;
+    unique_ptr<BudgetApi> api;
+    unique_ptr<HttpServer> server;
+    if (port == 0) {
+        remove("bench_http.tmp");
+        remove("bench_http.tmp.idx");
+        handler.reset(new FileHandler("bench_http.tmp"));
+        handler->setWriterOptions(WriterOptions(256, chrono::milliseconds(5)));
+        handler->saveBudgets(budgets);
+        api.reset(new BudgetApi(*handler));
+        api->load();
+        BudgetApi* target = api.get();
+        server.reset(new HttpServer([target](const HttpRequest& request, HttpResponse& response) {
+            target->handle(request, response);
+        }, HttpServerOptions(0)));
+        if (!server->start()) return 1;
+        port = server->getPort();
+        printf("in-process server on port %u, %zu workers, %zu budgets\n", port, server->getThreadCount(), budgets.size());
+    }
+
+    // Requests are built up front so the clients measure only the server
+    vector<string> reads, writes;
+    for (const Budget& b : budgets) {
+        string path = "/api/budgets/" + pathSegment(b.getUserName()) + "/" + pathSegment(b.getMonth());
+        reads.push_back("GET " + path + "/summary HTTP/1.1\r\nHost: localhost\r\n\r\n");
+        string body;
+        JsonExporter::appendBudget(body, b);
+        writes.push_back("PUT " + path + " HTTP/1.1\r\nHost: localhost\r\nContent-Type: application/json\r\nContent-Length: " +
+                         to_string(body.size()) + "\r\n\r\n" + body);
+    }
+
+    vector<vector<uint32_t>> latencies(connections);
+    vector<size_t> failures(connections, 0);
+    vector<thread> clients;
+    atomic<bool> go(false);
+    for (size_t c = 0; c < connections; c++) {
+        clients.emplace_back([&, c] {
+            Client client;
+            if (!client.connectTo(port)) {
+                failures[c]++;
+                return;
+            }
+            SplitMix64 rng(c + 1);
+            latencies[c].reserve(1 << 20);
+            while (!go) this_thread::yield();
+            Stopwatch run;
+            while (run.seconds() < seconds) {
+                size_t i = rng.next() % budgets.size();
+                const string& request = rng.next() % 100 < writePercent ? writes[i] : reads[i];
+                auto start = chrono::steady_clock::now();
+                int status = client.roundTrip(request);
+                auto elapsed = chrono::steady_clock::now() - start;
+                if (status != 200) {
+                    failures[c]++;
+                    if (status < 0) return;
+                    continue;
+                }
+                latencies[c].push_back(static_cast<uint32_t>(chrono::duration_cast<chrono::nanoseconds>(elapsed).count()));
+            }
+        });
+    }
+    Stopwatch wall;
+    go = true;
+    for (thread& t : clients) t.join();
+    double elapsed = wall.seconds();
+
+    vector<uint32_t> all;
+    size_t failed = 0;
+    for (size_t c = 0; c < connections; c++) {
+        all.insert(all.end(), latencies[c].begin(), latencies[c].end());
+        failed += failures[c];
+    }
+    sort(all.begin(), all.end());
+    auto percentile = [&all](double p) {
+        return all.empty() ? 0.0 : all[min(all.size() - 1, static_cast<size_t>(p / 100 * all.size()))] / 1000.0;
+    };
+    printf("%zu connections, %u%% writes: %.0f requests/sec, %zu failed\n", connections, writePercent,
+           all.size() / elapsed, failed);
+    printf("  latency p50 %.1f us  p90 %.1f us  p99 %.1f us  max %.1f us\n", percentile(50), percentile(90),
+           percentile(99), all.empty() ? 0.0 : all.back() / 1000.0);
+
+    if (server) {
+        server->stop();
+        handler.reset();
+        remove("bench_http.tmp");
+        remove("bench_http.tmp.idx");
+    }
+    return 0;
+}
+
+#else
+
+int main() {
+    printf("bench_http needs epoll (Linux)\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,87 @@
+// JSON import throughput: one bulk JSON Lines file and a directory of
+// single-budget exports in the frontend schema, in MB/s and budgets/sec
+#include "FileHandler.h"
+#include "JsonImporter.h"
+#include "BenchSupport.h"
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+// Same layout as the frontend's JSON.stringify(budgetData, null, 2)
+static void writeFrontendJson(const Budget& b, const string& path) {
+    ofstream file(path);
+    file << "{\n  \"user\": {\n    \"name\": \"" << b.getUserName() << "\",\n    \"month\": \"" << b.getMonth() << "\"\n  },\n";
+    file << "  \"income\": {\n    \"salary\": " << b.getSalary() << ",\n    \"freelance\": " << b.getFreelance()
+         << ",\n    \"investments\": " << b.getInvestments() << ",\n    \"other\": " << b.getOtherIncome() << "\n  },\n";
+    file << "  \"expenses\": {";
+    const char* separator = "\n";
+    forEachExpense<&CategoryDescriptor::jsonKey>(b.getAmounts(), [&](string_view key, Money amount) {
+        file << separator << "    \"" << key << "\": " << amount;
+        separator = ",\n";
+    });
+    file << "\n  },\n  \"savingsGoal\": " << b.getSavingsGoal() << "\n}";
+}
+
+static bool sameBudgets(const vector<Budget>& a, const vector<Budget>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].getUserName() != b[i].getUserName() || a[i].getMonth() != b[i].getMonth() ||
+            a[i].getTotalIncome() != b[i].getTotalIncome() || a[i].getTotalExpenses() != b[i].getTotalExpenses() ||
+            a[i].getSavingsGoal() != b[i].getSavingsGoal()) return false;
+    }
+    return true;
+}
+
+static void report(const char* name, uint64_t bytes, size_t records, double seconds) {
+    printf("  %-34s %8.1f MB/s  %10.0f budgets/sec\n", name, bytes / seconds / 1e6, records / seconds);
+}
+
+int main(int argc, char* argv[]) {
+    size_t users = argc > 1 ? stoul(argv[1]) : 2000;
+    size_t months = argc > 2 ? stoul(argv[2]) : 250;
+    size_t fileCount = argc > 3 ? stoul(argv[3]) : 5000;
+
+    vector<Budget> budgets = makeBudgets(users, months);
+    printf("%zu budgets\n", budgets.size());
+
+    JsonExporter exporter;
+    exporter.open("bench_import.jsonl");
+    for (const Budget& b : budgets) exporter.write(b);
+    exporter.close();
+
+    vector<Budget> imported;
+    vector<JsonImportError> errors;
+    imported.reserve(budgets.size());
+    Stopwatch timer;
+    JsonImporter::importFile("bench_import.jsonl", imported, errors);
+    double seconds = timer.seconds();
+    report("bulk JSON Lines file", exporter.getRawBytes(), imported.size(), seconds);
+    if (!errors.empty() || !sameBudgets(budgets, imported)) printf("  MISMATCH in bulk import!\n");
+    remove("bench_import.jsonl");
+
+    // Directory of per-budget frontend exports
+    string dir = "bench_import_dir";
+    filesystem::create_directory(dir);
+    fileCount = min(fileCount, budgets.size());
+    vector<Budget> expected(budgets.begin(), budgets.begin() + fileCount);
+    uint64_t dirBytes = 0;
+    for (size_t i = 0; i < fileCount; i++) {
+        char name[48];
+        snprintf(name, sizeof(name), "/budget%06zu.json", i);
+        writeFrontendJson(expected[i], dir + name);
+        dirBytes += filesystem::file_size(dir + name);
+    }
+
+    for (size_t threads : {size_t(1), ThreadPool::defaultThreadCount()}) {
+        imported.clear();
+        errors.clear();
+        timer.reset();
+        JsonImportSummary summary = JsonImporter::importPath(dir, imported, errors, threads);
+        seconds = timer.seconds();
+        string name = to_string(summary.files) + " files, " + to_string(threads) + " threads";
+        report(name.c_str(), dirBytes, imported.size(), seconds);
+        if (!errors.empty() || !sameBudgets(expected, imported)) printf("  MISMATCH in directory import!\n");
+    }
+    filesystem::remove_all(dir);
+    return 0;
+}
@@ -0,0 +1,63 @@
+// Bulk JSON export vs one FileHandler::exportToJSON call per budget, in MB/s
+#include "FileHandler.h"
+#include "BenchSupport.h"
+#include <cstdio>
+#include <string>
+
+static uint64_t fileSize(const string& path) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) return 0;
+    uint64_t size = streamSize(file);
+    fclose(file);
+    return size;
+}
+
+static void report(const char* name, uint64_t jsonBytes, uint64_t diskBytes, size_t records, double seconds) {
+    printf("  %-34s %8.1f MB/s  %8.0f budgets/sec  %7.1f MB on disk\n", name, jsonBytes / seconds / 1e6,
+           records / seconds, diskBytes / 1e6);
+}
+
+int main(int argc, char* argv[]) {
+    size_t users = argc > 1 ? stoul(argv[1]) : 2000;
+    size_t months = argc > 2 ? stoul(argv[2]) : 250;
+    size_t legacyLimit = argc > 3 ? stoul(argv[3]) : 20000;
+
+    vector<Budget> budgets = makeBudgets(users, months);
+    printf("%zu budgets\n", budgets.size());
+
+    // Current path: one pretty-printed file per budget through iostreams
+    FileHandler handler("bench_json.tmp");
+    size_t legacyCount = min(legacyLimit, budgets.size());
+    uint64_t legacyBytes = 0;
+    Stopwatch timer;
+    for (size_t i = 0; i < legacyCount; i++) {
+        handler.exportToJSON(budgets[i], "bench_json_single.tmp");
+        legacyBytes += fileSize("bench_json_single.tmp");
+    }
+    double legacySeconds = timer.seconds();
+    remove("bench_json_single.tmp");
+    report("exportToJSON per budget", legacyBytes, legacyBytes, legacyCount, legacySeconds);
+
+    vector<pair<const char*, JsonExportOptions>> runs = {
+        {"JsonExporter, JSON Lines", JsonExportOptions(JSON_LINES)},
+        {"JsonExporter, JSON array", JsonExportOptions(JSON_ARRAY)},
+    };
+    if (JsonExporter::gzipAvailable()) {
+        runs.push_back({"JsonExporter, JSON Lines + gzip -1", JsonExportOptions(JSON_LINES, true, 1)});
+        runs.push_back({"JsonExporter, JSON Lines + gzip -6", JsonExportOptions(JSON_LINES, true, 6)});
+    } else {
+        printf("  (gzip runs skipped: built without BUDGET_HAVE_ZLIB)\n");
+    }
+
+    for (const auto& run : runs) {
+        JsonExporter exporter;
+        timer.reset();
+        exporter.open("bench_json_bulk.tmp", run.second);
+        for (const Budget& b : budgets) exporter.write(b);
+        exporter.close();
+        double seconds = timer.seconds();
+        report(run.first, exporter.getRawBytes(), exporter.getOutputBytes(), budgets.size(), seconds);
+    }
+    remove("bench_json_bulk.tmp");
+    return 0;
+}
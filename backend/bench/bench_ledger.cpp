@@ -0,0 +1,139 @@
+// BudgetLedger kernels vs per-object Budget getters: correctness and records/sec
+#include "BudgetLedger.h"
+#include "BenchSupport.h"
+#include <cstdio>
+#include <string>
+
+static const int ROUNDS = 10;
+
+// Compare every kernel result against the Budget methods
+static bool verify(const BudgetLedger& ledger, const vector<Budget>& budgets) {
+    vector<int64_t> income, expenses, balance;
+    ledger.computeTotals(income, expenses, balance);
+    size_t goalsMet = 0;
+    for (size_t i = 0; i < budgets.size(); i++) {
+        const Budget& b = budgets[i];
+        if (income[i] != b.getTotalIncome().getCents() || expenses[i] != b.getTotalExpenses().getCents() ||
+            balance[i] != b.getBalance().getCents()) {
+            printf("  mismatch in totals at record %zu\n", i);
+            return false;
+        }
+        goalsMet += b.isSavingsGoalMet();
+    }
+    if (ledger.countSavingsGoalMet() != goalsMet) {
+        printf("  mismatch in goal count\n");
+        return false;
+    }
+    vector<double> percentages = ledger.savingsPercentages();
+    for (size_t i = 0; i < budgets.size(); i++) {
+        if (percentages[i] != budgets[i].getSavingsPercentage()) {
+            printf("  mismatch in savings percentage at record %zu\n", i);
+            return false;
+        }
+    }
+    for (int c = 0; c < NUM_BUDGET_COLUMNS; c++) {
+        Money sum, low, high;
+        for (size_t i = 0; i < budgets.size(); i++) {
+            Money v = BudgetColumns::get(budgets[i], c);
+            sum += v;
+            if (i == 0 || v < low) low = v;
+            if (i == 0 || v > high) high = v;
+        }
+        BudgetColumn column = static_cast<BudgetColumn>(c);
+        if (ledger.columnSum(column) != sum || ledger.columnMin(column) != low || ledger.columnMax(column) != high) {
+            printf("  mismatch in column %d aggregates\n", c);
+            return false;
+        }
+    }
+    return true;
+}
+
+static void report(const char* name, size_t records, double seconds) {
+    printf("  %-28s %8.2f M records/sec\n", name, records * ROUNDS / seconds / 1e6);
+}
+
+// Kernel throughput for one implementation
+static void runKernels(BudgetLedger& ledger, const LedgerKernels& kernels) {
+    ledger.setKernels(kernels);
+    printf("%s kernels:\n", kernels.name);
+    size_t n = ledger.size();
+    vector<int64_t> income, expenses, balance;
+    volatile int64_t sink = 0;
+
+    Stopwatch timer;
+    for (int r = 0; r < ROUNDS; r++) {
+        ledger.computeTotals(income, expenses, balance);
+        sink = sink + balance[n / 2];
+    }
+    report("per-record totals", n, timer.seconds());
+
+    timer.reset();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int c = 0; c < NUM_BUDGET_COLUMNS; c++) sink = sink + ledger.columnSum(static_cast<BudgetColumn>(c)).getCents();
+    }
+    report("column sums (all columns)", n, timer.seconds());
+
+    timer.reset();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int c = 0; c < NUM_BUDGET_COLUMNS; c++) sink = sink + ledger.columnMax(static_cast<BudgetColumn>(c)).getCents();
+    }
+    report("column min/max (all columns)", n, timer.seconds());
+
+    timer.reset();
+    for (int r = 0; r < ROUNDS; r++) sink = sink + static_cast<int64_t>(ledger.countSavingsGoalMet());
+    report("savings goal count", n, timer.seconds());
+}
+
+int main(int argc, char* argv[]) {
+    size_t users = argc > 1 ? stoul(argv[1]) : 5000;
+    size_t months = argc > 2 ? stoul(argv[2]) : 200;
+
+    vector<Budget> budgets = makeBudgets(users, months);
+    BudgetLedger ledger;
+    ledger.reserve(budgets.size());
+    for (const Budget& b : budgets) ledger.add(b);
+    size_t n = ledger.size();
+    printf("%zu records, best kernels: %s\n\n", n, LedgerKernels::best().name);
+
+    ledger.setKernels(LedgerKernels::scalar());
+    bool ok = verify(ledger, budgets);
+    if (const LedgerKernels* avx2 = LedgerKernels::avx2()) {
+        ledger.setKernels(*avx2);
+        ok = verify(ledger, budgets) && ok;
+    }
+    printf("Results match Budget methods: %s\n\n", ok ? "yes" : "NO");
+
+    volatile int64_t sink = 0;
+    printf("Budget objects:\n");
+    Stopwatch timer;
+    for (int r = 0; r < ROUNDS; r++) {
+        for (const Budget& b : budgets) sink = sink + b.getBalance().getCents();
+    }
+    report("per-record totals", n, timer.seconds());
+
+    timer.reset();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int c = 0; c < NUM_BUDGET_COLUMNS; c++) {
+            Money total;
+            for (const Budget& b : budgets) total += BudgetColumns::get(b, c);
+            sink = sink + total.getCents();
+        }
+    }
+    report("column sums (all columns)", n, timer.seconds());
+
+    timer.reset();
+    for (int r = 0; r < ROUNDS; r++) {
+        size_t met = 0;
+        for (const Budget& b : budgets) met += b.isSavingsGoalMet();
+        sink = sink + static_cast<int64_t>(met);
+    }
+    report("savings goal count", n, timer.seconds());
+    printf("\n");
+
+    runKernels(ledger, LedgerKernels::scalar());
+    if (LedgerKernels::avx2()) {
+        printf("\n");
+        runKernels(ledger, *LedgerKernels::avx2());
+    }
+    return ok ? 0 : 1;
+}
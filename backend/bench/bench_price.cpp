@@ -0,0 +1,98 @@
+// PriceHistory on synthetic price points: encoding size and query latency,
+// checked against a plain (day, price) vector scan
+#include "PriceHistory.h"
+#include "BenchSupport.h"
+#include <cstdio>
+#include <string>
+
+struct RawPoint {
+    uint32_t day;
+    int64_t cents;
+};
+
+int main(int argc, char* argv[]) {
+    size_t itemCount = argc > 1 ? stoul(argv[1]) : 50000;
+    size_t pointsPerItem = argc > 2 ? stoul(argv[2]) : 160;
+    const uint32_t startDate = 20220103;
+
+    SplitMix64 rng(11);
+    PriceHistory history;
+    vector<vector<RawPoint>> raw(itemCount);
+    vector<string> names;
+    for (size_t i = 0; i < itemCount; i++) names.push_back("item-" + to_string(i));
+
+    Stopwatch timer;
+    for (size_t i = 0; i < itemCount; i++) {
+        uint32_t day = DayNumber::fromDate(startDate) + static_cast<uint32_t>(rng.next() % 7);
+        int64_t cents = 100 + static_cast<int64_t>(rng.next() % 2000);
+        for (size_t p = 0; p < pointsPerItem; p++) {
+            day += 1 + static_cast<uint32_t>(rng.next() % 13);
+            cents = max<int64_t>(1, cents + static_cast<int64_t>(rng.next() % 41) - 19);
+            history.add(names[i], DayNumber::toDate(day), Money::fromCents(cents));
+            raw[i].push_back({day, cents});
+        }
+    }
+    double loadSeconds = timer.seconds();
+    size_t points = history.size();
+    printf("%zu items, %zu price points, loaded at %.2f M points/sec\n", itemCount, points, points / loadSeconds / 1e6);
+    printf("  timestamps + block summaries: %.2f bytes/point (raw uint32 days: 4.00)\n\n",
+           static_cast<double>(history.encodedBytes()) / points);
+
+    const uint32_t rangeFrom = 20230101, rangeTo = 20240630;    // 18 months
+    const uint32_t quarterFrom = 20240101, quarterTo = 20240331;
+    uint32_t dayFrom = DayNumber::fromDate(rangeFrom), dayTo = DayNumber::fromDate(rangeTo);
+    const size_t queries = 20000;
+    vector<uint32_t> picks(queries);
+    for (size_t q = 0; q < queries; q++) picks[q] = static_cast<uint32_t>(rng.next() % itemCount);
+
+    // 18-month history of one item
+    size_t visited = 0;
+    timer.reset();
+    for (uint32_t i : picks) history.range(names[i], rangeFrom, rangeTo, [&visited](uint32_t, Money) { visited++; });
+    double rangeSeconds = timer.seconds();
+    size_t rawVisited = 0;
+    timer.reset();
+    for (uint32_t i : picks) {
+        for (const RawPoint& p : raw[i]) rawVisited += p.day >= dayFrom && p.day <= dayTo;
+    }
+    double rawRangeSeconds = timer.seconds();
+    printf("18-month range (%zu queries)   %7.2f us/query   raw scan %7.2f us/query  %s\n", queries,
+           rangeSeconds / queries * 1e6, rawRangeSeconds / queries * 1e6, visited == rawVisited ? "" : "MISMATCH");
+
+    // Min/max over 18 months
+    bool same = true;
+    timer.reset();
+    for (uint32_t i : picks) {
+        Money low, high;
+        history.minMax(names[i], rangeFrom, rangeTo, low, high);
+        visited += static_cast<size_t>(low.getCents());
+    }
+    double minMaxSeconds = timer.seconds();
+    for (size_t q = 0; q < 200; q++) {
+        uint32_t i = picks[q];
+        Money low, high;
+        history.minMax(names[i], rangeFrom, rangeTo, low, high);
+        int64_t lo = numeric_limits<int64_t>::max(), hi = numeric_limits<int64_t>::min();
+        for (const RawPoint& p : raw[i]) {
+            if (p.day >= dayFrom && p.day <= dayTo) {
+                lo = min(lo, p.cents);
+                hi = max(hi, p.cents);
+            }
+        }
+        same = same && low.getCents() == lo && high.getCents() == hi;
+    }
+    printf("18-month min/max               %7.2f us/query  %s\n", minMaxSeconds / queries * 1e6, same ? "" : "MISMATCH");
+
+    // Items that rose more than 10% over a quarter
+    timer.reset();
+    vector<PriceChange> rising = history.risers(quarterFrom, quarterTo, 10);
+    double risersSeconds = timer.seconds();
+    printf("Quarterly risers >10%%          %7.2f ms over %zu items, %zu found\n", risersSeconds * 1e3, itemCount,
+           rising.size());
+    if (!rising.empty()) {
+        const PriceChange& c = rising.front();
+        printf("  e.g. %s: %s -> %s\n", history.itemName(c.itemId).c_str(), c.startPrice.toString().c_str(),
+               c.endPrice.toString().c_str());
+    }
+    return same && visited >= rawVisited ? 0 : 1;
+}
@@ -0,0 +1,123 @@
+// Savings projection: simulates one synthetic user's savings against a
+// goal set at the expected balance, with every kernel and several thread
+// counts. Results must be identical across all of them; a small run is
+// also checked against a plain re-simulation with exact percentiles.
+//   bench_projection [paths] [months] [history months]
+#include "SavingsProjection.h"
+#include "BenchSupport.h"
+
+static bool sameResult(const ProjectionResult& a, const ProjectionResult& b) {
+    if (a.bands.size() != b.bands.size() || a.medianMonths != b.medianMonths) return false;
+    for (size_t m = 0; m < a.bands.size(); m++) {
+        const ProjectionBand& x = a.bands[m];
+        const ProjectionBand& y = b.bands[m];
+        if (x.p10 != y.p10 || x.p25 != y.p25 || x.p50 != y.p50 || x.p75 != y.p75 || x.p90 != y.p90 ||
+            x.reached != y.reached) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Path by path with the same streams, percentiles by sorting
+static size_t checkAgainstPlain(const SavingsModel& model, const ProjectionOptions& options,
+                                const ProjectionResult& result) {
+    size_t months = options.months;
+    vector<vector<int64_t>> balances(months);
+    vector<uint64_t> hits(months);
+    uint32_t n = static_cast<uint32_t>(model.size());
+    for (size_t p = 0; p < options.paths; p++) {
+        uint32_t key = ProjectionRng::pathKey(options.seed, p);
+        int64_t balance = options.start.getCents();
+        bool reached = false;
+        for (size_t m = 0; m < months; m++) {
+            for (int s = 0; s < SavingsModel::SOURCES; s++) {
+                uint32_t counter = ProjectionRng::counterKey(options.seed, static_cast<uint32_t>(m * SavingsModel::SOURCES + s));
+                balance += model.source(s)[ProjectionRng::pick(ProjectionRng::mix(key + counter), n)];
+            }
+            balances[m].push_back(balance);
+            if (!reached && balance >= options.goal.getCents()) {
+                hits[m]++;
+                reached = true;
+            }
+        }
+    }
+
+    size_t errors = 0;
+    uint64_t reached = 0;
+    for (size_t m = 0; m < months; m++) {
+        vector<int64_t>& sorted = balances[m];
+        sort(sorted.begin(), sorted.end());
+        reached += hits[m];
+        if (static_cast<double>(reached) / options.paths != result.bands[m].reached) errors++;
+        // Within two histogram bins of the exact value
+        double twoBins = 4 * 6 * sqrt(model.variance() * (m + 1)) / SavingsProjector::BINS;
+        int64_t exact = sorted[sorted.size() / 2];
+        if (fabs(static_cast<double>(result.bands[m].p50.getCents() - exact)) > twoBins) errors++;
+    }
+    return errors;
+}
+
+int main(int argc, char* argv[]) {
+    size_t paths = argc > 1 ? stoul(argv[1]) : 1000000;
+    size_t months = argc > 2 ? stoul(argv[2]) : 24;
+    size_t historyMonths = argc > 3 ? stoul(argv[3]) : 36;
+
+    vector<Budget> history = makeHistory(HistoryOptions(20, historyMonths));
+    vector<const Budget*> user;
+    for (const Budget& budget : history) {
+        if (budget.getUserName() == history[3].getUserName()) user.push_back(&budget);
+    }
+    SavingsModel model;
+    model.build(user);
+    Money goal = Money::fromCents(llround(model.mean() * months));
+    ProjectionOptions options(goal, months, paths);
+    printf("%zu paths x %zu months from %zu months of history, goal %s (monthly mean %.2f, sd %.2f)\n", paths, months,
+           model.size(), goal.toString().c_str(), model.mean() / 100, sqrt(model.variance()) / 100);
+
+    size_t failures = 0;
+    ProjectionResult reference;
+    vector<const ProjectionKernels*> kernels = {&ProjectionKernels::scalar()};
+    if (const ProjectionKernels* avx2 = ProjectionKernels::avx2()) kernels.push_back(avx2);
+    for (const ProjectionKernels* kernel : kernels) {
+        SavingsProjector projector(1);
+        projector.setKernels(*kernel);
+        ProjectionResult result;
+        Stopwatch watch;
+        projector.project(model, options, result);
+        double seconds = watch.seconds();
+        if (kernel == kernels.front()) reference = result;
+        else if (!sameResult(result, reference)) failures++;
+        printf("  %-8s 1 thread   %7.1f ms  %6.2f M paths/s  %7.1f M draws/s\n", kernel->name, seconds * 1e3,
+               paths / seconds / 1e6, paths * months * SavingsModel::SOURCES / seconds / 1e6);
+    }
+
+    size_t hardware = ThreadPool::defaultThreadCount();
+    for (size_t threads : {size_t(2), size_t(3), hardware}) {
+        SavingsProjector projector(threads);
+        ProjectionResult result;
+        Stopwatch watch;
+        projector.project(model, options, result);
+        double seconds = watch.seconds();
+        bool same = sameResult(result, reference);
+        if (!same) failures++;
+        printf("  %-8s %zu threads %7.1f ms  %6.2f M paths/s  %s\n", projector.getKernels().name, threads,
+               seconds * 1e3, paths / seconds / 1e6, same ? "identical" : "DIFFERENT");
+    }
+
+    const ProjectionBand& last = reference.bands.back();
+    printf("  P(goal within %zu months) %.4f, median months %zu\n", months, reference.probability,
+           reference.medianMonths);
+    printf("  final balance p10 %s  p25 %s  p50 %s  p75 %s  p90 %s\n", last.p10.toString().c_str(),
+           last.p25.toString().c_str(), last.p50.toString().c_str(), last.p75.toString().c_str(),
+           last.p90.toString().c_str());
+
+    ProjectionOptions small(goal, months, 20000, 7);
+    SavingsProjector projector;
+    ProjectionResult result;
+    projector.project(model, small, result);
+    size_t mismatches = checkAgainstPlain(model, small, result);
+    printf("  plain re-simulation of %zu paths: %zu mismatches\n", small.paths, mismatches);
+    failures += mismatches;
+    return failures == 0 ? 0 : 1;
+}
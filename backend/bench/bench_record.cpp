@@ -0,0 +1,58 @@
+// Budget vs BudgetRecord: object size, allocations per load and load time
+#define BENCH_COUNT_ALLOCATIONS
+#include "FileHandler.h"
+#include "BenchSupport.h"
+#include <cstdio>
+
+int main(int argc, char* argv[]) {
+    size_t users = argc > 1 ? stoul(argv[1]) : 2000;
+    size_t months = argc > 2 ? stoul(argv[2]) : 120;
+    string path = "bench_record.tmp";
+
+    {
+        remove(path.c_str());
+        FileHandler writer(path);
+        writer.saveBudgets(makeBudgets(users, months));
+    }
+
+    printf("sizeof(Budget)       = %zu bytes\n", sizeof(Budget));
+    printf("sizeof(BudgetRecord) = %zu bytes\n", sizeof(BudgetRecord));
+
+    FileHandler handler(path);
+    size_t before = allocationCount;
+    Stopwatch timer;
+    vector<Budget> budgets = handler.loadBudgets();
+    double budgetSeconds = timer.seconds();
+    size_t budgetAllocs = allocationCount - before;
+
+    before = allocationCount;
+    timer.reset();
+    vector<Budget> budgetCopy = budgets;
+    double budgetCopySeconds = timer.seconds();
+    size_t budgetCopyAllocs = allocationCount - before;
+
+    BudgetRecordSet records;
+    before = allocationCount;
+    timer.reset();
+    handler.loadRecords(records);
+    double recordSeconds = timer.seconds();
+    size_t recordAllocs = allocationCount - before;
+
+    before = allocationCount;
+    timer.reset();
+    vector<BudgetRecord> recordCopy = records.records;
+    double recordCopySeconds = timer.seconds();
+    size_t recordCopyAllocs = allocationCount - before;
+
+    size_t n = budgets.size();
+    printf("%zu records\n", n);
+    printf("%-22s %10s %14s %12s\n", "", "load (s)", "allocs/record", "copy (ms)");
+    printf("%-22s %10.3f %14.2f %12.2f (%zu allocs)\n", "vector<Budget>", budgetSeconds,
+           double(budgetAllocs) / n, budgetCopySeconds * 1000, budgetCopyAllocs);
+    printf("%-22s %10.3f %14.2f %12.2f (%zu allocs)\n", "BudgetRecordSet", recordSeconds,
+           double(recordAllocs) / n, recordCopySeconds * 1000, recordCopyAllocs);
+
+    remove(path.c_str());
+    remove(BudgetIndex::sidecarPathFor(path).c_str());
+    return 0;
+}
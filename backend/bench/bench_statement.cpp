@@ -0,0 +1,83 @@
+// Statement import throughput: writes a synthetic bank statement with
+// quoted, comma and multi-line descriptions, imports it with one thread and
+// with all of them, checks both give the same budgets and reports
+// transactions per second.
+//   bench_statement [transactions] [users] [threads]
+#include "StatementImporter.h"
+#include "BenchSupport.h"
+#include <cstdio>
+
+static const char* const MERCHANTS[] = {
+    "WHOLE FOODS MARKET #%u", "TRADER JOE'S %u", "SHELL OIL %u", "UBER *TRIP %u", "NETFLIX.COM", "AMAZON MKTPLACE PMTS",
+    "\"CVS/PHARMACY, STORE %u\"", "COMCAST CABLE", "PAYROLL ACME CORP", "\"COFFEE \"\"BAR\"\" %u\"",
+    "\"TRANSFER\nREF %u\"", "RENT PROPERTY MANAGEMENT", "DIVIDEND VTSAX", "LOCAL DINER %u"};
+
+static const char* const RULES =
+    "salary: payroll\n"
+    "investments: dividend\n"
+    "rent: property management\n"
+    "groceries: whole foods, trader joe\n"
+    "utilities: comcast\n"
+    "transportation: shell, uber\n"
+    "entertainment: netflix\n"
+    "healthcare: pharmacy\n"
+    "shopping: amazon\n";
+
+static bool writeStatement(const string& path, size_t transactions, size_t users) {
+    FILE* out = fopen(path.c_str(), "wb");
+    if (!out) return false;
+    SplitMix64 rng(17);
+    fputs("Date,Description,Amount,Account\n", out);
+    char description[96];
+    for (size_t i = 0; i < transactions; i++) {
+        unsigned merchant = static_cast<unsigned>(rng.next() % (sizeof(MERCHANTS) / sizeof(MERCHANTS[0])));
+        snprintf(description, sizeof(description), MERCHANTS[merchant], static_cast<unsigned>(rng.next() % 1000));
+        int64_t cents = static_cast<int64_t>(rng.next() % 20000) + 1;
+        bool credit = merchant == 8 || merchant == 12;
+        fprintf(out, "2024-%02u-%02u,%s,%s%lld.%02lld,user%zu\n", static_cast<unsigned>(i * 12 / transactions + 1),
+                static_cast<unsigned>(rng.next() % 28 + 1), description, credit ? "" : "-",
+                static_cast<long long>(cents * (credit ? 20 : 1) / 100), static_cast<long long>(cents % 100),
+                static_cast<size_t>(rng.next() % users));
+    }
+    return fclose(out) == 0;
+}
+
+int main(int argc, char* argv[]) {
+    size_t transactions = argc > 1 ? stoul(argv[1]) : 4000000;
+    size_t users = argc > 2 ? stoul(argv[2]) : 50;
+    size_t threads = argc > 3 ? stoul(argv[3]) : ThreadPool::defaultThreadCount();
+    const string path = "bench_statement.tmp";
+    if (!writeStatement(path, transactions, users)) return 1;
+
+    CategoryRules rules;
+    rules.loadText(RULES);
+    StatementImporter importer(rules);
+
+    vector<Budget> serial, parallel;
+    StatementSummary serialSummary, summary;
+    if (!importer.importFile(path, "", serial, serialSummary, 1)) return 1;
+    if (!importer.importFile(path, "", parallel, summary, threads)) return 1;
+    remove(path.c_str());
+
+    size_t mismatches = serial.size() == parallel.size() ? 0 : 1;
+    for (size_t i = 0; i < serial.size() && i < parallel.size(); i++) {
+        if (serial[i].getUserName() != parallel[i].getUserName() || serial[i].getMonth() != parallel[i].getMonth()) {
+            mismatches++;
+            continue;
+        }
+        for (int col = 0; col < NUM_BUDGET_COLUMNS; col++) {
+            if (BudgetColumns::get(serial[i], col) != BudgetColumns::get(parallel[i], col)) mismatches++;
+        }
+    }
+    if (serialSummary.transactions != summary.transactions || summary.rejected != 0) mismatches++;
+
+    printf("%zu transactions, %.1f MB, %zu rules (%zu automaton states)\n", transactions, summary.bytes / 1e6,
+           rules.size(), rules.stateCount());
+    printf("  1 thread   %10.0f tx/sec (%zu chunks)\n", serialSummary.transactions / serialSummary.seconds,
+           serialSummary.chunks);
+    printf("  %zu threads %10.0f tx/sec (%zu chunks), %.0f MB/s\n", threads, summary.transactions / summary.seconds,
+           summary.chunks, summary.bytes / summary.seconds / 1e6);
+    printf("  %llu categorized, %zu budgets, %zu mismatches between runs\n",
+           static_cast<unsigned long long>(summary.categorized), parallel.size(), mismatches);
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,139 @@
+// Stress run for BudgetStore: N reader threads check snapshots while M
+// writer threads save budgets, then the log is replayed into a fresh store
+// and compared with the final state. Reports reads and writes per second.
+//   bench_store [readers] [writers] [seconds] [users]
+#include "BudgetStore.h"
+#include "BenchSupport.h"
+#include <cstdio>
+#include <map>
+#include <string>
+
+static const char* const MONTHS[] = {"January 2024", "February 2024", "March 2024", "April 2024",
+                                     "May 2024", "June 2024", "July 2024", "August 2024",
+                                     "September 2024", "October 2024", "November 2024", "December 2024"};
+
+static uint64_t mix(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xFF51AFD7ED558CCDULL;
+    x ^= x >> 33;
+    return x;
+}
+
+// Every field is derived from (user, month, version) so a torn or mixed
+// record fails verify()
+static Budget makeVersion(size_t user, size_t month, uint64_t version) {
+    Budget b("user" + to_string(user), MONTHS[month]);
+    uint64_t key = mix(user * 131 + month) ^ version;
+    b.setSalary(Money::fromCents(static_cast<int64_t>(version)));
+    b.setFreelance(Money::fromCents(static_cast<int64_t>(mix(key) % 10000000)));
+    for (const CategoryDescriptor& c : EXPENSE_CATEGORIES) {
+        b.setExpense(c.id, Money::fromCents(static_cast<int64_t>(mix(key + c.id + 1) % 1000000)));
+    }
+    b.setSavingsGoal(Money::fromCents(static_cast<int64_t>(mix(key + 99) % 1000000)));
+    return b;
+}
+
+static bool verify(const Budget& b, size_t user, size_t month) {
+    Budget expected = makeVersion(user, month, static_cast<uint64_t>(b.getSalary().getCents()));
+    if (b.getFreelance() != expected.getFreelance() || b.getSavingsGoal() != expected.getSavingsGoal()) return false;
+    for (const CategoryDescriptor& c : EXPENSE_CATEGORIES) {
+        if (b.getExpense(c.id) != expected.getExpense(c.id)) return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    size_t readers = argc > 1 ? stoul(argv[1]) : 4;
+    size_t writers = argc > 2 ? stoul(argv[2]) : 2;
+    double seconds = argc > 3 ? stod(argv[3]) : 3;
+    size_t users = argc > 4 ? stoul(argv[4]) : 1000;
+    const string logPath = "bench_store.tmp";
+    remove(logPath.c_str());
+
+    BudgetStore store;
+    if (!store.open(logPath)) return 1;
+
+    atomic<bool> stop(false);
+    atomic<size_t> errors(0);
+    vector<size_t> reads(readers, 0), writes(writers, 0);
+    vector<thread> threads;
+
+    for (size_t w = 0; w < writers; w++) {
+        threads.emplace_back([&, w] {
+            SplitMix64 rng(1000 + w);
+            uint64_t counter = 1;
+            while (!stop) {
+                size_t user = rng.next() % users;
+                size_t month = rng.next() % 12;
+                // Unique per writer, so every saved version is distinct
+                if (!store.put(makeVersion(user, month, counter++ * writers + w))) errors++;
+                writes[w]++;
+            }
+        });
+    }
+    for (size_t r = 0; r < readers; r++) {
+        threads.emplace_back([&, r] {
+            SplitMix64 rng(r + 1);
+            uint64_t lastSequence = 0;
+            while (!stop) {
+                BudgetSnapshot view = store.snapshot();
+                if (view.sequence() < lastSequence) errors++;
+                lastSequence = view.sequence();
+                for (int k = 0; k < 16; k++) {
+                    size_t user = rng.next() % users;
+                    size_t month = rng.next() % 12;
+                    const Budget* b = view.find("user" + to_string(user), MONTHS[month]);
+                    if (b && !verify(*b, user, month)) errors++;
+                }
+                reads[r] += 16;
+                // Now and then walk the whole snapshot: its count must match
+                if (rng.next() % 256 == 0) {
+                    size_t count = 0;
+                    view.forEach([&count](const Budget&) { count++; });
+                    if (count != view.size()) errors++;
+                }
+            }
+        });
+    }
+
+    Stopwatch timer;
+    while (timer.seconds() < seconds) this_thread::sleep_for(chrono::milliseconds(10));
+    stop = true;
+    for (thread& t : threads) t.join();
+    double elapsed = timer.seconds();
+
+    size_t totalReads = 0, totalWrites = 0;
+    for (size_t n : reads) totalReads += n;
+    for (size_t n : writes) totalWrites += n;
+    printf("%zu readers, %zu writers, %zu users, %zu shards\n", readers, writers, users, store.getShardCount());
+    printf("  reads   %10.0f lookups/sec\n", totalReads / elapsed);
+    printf("  writes  %10.0f saves/sec (%zu saves, %zu versions awaiting reclaim)\n", totalWrites / elapsed,
+           totalWrites, store.pendingReclaim());
+
+    // Replaying the log must give back exactly the final state
+    map<pair<string, string>, int64_t> final;
+    uint64_t sequence;
+    {
+        BudgetSnapshot view = store.snapshot();
+        sequence = view.sequence();
+        view.forEach([&final](const Budget& b) { final[{b.getUserName(), b.getMonth()}] = b.getSalary().getCents(); });
+    }
+    store.close();
+    BudgetStore replayed;
+    if (!replayed.open(logPath)) return 1;
+    size_t mismatches = 0;
+    {
+        BudgetSnapshot view = replayed.snapshot();
+        if (view.sequence() != sequence || view.size() != final.size()) mismatches++;
+        for (const auto& entry : final) {
+            const Budget* b = view.find(entry.first.first, entry.first.second);
+            if (!b || b->getSalary().getCents() != entry.second) mismatches++;
+        }
+    }
+    replayed.close();
+    remove(logPath.c_str());
+    remove((logPath + ".lock").c_str());
+
+    printf("  integrity: %zu bad reads, %zu replay mismatches over %zu budgets\n", errors.load(), mismatches, final.size());
+    return errors == 0 && mismatches == 0 ? 0 : 1;
+}
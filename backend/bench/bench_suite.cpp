@@ -0,0 +1,135 @@
+// Regression suite: times the main budget paths on a synthetic history and
+// prints one JSON report (ns/op, allocations/op, bytes/op) for comparing
+// builds. Progress goes to stderr, the report to stdout or a file.
+//   bench_suite [users] [months] [seconds per benchmark] [report.json] [name filter]
+#define BENCH_COUNT_ALLOCATIONS
+#include "AggregationEngine.h"
+#include "FileHandler.h"
+#include "ReportRenderer.h"
+#include "BenchSupport.h"
+#include <cstdio>
+
+int main(int argc, char* argv[]) {
+    HistoryOptions options(argc > 1 ? stoul(argv[1]) : 2000, argc > 2 ? stoul(argv[2]) : 24);
+    double seconds = argc > 3 ? stod(argv[3]) : 0.5;
+    string reportPath = argc > 4 ? argv[4] : "-";
+    BenchSuite suite(seconds, argc > 5 ? argv[5] : "");
+
+    vector<Budget> history = makeHistory(options);
+    const string textPath = "bench_suite.tmp";
+    const string columnarPath = "bench_suite.bgtc.tmp";
+    const string jsonPath = "bench_suite.jsonl.tmp";
+    remove(textPath.c_str());
+    remove((textPath + ".idx").c_str());
+    remove(columnarPath.c_str());
+    fprintf(stderr, "%zu budgets (%zu users x %zu months)\n", history.size(), options.users, options.months);
+
+    // Writes append to a scratch file that is reset between runs
+    const size_t saveBatch = min<size_t>(history.size(), 1000);
+    suite.run("save_budget", saveBatch, [&] {
+        remove(textPath.c_str());
+        FileHandler handler(textPath);
+        for (size_t i = 0; i < saveBatch; i++) handler.saveBudget(history[i]);
+    });
+    suite.run("save_budgets_group_commit", history.size(), [&] {
+        remove(textPath.c_str());
+        FileHandler handler(textPath);
+        handler.saveBudgets(history);
+    });
+
+    remove(textPath.c_str());
+    FileHandler text(textPath);
+    text.saveBudgets(history);
+    text.flush();
+    FileHandler columnar(columnarPath, COLUMNAR_FORMAT);
+    columnar.saveBudgets(history);
+
+    size_t loaded = 0;
+    suite.run("load_budgets_text", history.size(), [&] { loaded = text.loadBudgets().size(); });
+    suite.run("load_budgets_columnar", history.size(), [&] { loaded += columnar.loadBudgets().size(); });
+    suite.run("for_each_budget_text", history.size(), [&] {
+        text.forEachBudget([&loaded](const Budget&) { loaded++; });
+    });
+    size_t checkpointed = 0;
+    uint64_t covered = 0;
+    text.writeCheckpoint(checkpointed, covered);
+    suite.run("load_budgets_checkpoint", history.size(), [&] { loaded += text.loadBudgets().size(); });
+    suite.run("open_checkpoint", 1, [&] {
+        Checkpoint checkpoint;
+        loaded += checkpoint.open(textPath);
+    });
+    Checkpoint::removeAll(textPath);
+    text.rebuildIndex();
+    suite.run("find_budget_indexed", 1000, [&] {
+        Budget found;
+        for (size_t i = 0; i < 1000; i++) {
+            const Budget& want = history[(i * 7919) % history.size()];
+            if (text.findBudget(want.getUserName(), want.getMonth(), found)) loaded++;
+        }
+    });
+
+    suite.run("export_to_json_single", 100, [&] {
+        for (size_t i = 0; i < 100; i++) text.exportToJSON(history[i % history.size()], jsonPath);
+    });
+    suite.run("export_all_to_jsonl", history.size(), [&] {
+        if (text.exportAllToJSON(jsonPath, JsonExportOptions::forPath(jsonPath)) < 0) loaded = 0;
+    });
+
+    Money total;
+    suite.run("expense_breakdown", history.size(), [&] {
+        for (const Budget& b : history) {
+            for (const ExpenseItem& item : b.getExpenseBreakdown()) total += item.amount;
+        }
+    });
+    suite.run("budget_totals", history.size(), [&] {
+        for (const Budget& b : history) total += b.getBalance() + b.getSavings();
+    });
+
+    // Reports are rewritten in place so only rendering and write() are timed
+    const string renderPath = "bench_suite.report.tmp";
+    FILE* reportFile = fopen(renderPath.c_str(), "wb");
+    const char* const reportNames[] = {"render_report_text", "render_report_csv", "render_report_markdown"};
+    for (int f = REPORT_TEXT; f <= REPORT_MARKDOWN; f++) {
+        suite.run(reportNames[f], history.size(), [&] {
+            fseek(reportFile, 0, SEEK_SET);
+            ReportRenderer report(reportFile, static_cast<ReportFormat>(f));
+            for (const Budget& b : history) report.add(b);
+            loaded += report.finish();
+        });
+    }
+    fclose(reportFile);
+    remove(renderPath.c_str());
+
+    BudgetLedger ledger;
+    for (const Budget& b : history) ledger.add(b);
+    suite.run("ledger_build", history.size(), [&] {
+        BudgetLedger fresh;
+        for (const Budget& b : history) fresh.add(b);
+        loaded += fresh.size();
+    });
+    AggregationEngine serial(1);
+    suite.run("aggregate_1_thread", ledger.size(), [&] { loaded += serial.aggregate(ledger).users.size(); });
+    AggregationEngine parallel;
+    suite.run("aggregate_all_threads", ledger.size(), [&] { loaded += parallel.aggregate(ledger).users.size(); });
+
+    remove(textPath.c_str());
+    remove((textPath + ".idx").c_str());
+    remove(columnarPath.c_str());
+    remove(jsonPath.c_str());
+
+    // Keep the results observable so the loops are not optimized away
+    fprintf(stderr, "checksum %zu %lld\n", loaded, static_cast<long long>(total.getCents()));
+
+    char config[160];
+    snprintf(config, sizeof(config), "\"users\": %zu, \"months\": %zu, \"seed\": %llu, \"budgets\": %zu, \"threads\": %zu",
+             options.users, options.months, static_cast<unsigned long long>(options.seed), history.size(),
+             ThreadPool::defaultThreadCount());
+    FILE* out = reportPath == "-" ? stdout : fopen(reportPath.c_str(), "w");
+    if (!out) {
+        fprintf(stderr, "Could not write %s\n", reportPath.c_str());
+        return 1;
+    }
+    suite.writeJson(out, config);
+    if (out != stdout) fclose(out);
+    return 0;
+}
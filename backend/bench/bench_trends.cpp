@@ -0,0 +1,117 @@
+// Trend engine: streams a synthetic history month by month, reports
+// ingestion throughput and checks the rolling windows against a brute
+// force recomputation, the P-squared medians against exact ones and the
+// next-month forecasts, each method and the one selected per series,
+// against the naive "same as last month" guess on the final month.
+//   bench_trends [users] [months] [runs]
+#include "TrendEngine.h"
+#include "BenchSupport.h"
+#include <array>
+#include <map>
+
+// Series values of a budget, as the engine derives them
+static void seriesOf(const Budget& b, int64_t* values) {
+    int64_t spending = 0;
+    for (int c = 0; c < NUM_EXPENSE_CATEGORIES; c++) {
+        values[c] = b.getExpense(static_cast<ExpenseCategory>(c)).getCents();
+        spending += values[c];
+    }
+    values[SERIES_SPENDING] = spending;
+    values[SERIES_SAVINGS] = b.getBalance().getCents();
+}
+
+int main(int argc, char* argv[]) {
+    HistoryOptions options(argc > 1 ? stoul(argv[1]) : 20000, argc > 2 ? stoul(argv[2]) : 60);
+    size_t runs = argc > 3 ? stoul(argv[3]) : 3;
+    if (options.months < 2) return 1;
+    vector<Budget> history = makeHistory(options);
+    printf("%zu budgets (%zu users x %zu months)\n", history.size(), options.users, options.months);
+
+    double fastest = 1e30;
+    for (size_t r = 0; r < runs; r++) {
+        TrendEngine engine;
+        Stopwatch watch;
+        for (const Budget& budget : history) engine.add(budget);
+        fastest = min(fastest, watch.seconds());
+    }
+    printf("  ingest          %6.1f M budgets/s (%.0f ns each)\n", history.size() / fastest / 1e6,
+           fastest / history.size() * 1e9);
+
+    // Re-saving each user's latest month is the O(1) correction path
+    TrendEngine engine;
+    for (const Budget& budget : history) engine.add(budget);
+    size_t latest = history.size() - options.users;
+    Stopwatch watch;
+    for (size_t i = latest; i < history.size(); i++) engine.add(history[i]);
+    double resave = watch.seconds();
+    printf("  re-save latest  %6.1f M budgets/s, %zu users tracked\n", options.users / resave / 1e6, engine.size());
+
+    // Everything but the final month, so the forecasts can be scored
+    TrendEngine held;
+    for (size_t i = 0; i < latest; i++) held.add(history[i]);
+
+    map<string, vector<array<int64_t, NUM_TREND_SERIES>>> series;
+    for (size_t i = 0; i < latest; i++) {
+        array<int64_t, NUM_TREND_SERIES> values;
+        seriesOf(history[i], values.data());
+        series[history[i].getUserName()].push_back(values);
+    }
+
+    size_t windowErrors = 0;
+    double medianError = 0, medianScale = 0;
+    double naiveError = 0, methodErrors[NUM_FORECAST_METHODS] = {}, chosenError = 0;
+    size_t checked = 0;
+    for (size_t i = latest; i < history.size(); i++) {
+        const string& user = history[i].getUserName();
+        const vector<array<int64_t, NUM_TREND_SERIES>>& past = series[user];
+        array<int64_t, NUM_TREND_SERIES> actual;
+        seriesOf(history[i], actual.data());
+        for (int s = 0; s < NUM_TREND_SERIES; s++) {
+            SeriesTrend t;
+            if (!held.trend(user, s, t)) {
+                windowErrors++;
+                continue;
+            }
+            for (int w = 0; w < 3; w++) {
+                size_t n = min<size_t>(past.size(), TrendEngine::WINDOWS[w]);
+                double sum = 0, squares = 0;
+                for (size_t k = past.size() - n; k < past.size(); k++) {
+                    sum += past[k][s];
+                    squares += static_cast<double>(past[k][s]) * past[k][s];
+                }
+                double sd = n > 1 ? sqrt(max(0.0, (squares - sum * sum / n) / (n - 1))) : 0;
+                if (llabs(t.windows[w].mean.getCents() - llround(sum / n)) > 1 ||
+                    llabs(t.windows[w].stddev.getCents() - llround(sd)) > 1) {
+                    windowErrors++;
+                }
+            }
+
+            vector<int64_t> sorted;
+            for (const auto& values : past) sorted.push_back(values[s]);
+            sort(sorted.begin(), sorted.end());
+            double exact = sorted[(sorted.size() - 1) / 2];
+            medianError += fabs(t.median.getCents() - exact);
+            medianScale += fabs(static_cast<double>(sorted.back() - sorted.front()));
+
+            for (int f = 0; f < NUM_FORECAST_METHODS; f++) {
+                methodErrors[f] += fabs(t.forecasts[f].getCents() - static_cast<double>(actual[s]));
+            }
+            chosenError += fabs(t.forecast().getCents() - static_cast<double>(actual[s]));
+            naiveError += fabs(t.latest.getCents() - static_cast<double>(actual[s]));
+            checked++;
+        }
+    }
+
+    printf("  windows         %zu mismatches against brute force\n", windowErrors);
+    printf("  P2 median       mean error %.2f%% of the series range\n",
+           medianScale > 0 ? medianError / medianScale * 100 : 0.0);
+    printf("  forecast MAE    naive $%.2f", naiveError / checked / 100);
+    for (int f = 0; f < NUM_FORECAST_METHODS; f++) {
+        if (f == FORECAST_SEASONAL && options.months <= TrendEngine::HISTORY_MONTHS) continue;
+        printf(", %s $%.2f", string(forecastMethodName(static_cast<ForecastMethod>(f))).c_str(),
+               methodErrors[f] / checked / 100);
+    }
+    printf(", selected $%.2f\n", chosenError / checked / 100);
+    printf("  memory          %zu bytes of state per user\n", TrendEngine::bytesPerUser());
+    return windowErrors == 0 ? 0 : 1;
+}
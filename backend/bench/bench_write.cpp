@@ -0,0 +1,59 @@
+// Write-path benchmark: legacy per-record ofstream vs the group-commit writer
+#include "FileHandler.h"
+#include "BenchSupport.h"
+#include <cstdio>
+
+// The original saveBudget: open, 17 flushing endl's, close
+static bool legacySave(const string& filename, const Budget& budget) {
+    ofstream file(filename, ios::app);
+    if (!file.is_open()) return false;
+    file << "USER:" << budget.getUserName() << endl;
+    file << "MONTH:" << budget.getMonth() << endl;
+    for (int c = 0; c < NUM_BUDGET_COLUMNS; c++) {
+        file << BudgetWriter::key(c) << ":" << BudgetColumns::get(budget, c) << endl;
+    }
+    file << "---" << endl;
+    return true;
+}
+
+static void report(const string& name, size_t records, double seconds) {
+    printf("%-36s %10.0f records/sec\n", name.c_str(), records / seconds);
+}
+
+int main(int argc, char* argv[]) {
+    size_t records = argc > 1 ? stoul(argv[1]) : 100000;
+    string path = "bench_write.tmp";
+    vector<Budget> budgets = makeBudgets(1000, (records + 999) / 1000);
+    budgets.resize(records);
+
+    remove(path.c_str());
+    Stopwatch timer;
+    for (const Budget& b : budgets) legacySave(path, b);
+    report("legacy ofstream per record", records, timer.seconds());
+
+    struct Case { const char* name; WriterOptions options; bool bulk; };
+    Case cases[] = {
+        {"saveBudget, batch 1", WriterOptions(1), false},
+        {"saveBudget, batch 256 / 10 ms", WriterOptions(256, chrono::milliseconds(10)), false},
+        {"saveBudget, batch 256 + fdatasync", WriterOptions(256, chrono::milliseconds(10), DURABILITY_FDATASYNC), false},
+        {"saveBudgets bulk", WriterOptions(1), true},
+        {"saveBudgets bulk + fdatasync", WriterOptions(1, chrono::milliseconds(0), DURABILITY_FDATASYNC), true},
+    };
+
+    for (const Case& c : cases) {
+        remove(path.c_str());
+        FileHandler handler(path);
+        handler.setWriterOptions(c.options);
+        timer.reset();
+        if (c.bulk) {
+            handler.saveBudgets(budgets);
+        } else {
+            for (const Budget& b : budgets) handler.saveBudget(b);
+        }
+        handler.flush();
+        report(c.name, records, timer.seconds());
+    }
+
+    remove(path.c_str());
+    return 0;
+}
@@ -6,7 +6,7 @@ $BUILD_DIR = "build"
 $DATA_DIR = "../data"
 $TARGET = "$BUILD_DIR/budget_tracker.exe"
 $SOURCES = "src/main.cpp"
-$CXXFLAGS = "-std=c++17 -Wall -Wextra -I./src"
+$CXXFLAGS = "-std=c++17 -Wall -Wextra -pthread -I./src"
 
 # Kill running instance if exists
 $PROCESS_NAME = "budget_tracker"
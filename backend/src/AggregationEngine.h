@@ -0,0 +1,142 @@
+#ifndef AGGREGATIONENGINE_H
+#define AGGREGATIONENGINE_H
+
+#include "BudgetLedger.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <utility>
+
+// Distribution of one expense category within a group
+struct CategoryStats {
+    Money sum;
+    Money mean;     // rounded to the nearest cent
+    Money min;
+    Money max;
+    Money p50;      // nearest-rank percentiles
+    Money p90;
+    Money p99;
+};
+
+// Per-user or per-month rollup of every expense category
+struct Rollup {
+    uint32_t key;       // user or month id in the ledger dictionaries
+    size_t records;
+    CategoryStats categories[NUM_EXPENSE_CATEGORIES];
+
+    const CategoryStats& category(BudgetColumn c) const { return categories[columnCategory(c)]; }
+};
+
+// Rollups indexed by ledger user id and month id
+struct AggregationResult {
+    vector<Rollup> users;
+    vector<Rollup> months;
+};
+
+// Parallel rollups over a BudgetLedger. Records are partitioned by a hash
+// of the group key: scatter tasks each fill their own bucket per partition,
+// then one task per partition owns every group that hashes to it and writes
+// only that group's result slot, so partials merge without locks. Results
+// do not depend on the thread count.
+class AggregationEngine {
+private:
+    static constexpr size_t TASKS_PER_THREAD = 4;
+    static constexpr size_t MIN_CHUNK_RECORDS = 16384;
+
+    ThreadPool pool;
+
+    size_t partitionOf(uint32_t key, size_t partitions) const {
+        uint64_t hash = key * 0x9E3779B97F4A7C15ULL;
+        return static_cast<size_t>((hash >> 32) % partitions);
+    }
+
+    static Money mean(int64_t sum, size_t count) {
+        int64_t n = static_cast<int64_t>(count);
+        return Money::fromCents((sum >= 0 ? sum + n / 2 : sum - n / 2) / n);
+    }
+
+    // Nearest-rank percentile of sorted values
+    static Money percentile(const vector<int64_t>& sorted, int pct) {
+        size_t rank = (sorted.size() * pct + 99) / 100;
+        return Money::fromCents(sorted[rank == 0 ? 0 : rank - 1]);
+    }
+
+    static void summarize(vector<int64_t>& values, CategoryStats& stats) {
+        int64_t sum = 0;
+        for (int64_t v : values) sum += v;
+        sort(values.begin(), values.end());
+        stats.sum = Money::fromCents(sum);
+        stats.mean = mean(sum, values.size());
+        stats.min = Money::fromCents(values.front());
+        stats.max = Money::fromCents(values.back());
+        stats.p50 = percentile(values, 50);
+        stats.p90 = percentile(values, 90);
+        stats.p99 = percentile(values, 99);
+    }
+
+public:
+    // threads 0 means one per hardware thread
+    explicit AggregationEngine(size_t threads = 0) : pool(threads) {}
+
+    size_t getThreadCount() const { return pool.size(); }
+
+    // Rollup of the expense columns grouped by keys[i], keys in [0, keyCount)
+    vector<Rollup> rollup(const BudgetLedger& ledger, const vector<uint32_t>& keys, size_t keyCount) {
+        vector<Rollup> result(keyCount);
+        for (size_t k = 0; k < keyCount; k++) {
+            result[k] = Rollup();
+            result[k].key = static_cast<uint32_t>(k);
+        }
+        size_t n = keys.size();
+        if (n == 0) return result;
+
+        size_t partitions = pool.size() * TASKS_PER_THREAD;
+        size_t chunks = min(partitions, (n + MIN_CHUNK_RECORDS - 1) / MIN_CHUNK_RECORDS);
+
+        // Scatter: chunk c writes only buckets[c * partitions + p]
+        vector<vector<uint32_t>> buckets(chunks * partitions);
+        pool.parallelFor(chunks, [&](size_t chunk) {
+            size_t begin = n * chunk / chunks;
+            size_t end = n * (chunk + 1) / chunks;
+            vector<uint32_t>* own = &buckets[chunk * partitions];
+            for (size_t i = begin; i < end; i++) {
+                own[partitionOf(keys[i], partitions)].push_back(static_cast<uint32_t>(i));
+            }
+        });
+
+        // Reduce: partition p owns every key that hashes to it
+        pool.parallelFor(partitions, [&](size_t p) {
+            vector<pair<uint32_t, uint32_t>> members;
+            for (size_t chunk = 0; chunk < chunks; chunk++) {
+                for (uint32_t i : buckets[chunk * partitions + p]) members.emplace_back(keys[i], i);
+            }
+            sort(members.begin(), members.end());
+
+            vector<int64_t> values;
+            for (size_t begin = 0; begin < members.size();) {
+                size_t end = begin;
+                while (end < members.size() && members[end].first == members[begin].first) end++;
+
+                Rollup& group = result[members[begin].first];
+                group.records = end - begin;
+                for (int c = 0; c < NUM_EXPENSE_CATEGORIES; c++) {
+                    const int64_t* column = ledger.column(expenseColumn(c));
+                    values.clear();
+                    for (size_t m = begin; m < end; m++) values.push_back(column[members[m].second]);
+                    summarize(values, group.categories[c]);
+                }
+                begin = end;
+            }
+        });
+        return result;
+    }
+
+    // Per-user and per-month rollups over the whole ledger
+    AggregationResult aggregate(const BudgetLedger& ledger) {
+        AggregationResult result;
+        result.users = rollup(ledger, ledger.getUserIds(), ledger.getUsers().size());
+        result.months = rollup(ledger, ledger.getMonthIds(), ledger.getMonths().size());
+        return result;
+    }
+};
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+using namespace std;
+
+// Bump-pointer allocator. Memory comes from large blocks and is only
+// returned all at once by reset() or destruction, so it suits many small
+// objects that share one lifetime. Nothing allocated here is destroyed,
+// which is why only trivially destructible types may be created.
+class Arena {
+public:
+    static constexpr size_t DEFAULT_BLOCK_SIZE = 1 << 20;
+
+private:
+    vector<unique_ptr<char[]>> blocks;
+    size_t blockSize;
+    char* cursor;
+    char* limit;
+    size_t reserved;
+
+    void grow(size_t minimum) {
+        size_t size = minimum > blockSize ? minimum : blockSize;
+        blocks.emplace_back(new char[size]);
+        cursor = blocks.back().get();
+        limit = cursor + size;
+        reserved += size;
+    }
+
+public:
+    explicit Arena(size_t block = DEFAULT_BLOCK_SIZE)
+        : blockSize(block), cursor(nullptr), limit(nullptr), reserved(0) {}
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    Arena(Arena&&) = default;
+    Arena& operator=(Arena&&) = default;
+
+    void* allocate(size_t bytes, size_t align = alignof(max_align_t)) {
+        uintptr_t address = (reinterpret_cast<uintptr_t>(cursor) + align - 1) & ~(uintptr_t(align) - 1);
+        if (cursor == nullptr || address + bytes > reinterpret_cast<uintptr_t>(limit)) {
+            grow(bytes + align);
+            address = (reinterpret_cast<uintptr_t>(cursor) + align - 1) & ~(uintptr_t(align) - 1);
+        }
+        cursor = reinterpret_cast<char*>(address + bytes);
+        return reinterpret_cast<void*>(address);
+    }
+
+    // Uninitialized storage for count objects of T
+    template<typename T>
+    T* allocateArray(size_t count) {
+        static_assert(is_trivially_destructible<T>::value, "Arena never runs destructors");
+        return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+    }
+
+    // Release every block
+    void reset() {
+        blocks.clear();
+        cursor = limit = nullptr;
+        reserved = 0;
+    }
+
+    size_t bytesReserved() const { return reserved; }
+};
+
+#endif
@@ -0,0 +1,324 @@
+#ifndef BATCHPIPELINE_H
+#define BATCHPIPELINE_H
+
+#include "FileHandler.h"
+#include "SpscQueue.h"
+#include "CsvFields.h"
+
+struct BatchOptions {
+    char delimiter;         // ',' or '\t'; 0 = tab if the first line has one, else comma
+    size_t chunkBytes;      // input handed to the parser at a time
+    size_t queueDepth;      // chunks in flight between two stages
+
+    BatchOptions(char d = 0, size_t chunk = 256 << 10, size_t depth = 8)
+        : delimiter(d), chunkBytes(chunk), queueDepth(depth) {}
+};
+
+struct BatchReject {
+    uint64_t line;
+    string reason;
+};
+
+struct BatchSummary {
+    static constexpr size_t MAX_REPORTED_REJECTS = 20;
+    static constexpr int NUM_QUEUES = 4;
+
+    uint64_t rows;
+    uint64_t accepted;
+    uint64_t rejected;
+    uint64_t bytes;
+    double seconds;
+    Money totalIncome;
+    Money totalExpenses;
+    uint64_t goalsMet;
+    bool saved;                         // false if persisting failed
+    vector<BatchReject> rejects;        // the first MAX_REPORTED_REJECTS
+    size_t fullWaits[NUM_QUEUES];       // pushes that hit a full queue, per stage boundary
+
+    BatchSummary() : rows(0), accepted(0), rejected(0), bytes(0), seconds(0), goalsMet(0), saved(true), fullWaits() {}
+};
+
+// Bulk loader for CSV/TSV budgets. Rows are "user,month" followed by the
+// 14 amounts in BudgetColumn order, or any order named by a header line
+// whose first field is USER (file keys such as SALARY or OTHER_EXPENSES,
+// any case). The input runs through four threads:
+//   parse -> validate -> compute -> persist
+// linked by SpscQueues of chunk-sized batches. Batches come from a fixed
+// pool that the persist stage hands back to the reader, so memory stays
+// bounded and a slow stage throttles the ones before it.
+class BatchPipeline {
+private:
+    // One input row; text fields view the batch's chunk
+    struct Row {
+        uint64_t line;
+        string_view user;
+        string_view month;
+        Money values[NUM_BUDGET_COLUMNS];
+        const char* error;      // nullptr while the row is accepted
+        int errorColumn;        // column the error refers to, or -1
+    };
+
+    struct Batch {
+        string text;
+        uint64_t firstLine;
+        vector<Row> rows;
+        deque<string> unquoted;     // fields that needed "" unescaping
+        vector<Budget> budgets;
+        Money income;
+        Money expenses;
+        uint64_t goalsMet;
+    };
+
+    FileHandler& store;
+    BatchOptions options;
+    char delimiter;
+    vector<int> layout;         // field index -> BudgetColumn, KEY_USER, KEY_MONTH or KEY_UNKNOWN
+
+    void parseStage(Batch& batch) const {
+        vector<string_view> fields;
+        string_view text = batch.text;
+        uint64_t line = batch.firstLine;
+        batch.rows.clear();
+        batch.unquoted.clear();
+        while (!text.empty()) {
+            size_t newline = text.find('\n');
+            string_view raw = text.substr(0, newline);
+            text.remove_prefix(newline == string_view::npos ? text.size() : newline + 1);
+            uint64_t number = line++;
+            if (CsvFields::trim(raw).empty()) continue;
+
+            batch.rows.emplace_back();
+            Row& row = batch.rows.back();
+            row.line = number;
+            row.error = nullptr;
+            row.errorColumn = -1;
+            if (!CsvFields::split(raw, delimiter, fields, batch.unquoted)) {
+                row.error = "unterminated quote";
+                continue;
+            }
+            if (fields.size() != layout.size()) {
+                row.error = "wrong number of fields";
+                continue;
+            }
+            for (size_t f = 0; f < fields.size() && !row.error; f++) {
+                int column = layout[f];
+                if (column == KEY_USER) {
+                    row.user = fields[f];
+                } else if (column == KEY_MONTH) {
+                    row.month = fields[f];
+                } else if (column != KEY_UNKNOWN && !fields[f].empty() && !Money::fromChars(fields[f], row.values[column])) {
+                    row.error = "invalid number";
+                    row.errorColumn = column;
+                }
+            }
+        }
+    }
+
+    // Same rules as interactive entry: names present, no negative amounts
+    static void validateStage(Batch& batch) {
+        for (Row& row : batch.rows) {
+            if (row.error) continue;
+            if (row.user.empty() || row.month.empty()) {
+                row.error = "missing user or month";
+                continue;
+            }
+            if (!Budget::validateName(row.user) || !Budget::validateName(row.month)) {
+                row.error = "control characters in user or month";
+                continue;
+            }
+            for (int c = 0; c < NUM_BUDGET_COLUMNS; c++) {
+                if (!Budget::validatePositive(row.values[c])) {
+                    row.error = "negative amount";
+                    row.errorColumn = c;
+                    break;
+                }
+            }
+        }
+    }
+
+    static void computeStage(Batch& batch) {
+        batch.budgets.clear();
+        batch.income = Money();
+        batch.expenses = Money();
+        batch.goalsMet = 0;
+        for (const Row& row : batch.rows) {
+            if (row.error) continue;
+            batch.budgets.emplace_back(string(row.user), string(row.month));
+            Budget& b = batch.budgets.back();
+            for (int c = 0; c < NUM_BUDGET_COLUMNS; c++) BudgetColumns::set(b, c, row.values[c]);
+            batch.income += b.getTotalIncome();
+            batch.expenses += b.getTotalExpenses();
+            if (b.isSavingsGoalMet()) batch.goalsMet++;
+        }
+    }
+
+    // Decide delimiter and layout from the first line; true if it is a header
+    bool readHeader(string_view firstLine) {
+        delimiter = options.delimiter ? options.delimiter : firstLine.find('\t') != string_view::npos ? '\t' : ',';
+        vector<string_view> fields;
+        deque<string> unquoted;
+        CsvFields::split(firstLine, delimiter, fields, unquoted);
+        string first = fields.empty() ? string() : string(fields[0]);
+        for (char& ch : first) ch = static_cast<char>(toupper(static_cast<unsigned char>(ch)));
+
+        layout.clear();
+        if (first != "USER") {
+            layout.push_back(KEY_USER);
+            layout.push_back(KEY_MONTH);
+            for (int c = 0; c < NUM_BUDGET_COLUMNS; c++) layout.push_back(c);
+            return false;
+        }
+        for (string_view field : fields) {
+            string key(field);
+            for (char& ch : key) ch = static_cast<char>(toupper(static_cast<unsigned char>(ch)));
+            int column = BudgetTextParser::lookupKey(key);
+            if (column == KEY_UNKNOWN) cerr << "Warning: Ignoring unknown column " << field << endl;
+            layout.push_back(column);
+        }
+        return true;
+    }
+
+    static string rejectReason(const Row& row) {
+        string reason = row.error;
+        if (row.errorColumn >= 0) {
+            reason += " in ";
+            reason += BudgetWriter::key(row.errorColumn);
+        }
+        return reason;
+    }
+
+public:
+    BatchPipeline(FileHandler& fileHandler, const BatchOptions& opts = BatchOptions())
+        : store(fileHandler), options(opts), delimiter(',') {}
+
+    // Load every row from input (stdin for "-") into the store
+    bool run(const string& input, BatchSummary& summary) {
+        FILE* in = input == "-" ? stdin : fopen(input.c_str(), "rb");
+        if (!in) {
+            cerr << "Error: Could not open " << input << "!" << endl;
+            return false;
+        }
+        bool ok = run(in, summary);
+        if (in != stdin) fclose(in);
+        return ok;
+    }
+
+    bool run(FILE* in, BatchSummary& summary) {
+        summary = BatchSummary();
+        auto started = chrono::steady_clock::now();
+
+        // The header (or first row) decides the layout before any thread starts
+        string carry;
+        char block[4096];
+        while (carry.find('\n') == string::npos) {
+            size_t got = fread(block, 1, sizeof(block), in);
+            if (got == 0) break;
+            carry.append(block, got);
+        }
+        summary.bytes = carry.size();
+        if (carry.compare(0, 3, "\xEF\xBB\xBF") == 0) carry.erase(0, 3);    // UTF-8 byte order mark
+        string_view firstLine = string_view(carry).substr(0, carry.find('\n'));
+        uint64_t nextLine = 1;
+        if (readHeader(firstLine)) {
+            carry.erase(0, min(carry.size(), firstLine.size() + 1));
+            nextLine = 2;
+        }
+
+        size_t depth = max<size_t>(2, options.queueDepth);
+        vector<unique_ptr<Batch>> pool(BatchSummary::NUM_QUEUES * depth + 2);
+        SpscQueue<Batch*> queues[BatchSummary::NUM_QUEUES] = {SpscQueue<Batch*>(depth), SpscQueue<Batch*>(depth),
+                                                               SpscQueue<Batch*>(depth), SpscQueue<Batch*>(depth)};
+        SpscQueue<Batch*> recycled(pool.size());
+        for (auto& batch : pool) {
+            batch.reset(new Batch());
+            batch->text.reserve(options.chunkBytes + 4096);
+            Batch* free = batch.get();
+            recycled.push(free);
+        }
+
+        // Each stage pops from its queue, works, and pushes downstream
+        auto stage = [&queues](int index, auto work) {
+            return thread([&queues, index, work] {
+                Batch* batch;
+                while (queues[index].pop(batch)) {
+                    work(*batch);
+                    if (index + 1 < BatchSummary::NUM_QUEUES) queues[index + 1].push(batch);
+                }
+                if (index + 1 < BatchSummary::NUM_QUEUES) queues[index + 1].close();
+            });
+        };
+        vector<thread> threads;
+        threads.push_back(stage(0, [this](Batch& b) { parseStage(b); }));
+        threads.push_back(stage(1, [](Batch& b) { validateStage(b); }));
+        threads.push_back(stage(2, [](Batch& b) { computeStage(b); }));
+
+        // Binary files are rewritten per save, so they get one save at the end
+        vector<Budget> deferred;
+        bool rewritten = store.getFormat() != TEXT_FORMAT;
+        threads.push_back(stage(3, [&](Batch& b) {
+            for (const Row& row : b.rows) {
+                summary.rows++;
+                if (!row.error) continue;
+                summary.rejected++;
+                if (summary.rejects.size() < BatchSummary::MAX_REPORTED_REJECTS) {
+                    summary.rejects.push_back({row.line, rejectReason(row)});
+                }
+            }
+            if (rewritten) {
+                deferred.insert(deferred.end(), b.budgets.begin(), b.budgets.end());
+            } else if (summary.saved && !b.budgets.empty() && !store.saveBudgets(b.budgets)) {
+                summary.saved = false;
+            }
+            summary.accepted += b.budgets.size();
+            summary.totalIncome += b.income;
+            summary.totalExpenses += b.expenses;
+            summary.goalsMet += b.goalsMet;
+            Batch* done = &b;
+            recycled.push(done);
+        }));
+
+        // Reader: cut the input into chunks that end on a line boundary
+        bool eof = false;
+        while (!eof) {
+            Batch* batch;
+            recycled.pop(batch);
+            batch->text.assign(carry);
+            carry.clear();
+            size_t target = options.chunkBytes;
+            while (true) {
+                while (batch->text.size() < target) {
+                    size_t before = batch->text.size();
+                    batch->text.resize(target);
+                    size_t got = fread(&batch->text[before], 1, target - before, in);
+                    batch->text.resize(before + got);
+                    summary.bytes += got;
+                    if (got == 0) {
+                        eof = true;
+                        break;
+                    }
+                }
+                if (eof) break;
+                size_t cut = batch->text.rfind('\n');
+                if (cut != string::npos) {
+                    carry.assign(batch->text, cut + 1, string::npos);
+                    batch->text.resize(cut + 1);
+                    break;
+                }
+                target += options.chunkBytes;   // a line longer than a chunk
+            }
+            batch->firstLine = nextLine;
+            nextLine += static_cast<uint64_t>(count(batch->text.begin(), batch->text.end(), '\n'));
+            queues[0].push(batch);
+        }
+        queues[0].close();
+        for (thread& t : threads) t.join();
+
+        if (rewritten && !deferred.empty() && !store.saveBudgets(deferred)) summary.saved = false;
+        if (!store.flush()) summary.saved = false;
+        for (int q = 0; q < BatchSummary::NUM_QUEUES; q++) summary.fullWaits[q] = queues[q].getFullWaits();
+        summary.seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+        return summary.saved;
+    }
+};
+
+#endif
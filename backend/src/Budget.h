@@ -8,37 +8,37 @@
 // Multiple Inheritance demonstration
 class Budget : public Income, public Expense {
 private:
-    double savingsGoal;
+    Money savingsGoal;
     
 public:
-    Budget() : Income(), Expense(), savingsGoal(0) {}
+    Budget() : Income(), Expense(), savingsGoal() {}
     
     Budget(string name, string mon) : Income(name, mon), 
                                       Expense(name, mon),
-                                      savingsGoal(0) {
+                                      savingsGoal() {
         // Resolve ambiguity by using Income's constructor
         Income::setUserName(name);
         Income::setMonth(mon);
     }
     
     // Resolve ambiguity for getUserName and getMonth
-    string getUserName() const { return Income::getUserName(); }
-    string getMonth() const { return Income::getMonth(); }
+    const string& getUserName() const { return Income::getUserName(); }
+    const string& getMonth() const { return Income::getMonth(); }
     void setUserName(string name) { Income::setUserName(name); }
     void setMonth(string mon) { Income::setMonth(mon); }
     
-    void setSavingsGoal(double goal) { savingsGoal = goal; }
-    double getSavingsGoal() const { return savingsGoal; }
+    void setSavingsGoal(Money goal) { savingsGoal = goal; }
+    Money getSavingsGoal() const { return savingsGoal; }
     
     // Calculate remaining balance
-    double getBalance() const {
+    Money getBalance() const {
         return getTotalIncome() - getTotalExpenses();
     }
     
     // Calculate actual savings
-    double getSavings() const {
-        double balance = getBalance();
-        return (balance > 0) ? balance : 0;
+    Money getSavings() const {
+        Money balance = getBalance();
+        return (balance > Money()) ? balance : Money();
     }
     
     // Check if savings goal is met
@@ -48,9 +48,9 @@ public:
     
     // Get savings percentage
     double getSavingsPercentage() const {
-        double totalIncome = getTotalIncome();
-        if (totalIncome == 0) return 0;
-        return (getSavings() / totalIncome) * 100;
+        Money totalIncome = getTotalIncome();
+        if (totalIncome == Money()) return 0;
+        return (getSavings().toDouble() / totalIncome.toDouble()) * 100;
     }
     
     // Friend function declaration for displaying summary
@@ -82,8 +82,23 @@ public:
     
     // Template function for validation
     template<typename T>
-    bool validatePositive(T value) {
-        return value >= 0;
+    static bool validatePositive(T value) {
+        return value >= T();
+    }
+    
+    // User names and months are single lines of the text log, so control
+    // characters (a newline would start a forged record) are refused, as is
+    // a leading "---", the record separator
+    static bool validateName(string_view name) {
+        if (name.substr(0, 3) == "---") return false;
+        for (char c : name) {
+            if (static_cast<unsigned char>(c) < 0x20 || c == 0x7F) return false;
+        }
+        return true;
+    }
+    
+    bool hasValidNames() const {
+        return validateName(Income::getUserName()) && validateName(Income::getMonth());
     }
 };
 
@@ -0,0 +1,455 @@
+#ifndef BUDGETAPI_H
+#define BUDGETAPI_H
+
+#include "FileHandler.h"
+#include "HttpServer.h"
+#include "JsonImporter.h"
+#include "SavingsProjection.h"
+#include "TrendEngine.h"
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+// JSON API over the budget store, for HttpServer:
+//   GET  /api/health                               {"status":"ok","budgets":n}
+//   GET  /api/budgets/{user}                       months saved for a user
+//   GET  /api/budgets/{user}/{month}               latest budget (JsonExporter schema)
+//   GET  /api/budgets/{user}/{month}/summary       totals, balance and goal status
+//   GET  /api/budgets/{user}/{month}/breakdown     expenses by category with shares
+//   POST /api/budgets                              save a budget (frontend or backend JSON)
+//   PUT  /api/budgets/{user}/{month}               save, user and month taken from the path
+//   POST /api/summary                              summary of a posted budget, not saved
+//   GET  /api/trends/{user}                        rolling averages, quantiles and forecasts
+//   GET  /api/projection/{user}?goal=&months=      chance of saving goal, with balance bands
+//                                                  (optional paths= and start= balance)
+// Path segments are URL-encoded. The latest budget per (user, month) is
+// kept in memory for reads, with each user's trends updated as budgets
+// are saved; saves go through FileHandler under one lock and reach the
+// cache only once their group commit has succeeded.
+class BudgetApi {
+private:
+    struct UserBudgets {
+        vector<Budget> months;      // latest per month, in first-saved order
+        vector<uint64_t> saves;     // save sequence each month came from, 0 if loaded
+    };
+
+    FileHandler& store;
+    mutex writeLock;
+    mutable shared_mutex cacheLock;
+    unordered_map<string, UserBudgets> users;
+    TrendEngine trends;
+    SavingsProjector projector;
+    size_t budgetCount;
+    uint64_t saveSequence;      // log order of saves, under writeLock
+
+    static void appendMoneyField(string& out, const char* key, Money value) {
+        char digits[Money::MAX_CHARS];
+        out += '"';
+        out += key;
+        out += "\":";
+        out.append(digits, value.toChars(digits, digits + sizeof(digits)));
+    }
+
+    static void appendPercent(string& out, double value) {
+        char digits[32];
+        out.append(digits, to_chars(digits, digits + sizeof(digits), value, chars_format::fixed, 1).ptr);
+    }
+
+    static void error(HttpResponse& response, int status, string_view message) {
+        response.status = status;
+        response.body += "{\"error\":";
+        JsonExporter::appendString(response.body, message);
+        response.body += '}';
+    }
+
+    // Insert or replace the cached budget for its (user, month) unless a
+    // later save already did; false if this one is stale. newMonth tells
+    // whether the month is new for the user.
+    bool remember(const Budget& budget, uint64_t sequence, bool& newMonth) {
+        UserBudgets& user = users[budget.getUserName()];
+        for (size_t i = 0; i < user.months.size(); i++) {
+            if (user.months[i].getMonth() == budget.getMonth()) {
+                if (user.saves[i] > sequence) return false;
+                user.months[i] = budget;
+                user.saves[i] = sequence;
+                newMonth = false;
+                return true;
+            }
+        }
+        user.months.push_back(budget);
+        user.saves.push_back(sequence);
+        budgetCount++;
+        newMonth = true;
+        return true;
+    }
+
+    // Recompute a user's trends from the cached months
+    void rebuildTrends(const string& user) {
+        vector<const Budget*> months;
+        for (const Budget& budget : users[user].months) months.push_back(&budget);
+        trends.rebuild(user, months);
+    }
+
+    // Update trends after remember(); a new or latest month is O(1), a
+    // correction to an earlier month replays the user
+    void updateTrends(const Budget& budget, bool newMonth) {
+        const string& user = budget.getUserName();
+        if ((!newMonth && !trends.isLatestMonth(user, budget.getMonth())) || !trends.add(budget)) {
+            rebuildTrends(user);
+        }
+    }
+
+    const Budget* lookup(const string& user, const string& month) const {
+        auto it = users.find(user);
+        if (it == users.end()) return nullptr;
+        for (const Budget& budget : it->second.months) {
+            if (budget.getMonth() == month) return &budget;
+        }
+        return nullptr;
+    }
+
+    static void appendSummary(string& out, const Budget& budget) {
+        out += "{\"user\":";
+        JsonExporter::appendString(out, budget.getUserName());
+        out += ",\"month\":";
+        JsonExporter::appendString(out, budget.getMonth());
+        out += ',';
+        appendMoneyField(out, "income", budget.getTotalIncome());
+        out += ',';
+        appendMoneyField(out, "expenses", budget.getTotalExpenses());
+        out += ',';
+        appendMoneyField(out, "balance", budget.getBalance());
+        out += ',';
+        appendMoneyField(out, "savings", budget.getSavings());
+        out += ',';
+        appendMoneyField(out, "savingsGoal", budget.getSavingsGoal());
+        out += ",\"savingsPercentage\":";
+        appendPercent(out, budget.getSavingsPercentage());
+        out += budget.isSavingsGoalMet() ? ",\"goalMet\":true}" : ",\"goalMet\":false}";
+    }
+
+    static void appendBreakdown(string& out, const Budget& budget) {
+        Money total = budget.getTotalExpenses();
+        out += "{\"user\":";
+        JsonExporter::appendString(out, budget.getUserName());
+        out += ",\"month\":";
+        JsonExporter::appendString(out, budget.getMonth());
+        out += ',';
+        appendMoneyField(out, "total", total);
+        out += ",\"categories\":[";
+        for (const CategoryDescriptor& category : EXPENSE_CATEGORIES) {
+            Money amount = budget.getExpense(category.id);
+            if (category.id > 0) out += ',';
+            out += "{\"key\":\"";
+            out += category.jsonKey;
+            out += "\",\"name\":\"";
+            out += category.displayName;
+            out += "\",";
+            appendMoneyField(out, "amount", amount);
+            out += ",\"percent\":";
+            appendPercent(out, total > Money() ? amount.toDouble() / total.toDouble() * 100 : 0.0);
+            out += '}';
+        }
+        out += "]}";
+    }
+
+    void appendTrends(string& out, const string& user) const {
+        out += "{\"user\":";
+        JsonExporter::appendString(out, user);
+        out += ",\"months\":";
+        out += to_string(trends.monthsFor(user));
+        out += ",\"series\":[";
+        for (int series = 0; series < NUM_TREND_SERIES; series++) {
+            SeriesTrend t;
+            trends.trend(user, series, t);
+            if (series > 0) out += ',';
+            out += "{\"key\":\"";
+            out += trendSeriesKey(series);
+            out += "\",\"name\":\"";
+            out += trendSeriesName(series);
+            out += "\",";
+            appendMoneyField(out, "latest", t.latest);
+            out += ',';
+            appendMoneyField(out, "mean3", t.windows[0].mean);
+            out += ',';
+            appendMoneyField(out, "mean6", t.windows[1].mean);
+            out += ',';
+            appendMoneyField(out, "mean12", t.windows[2].mean);
+            out += ',';
+            appendMoneyField(out, "stddev12", t.windows[2].stddev);
+            out += ',';
+            appendMoneyField(out, "ewma", t.ewma);
+            out += ',';
+            appendMoneyField(out, "median", t.median);
+            out += ',';
+            appendMoneyField(out, "p90", t.p90);
+            out += ',';
+            appendMoneyField(out, "forecast", t.forecast());
+            out += ",\"forecastMethod\":\"";
+            out += forecastMethodName(t.method);
+            out += "\"}";
+        }
+        out += "]}";
+    }
+
+    // Decoded value of key in a query string, false if absent
+    static bool queryValue(string_view query, string_view key, string& value) {
+        while (!query.empty()) {
+            size_t amp = query.find('&');
+            string_view pair = query.substr(0, amp);
+            size_t equals = pair.find('=');
+            if (pair.substr(0, equals) == key) {
+                value = HttpServer::urlDecode(equals == string_view::npos ? string_view() : pair.substr(equals + 1));
+                return true;
+            }
+            if (amp == string_view::npos) break;
+            query.remove_prefix(amp + 1);
+        }
+        return false;
+    }
+
+    void project(const string& user, string_view query, HttpResponse& response) {
+        static constexpr size_t MAX_PATHS = 10000000;
+        // Runs on an HTTP worker, so a request gets a bounded amount of simulation
+        static constexpr size_t MAX_PATH_MONTHS = 100000000;
+        string text;
+        ProjectionOptions options(Money(), 12, 100000);
+        if (!queryValue(query, "goal", text) || !Money::fromChars(text, options.goal)) {
+            return error(response, 400, "goal amount is required");
+        }
+        if (queryValue(query, "months", text)) options.months = strtoul(text.c_str(), nullptr, 10);
+        if (queryValue(query, "paths", text)) options.paths = strtoul(text.c_str(), nullptr, 10);
+        if (queryValue(query, "start", text) && !Money::fromChars(text, options.start)) {
+            return error(response, 400, "start must be an amount");
+        }
+        if (options.months == 0 || options.months > SavingsProjector::MAX_MONTHS) {
+            return error(response, 400, "months must be 1 to " + to_string(SavingsProjector::MAX_MONTHS));
+        }
+        if (options.paths == 0 || options.paths > MAX_PATHS) {
+            return error(response, 400, "paths must be 1 to " + to_string(MAX_PATHS));
+        }
+        if (options.paths * options.months > MAX_PATH_MONTHS) {
+            return error(response, 400, "paths times months must be at most " + to_string(MAX_PATH_MONTHS));
+        }
+
+        // Copy the history so the simulation runs without the cache lock
+        vector<Budget> history;
+        {
+            shared_lock<shared_mutex> cache(cacheLock);
+            auto it = users.find(user);
+            if (it == users.end()) return error(response, 404, "no budgets for user");
+            history = it->second.months;
+        }
+        stable_sort(history.begin(), history.end(), [](const Budget& a, const Budget& b) {
+            return HistoryStore::monthKey(a.getMonth()) < HistoryStore::monthKey(b.getMonth());
+        });
+        vector<const Budget*> budgets;
+        for (const Budget& budget : history) budgets.push_back(&budget);
+        SavingsModel model;
+        model.build(budgets);
+        ProjectionResult result;
+        if (!projector.project(model, options, result)) return error(response, 500, "could not run the projection");
+
+        string& out = response.body;
+        out += "{\"user\":";
+        JsonExporter::appendString(out, user);
+        out += ',';
+        appendMoneyField(out, "goal", options.goal);
+        out += ',';
+        appendMoneyField(out, "start", options.start);
+        out += ",\"months\":";
+        out += to_string(options.months);
+        out += ",\"paths\":";
+        out += to_string(result.paths);
+        out += ",\"historyMonths\":";
+        out += to_string(result.historyMonths);
+        out += ',';
+        appendMoneyField(out, "monthlyMean", result.monthlyMean);
+        out += ',';
+        appendMoneyField(out, "monthlyStddev", result.monthlyStddev);
+        out += ",\"probabilityPercent\":";
+        appendPercent(out, result.probability * 100);
+        out += ",\"medianMonths\":";
+        out += result.medianMonths > 0 ? to_string(result.medianMonths) : "null";
+        out += ",\"bands\":[";
+        for (size_t m = 0; m < result.bands.size(); m++) {
+            const ProjectionBand& band = result.bands[m];
+            if (m > 0) out += ',';
+            out += "{\"month\":";
+            out += to_string(m + 1);
+            out += ',';
+            appendMoneyField(out, "p10", band.p10);
+            out += ',';
+            appendMoneyField(out, "p25", band.p25);
+            out += ',';
+            appendMoneyField(out, "p50", band.p50);
+            out += ',';
+            appendMoneyField(out, "p75", band.p75);
+            out += ',';
+            appendMoneyField(out, "p90", band.p90);
+            out += ",\"reachedPercent\":";
+            appendPercent(out, band.reached * 100);
+            out += '}';
+        }
+        out += "]}";
+    }
+
+    // Exactly one budget from a request body
+    static bool parseBody(string_view body, Budget& budget, HttpResponse& response) {
+        JsonBudgetParser parser;
+        JsonImportError e;
+        if (parser.parseOne(body, budget, e)) return true;
+        error(response, 400, "body " + to_string(e.line) + ":" + to_string(e.column) + ": " + e.message);
+        return false;
+    }
+
+    void save(const Budget& budget, HttpResponse& response) {
+        if (!budget.hasValidNames()) {
+            return error(response, 400, "user name and month must not contain control characters");
+        }
+        CommitTicket ticket;
+        uint64_t sequence;
+        {
+            lock_guard<mutex> guard(writeLock);
+            if (!store.saveBudget(budget, &ticket)) {
+                error(response, 500, "could not save budget");
+                return;
+            }
+            sequence = ++saveSequence;
+        }
+        // Waited for outside the lock, so concurrent saves share one commit
+        if (!ticket.wait()) return error(response, 500, "could not commit budget");
+        {
+            // Commits can finish out of order; the sequence keeps the log's order
+            unique_lock<shared_mutex> cache(cacheLock);
+            bool newMonth;
+            if (remember(budget, sequence, newMonth)) updateTrends(budget, newMonth);
+        }
+        JsonExporter::appendBudget(response.body, budget);
+    }
+
+    // Split "/a/b/c" after the prefix into decoded segments
+    static size_t splitPath(string_view path, string* segments, size_t maxSegments) {
+        size_t count = 0;
+        while (!path.empty()) {
+            size_t slash = path.find('/');
+            string_view segment = path.substr(0, slash);
+            if (count == maxSegments) return maxSegments + 1;
+            segments[count++] = HttpServer::urlDecode(segment);
+            if (slash == string_view::npos) break;
+            path.remove_prefix(slash + 1);
+        }
+        return count;
+    }
+
+public:
+    explicit BudgetApi(FileHandler& fileHandler) : store(fileHandler), budgetCount(0), saveSequence(0) {}
+
+    BudgetApi(const BudgetApi&) = delete;
+    BudgetApi& operator=(const BudgetApi&) = delete;
+
+    // Fill the cache from the store; call before serving
+    bool load() {
+        unique_lock<shared_mutex> cache(cacheLock);
+        users.clear();
+        budgetCount = 0;
+        bool newMonth;
+        bool ok = store.forEachBudget([&](const Budget& b) { remember(b, 0, newMonth); });
+        for (const auto& entry : users) rebuildTrends(entry.first);
+        return ok;
+    }
+
+    size_t size() const {
+        shared_lock<shared_mutex> cache(cacheLock);
+        return budgetCount;
+    }
+
+    void handle(const HttpRequest& request, HttpResponse& response) {
+        static constexpr string_view PREFIX = "/api/budgets";
+        static constexpr string_view TRENDS = "/api/trends/";
+        static constexpr string_view PROJECTION = "/api/projection/";
+        string_view path = request.path;
+        bool get = request.method == "GET";
+
+        if (path == "/api/health") {
+            if (!get) return error(response, 405, "method not allowed");
+            response.body += "{\"status\":\"ok\",\"budgets\":";
+            response.body += to_string(size());
+            response.body += '}';
+            return;
+        }
+        if (path == "/api/summary") {
+            if (request.method != "POST") return error(response, 405, "method not allowed");
+            Budget budget;
+            if (parseBody(request.body, budget, response)) appendSummary(response.body, budget);
+            return;
+        }
+        if (path.substr(0, TRENDS.size()) == TRENDS) {
+            if (!get) return error(response, 405, "method not allowed");
+            string user = HttpServer::urlDecode(path.substr(TRENDS.size()));
+            shared_lock<shared_mutex> cache(cacheLock);
+            if (user.empty() || user.find('/') != string::npos || trends.monthsFor(user) == 0) {
+                return error(response, 404, "no budgets for user");
+            }
+            return appendTrends(response.body, user);
+        }
+        if (path.substr(0, PROJECTION.size()) == PROJECTION) {
+            if (!get) return error(response, 405, "method not allowed");
+            string user = HttpServer::urlDecode(path.substr(PROJECTION.size()));
+            if (user.empty() || user.find('/') != string::npos) return error(response, 404, "no budgets for user");
+            return project(user, request.query, response);
+        }
+        if (path.substr(0, PREFIX.size()) != PREFIX || (path.size() > PREFIX.size() && path[PREFIX.size()] != '/')) {
+            return error(response, 404, "not found");
+        }
+        path.remove_prefix(PREFIX.size());
+        if (!path.empty()) path.remove_prefix(1);
+
+        string segments[3];
+        size_t count = splitPath(path, segments, 3);
+        if (count == 0) {
+            if (request.method != "POST") return error(response, 405, "method not allowed");
+            Budget budget;
+            if (!parseBody(request.body, budget, response)) return;
+            if (budget.getUserName().empty() || budget.getMonth().empty()) {
+                return error(response, 400, "user name and month are required");
+            }
+            response.status = 201;
+            return save(budget, response);
+        }
+        if (count > 3 || segments[0].empty()) return error(response, 404, "not found");
+
+        if (count == 2 && request.method == "PUT") {
+            Budget budget;
+            if (!parseBody(request.body, budget, response)) return;
+            budget.setUserName(segments[0]);
+            budget.setMonth(segments[1]);
+            return save(budget, response);
+        }
+        if (!get) return error(response, 405, "method not allowed");
+
+        shared_lock<shared_mutex> cache(cacheLock);
+        if (count == 1) {
+            auto it = users.find(segments[0]);
+            if (it == users.end()) return error(response, 404, "no budgets for user");
+            response.body += "{\"user\":";
+            JsonExporter::appendString(response.body, segments[0]);
+            response.body += ",\"months\":[";
+            for (size_t i = 0; i < it->second.months.size(); i++) {
+                if (i > 0) response.body += ',';
+                JsonExporter::appendString(response.body, it->second.months[i].getMonth());
+            }
+            response.body += "]}";
+            return;
+        }
+
+        const Budget* budget = lookup(segments[0], segments[1]);
+        if (!budget) return error(response, 404, "no budget for user and month");
+        if (count == 2) JsonExporter::appendBudget(response.body, *budget);
+        else if (segments[2] == "summary") appendSummary(response.body, *budget);
+        else if (segments[2] == "breakdown") appendBreakdown(response.body, *budget);
+        else error(response, 404, "not found");
+    }
+};
+
+#endif
@@ -0,0 +1,206 @@
+#ifndef BUDGETINDEX_H
+#define BUDGETINDEX_H
+
+#include "BudgetParser.h"
+#include "SystemIO.h"
+#include <algorithm>
+#include <map>
+
+// Byte range of one record inside the budget log
+struct IndexEntry {
+    uint64_t offset;
+    uint64_t end;
+};
+
+// Persistent (user, month) -> file offset index for the text budget log.
+// The sidecar file is itself append-only: a header followed by entries of
+//   uint64 offset | uint64 end | uint32 userLen | uint32 monthLen | user | month
+// Later entries for the same key replace earlier ones, so re-saving a month
+// leaves the old record in the log but only the newest one in the index.
+class BudgetIndex {
+private:
+    static constexpr char MAGIC[4] = {'B', 'G', 'T', 'I'};
+    static constexpr uint32_t VERSION = 1;
+
+    string logPath;
+    string indexPath;
+    map<string, map<string, IndexEntry>> entries;
+    uint64_t coveredBytes;      // log bytes already reflected in the index
+    size_t totalRecords;        // every indexed record, including superseded ones
+    size_t liveRecords;
+    AppendFile sidecar;
+    string pendingEntries;
+
+    // Sink that turns parsed records into index entries; numbers are skipped
+    class IndexSink {
+    private:
+        BudgetIndex& index;
+        string user;
+        string month;
+
+    public:
+        explicit IndexSink(BudgetIndex& idx) : index(idx) {}
+        void begin() {
+            user.clear();
+            month.clear();
+        }
+        void setText(int key, string_view value) {
+            (key == KEY_USER ? user : month).assign(value.data(), value.size());
+        }
+        void setValue(int, Money) {}
+        void commit(uint64_t start, uint64_t end) { index.add(user, month, start, end); }
+        void discard() {}
+        void reserve(size_t) {}
+    };
+
+    void insert(const string& user, const string& month, IndexEntry entry) {
+        auto& months = entries[user];
+        auto result = months.insert(make_pair(month, entry));
+        if (result.second) {
+            liveRecords++;
+        } else {
+            result.first->second = entry;
+        }
+        totalRecords++;
+        coveredBytes = max(coveredBytes, entry.end);
+    }
+
+    static void appendRaw(string& out, const void* data, size_t size) {
+        out.append(static_cast<const char*>(data), size);
+    }
+
+    // Replay the sidecar file, false if it is missing or damaged
+    bool loadSidecar() {
+        FILE* file = fopen(indexPath.c_str(), "rb");
+        if (!file) return false;
+        string data(streamSize(file), '\0');
+        size_t got = fread(&data[0], 1, data.size(), file);
+        fclose(file);
+        if (got != data.size() || data.size() < 8 || memcmp(data.data(), MAGIC, 4) != 0) return false;
+
+        uint32_t version;
+        memcpy(&version, data.data() + 4, 4);
+        if (version != VERSION) return false;
+
+        size_t pos = 8;
+        while (pos < data.size()) {
+            if (data.size() - pos < 24) return false;
+            IndexEntry entry;
+            uint32_t userLen, monthLen;
+            memcpy(&entry.offset, data.data() + pos, 8);
+            memcpy(&entry.end, data.data() + pos + 8, 8);
+            memcpy(&userLen, data.data() + pos + 16, 4);
+            memcpy(&monthLen, data.data() + pos + 20, 4);
+            pos += 24;
+            if (data.size() - pos < static_cast<size_t>(userLen) + monthLen) return false;
+            insert(data.substr(pos, userLen), data.substr(pos + userLen, monthLen), entry);
+            pos += userLen + monthLen;
+        }
+        return true;
+    }
+
+    void clear() {
+        entries.clear();
+        coveredBytes = 0;
+        totalRecords = 0;
+        liveRecords = 0;
+        pendingEntries.clear();
+    }
+
+    // Index log records written after the sidecar was last updated
+    bool catchUp() {
+        BudgetTextParser parser;
+        IndexSink sink(*this);
+        if (!parser.parseFile(logPath, sink, coveredBytes)) return !ifstream(logPath).is_open();
+        return flush();
+    }
+
+public:
+    BudgetIndex() : coveredBytes(0), totalRecords(0), liveRecords(0) {}
+
+    static string sidecarPathFor(const string& log) { return log + ".idx"; }
+
+    // Load the sidecar and bring it up to date with the log
+    bool open(const string& log) {
+        logPath = log;
+        indexPath = sidecarPathFor(log);
+        clear();
+
+        FILE* file = fopen(logPath.c_str(), "rb");
+        uint64_t logSize = file ? streamSize(file) : 0;
+        if (file) fclose(file);
+
+        if (!loadSidecar() || coveredBytes > logSize) return rebuild();
+        if (!sidecar.open(indexPath)) return false;
+        return catchUp();
+    }
+
+    // Throw away the sidecar and rescan the whole log
+    bool rebuild() {
+        clear();
+        sidecar.close();
+        ofstream reset(indexPath, ios::binary | ios::trunc);
+        if (!reset.is_open()) return false;
+        reset.write(MAGIC, 4);
+        reset.write(reinterpret_cast<const char*>(&VERSION), 4);
+        reset.close();
+        if (!sidecar.open(indexPath)) return false;
+        return catchUp();
+    }
+
+    // Record a budget written at [offset, end); persisted on flush()
+    void add(const string& user, const string& month, uint64_t offset, uint64_t end) {
+        IndexEntry entry = {offset, end};
+        insert(user, month, entry);
+
+        uint32_t userLen = static_cast<uint32_t>(user.size());
+        uint32_t monthLen = static_cast<uint32_t>(month.size());
+        appendRaw(pendingEntries, &entry.offset, 8);
+        appendRaw(pendingEntries, &entry.end, 8);
+        appendRaw(pendingEntries, &userLen, 4);
+        appendRaw(pendingEntries, &monthLen, 4);
+        pendingEntries += user;
+        pendingEntries += month;
+    }
+
+    // Write entries added since the last flush to the sidecar
+    bool flush() {
+        if (pendingEntries.empty()) return true;
+        bool ok = sidecar.write(pendingEntries.data(), pendingEntries.size());
+        pendingEntries.clear();
+        return ok;
+    }
+
+    const IndexEntry* find(const string& user, const string& month) const {
+        auto userIt = entries.find(user);
+        if (userIt == entries.end()) return nullptr;
+        auto monthIt = userIt->second.find(month);
+        return monthIt == userIt->second.end() ? nullptr : &monthIt->second;
+    }
+
+    // Months stored for a user, in the order they were last saved
+    vector<string> months(const string& user) const {
+        vector<string> result;
+        auto userIt = entries.find(user);
+        if (userIt == entries.end()) return result;
+
+        vector<pair<uint64_t, string>> ordered;
+        for (const auto& m : userIt->second) ordered.push_back(make_pair(m.second.offset, m.first));
+        sort(ordered.begin(), ordered.end());
+        for (auto& m : ordered) result.push_back(move(m.second));
+        return result;
+    }
+
+    // All users with at least one indexed budget
+    vector<string> users() const {
+        vector<string> result;
+        for (const auto& u : entries) result.push_back(u.first);
+        return result;
+    }
+
+    uint64_t getCoveredBytes() const { return coveredBytes; }
+    size_t getTotalRecords() const { return totalRecords; }
+    size_t getLiveRecords() const { return liveRecords; }
+};
+
+#endif
@@ -0,0 +1,318 @@
+#ifndef BUDGETLEDGER_H
+#define BUDGETLEDGER_H
+
+#include "BudgetRecord.h"
+#include "StringInterner.h"
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BUDGET_HAVE_AVX2_KERNELS 1
+#include <immintrin.h>
+#endif
+
+// Column view handed to the kernels: NUM_BUDGET_COLUMNS arrays of cents
+struct LedgerColumns {
+    const int64_t* column[NUM_BUDGET_COLUMNS];
+    size_t size;
+};
+
+// One implementation of the ledger aggregation kernels
+struct LedgerKernels {
+    const char* name;
+    int64_t (*sum)(const int64_t* values, size_t n);
+    void (*minMax)(const int64_t* values, size_t n, int64_t& low, int64_t& high);
+    void (*totals)(const LedgerColumns& cols, int64_t* income, int64_t* expenses, int64_t* balance);
+    size_t (*countGoalMet)(const LedgerColumns& cols);
+
+    static const LedgerKernels& scalar();
+    static const LedgerKernels* avx2();     // nullptr if not compiled in or not supported by this CPU
+    static const LedgerKernels& best();
+};
+
+// Portable kernels; the per-record loops use the same expressions as
+// Income::getTotalIncome, Expense::getTotalExpenses and Budget::getBalance
+struct ScalarLedgerKernels {
+    static int64_t sum(const int64_t* values, size_t n) {
+        int64_t total = 0;
+        for (size_t i = 0; i < n; i++) total += values[i];
+        return total;
+    }
+
+    static void minMax(const int64_t* values, size_t n, int64_t& low, int64_t& high) {
+        if (n == 0) {
+            low = high = 0;
+            return;
+        }
+        low = high = values[0];
+        for (size_t i = 1; i < n; i++) {
+            if (values[i] < low) low = values[i];
+            if (values[i] > high) high = values[i];
+        }
+    }
+
+    static int64_t income(const LedgerColumns& c, size_t i) {
+        return c.column[COL_SALARY][i] + c.column[COL_FREELANCE][i] +
+               c.column[COL_INVESTMENTS][i] + c.column[COL_OTHER_INCOME][i];
+    }
+
+    static int64_t expenses(const LedgerColumns& c, size_t i) {
+        int64_t total = 0;
+        for (int col = COL_RENT; col <= COL_OTHER_EXPENSES; col++) total += c.column[col][i];
+        return total;
+    }
+
+    static void totalsRange(const LedgerColumns& c, size_t from, int64_t* income, int64_t* expenses, int64_t* balance) {
+        for (size_t i = from; i < c.size; i++) {
+            int64_t in = ScalarLedgerKernels::income(c, i);
+            int64_t out = ScalarLedgerKernels::expenses(c, i);
+            income[i] = in;
+            expenses[i] = out;
+            balance[i] = in - out;
+        }
+    }
+
+    static void totals(const LedgerColumns& c, int64_t* income, int64_t* expenses, int64_t* balance) {
+        totalsRange(c, 0, income, expenses, balance);
+    }
+
+    static size_t countGoalMetRange(const LedgerColumns& c, size_t from) {
+        size_t met = 0;
+        for (size_t i = from; i < c.size; i++) {
+            int64_t balance = income(c, i) - expenses(c, i);
+            int64_t savings = balance > 0 ? balance : 0;
+            met += savings >= c.column[COL_SAVINGS_GOAL][i];
+        }
+        return met;
+    }
+
+    static size_t countGoalMet(const LedgerColumns& c) { return countGoalMetRange(c, 0); }
+};
+
+#ifdef BUDGET_HAVE_AVX2_KERNELS
+// AVX2 kernels, four int64 lanes per step with a scalar tail
+struct Avx2LedgerKernels {
+    __attribute__((target("avx2"))) static __m256i load(const int64_t* p) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    }
+
+    __attribute__((target("avx2"))) static int64_t horizontalSum(__m256i v) {
+        alignas(32) int64_t lanes[4];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), v);
+        return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+
+    __attribute__((target("avx2"))) static int64_t sum(const int64_t* values, size_t n) {
+        __m256i acc0 = _mm256_setzero_si256();
+        __m256i acc1 = _mm256_setzero_si256();
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            acc0 = _mm256_add_epi64(acc0, load(values + i));
+            acc1 = _mm256_add_epi64(acc1, load(values + i + 4));
+        }
+        int64_t total = horizontalSum(_mm256_add_epi64(acc0, acc1));
+        for (; i < n; i++) total += values[i];
+        return total;
+    }
+
+    __attribute__((target("avx2"))) static void minMax(const int64_t* values, size_t n, int64_t& low, int64_t& high) {
+        if (n < 4) {
+            ScalarLedgerKernels::minMax(values, n, low, high);
+            return;
+        }
+        __m256i lo = load(values);
+        __m256i hi = lo;
+        size_t i = 4;
+        for (; i + 4 <= n; i += 4) {
+            __m256i v = load(values + i);
+            lo = _mm256_blendv_epi8(lo, v, _mm256_cmpgt_epi64(lo, v));
+            hi = _mm256_blendv_epi8(hi, v, _mm256_cmpgt_epi64(v, hi));
+        }
+        alignas(32) int64_t los[4], his[4];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(los), lo);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(his), hi);
+        low = los[0];
+        high = his[0];
+        for (int k = 1; k < 4; k++) {
+            if (los[k] < low) low = los[k];
+            if (his[k] > high) high = his[k];
+        }
+        for (; i < n; i++) {
+            if (values[i] < low) low = values[i];
+            if (values[i] > high) high = values[i];
+        }
+    }
+
+    __attribute__((target("avx2"))) static __m256i income(const LedgerColumns& c, size_t i) {
+        __m256i a = _mm256_add_epi64(load(c.column[COL_SALARY] + i), load(c.column[COL_FREELANCE] + i));
+        __m256i b = _mm256_add_epi64(load(c.column[COL_INVESTMENTS] + i), load(c.column[COL_OTHER_INCOME] + i));
+        return _mm256_add_epi64(a, b);
+    }
+
+    __attribute__((target("avx2"))) static __m256i expenses(const LedgerColumns& c, size_t i) {
+        __m256i total = load(c.column[COL_RENT] + i);
+        for (int col = COL_GROCERIES; col <= COL_OTHER_EXPENSES; col++) {
+            total = _mm256_add_epi64(total, load(c.column[col] + i));
+        }
+        return total;
+    }
+
+    __attribute__((target("avx2"))) static void totals(const LedgerColumns& c, int64_t* income, int64_t* expenses,
+                                                       int64_t* balance) {
+        size_t i = 0;
+        for (; i + 4 <= c.size; i += 4) {
+            __m256i in = Avx2LedgerKernels::income(c, i);
+            __m256i out = Avx2LedgerKernels::expenses(c, i);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(income + i), in);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(expenses + i), out);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(balance + i), _mm256_sub_epi64(in, out));
+        }
+        ScalarLedgerKernels::totalsRange(c, i, income, expenses, balance);
+    }
+
+    __attribute__((target("avx2"))) static size_t countGoalMet(const LedgerColumns& c) {
+        const __m256i zero = _mm256_setzero_si256();
+        __m256i metCount = zero;
+        size_t i = 0;
+        for (; i + 4 <= c.size; i += 4) {
+            __m256i balance = _mm256_sub_epi64(income(c, i), expenses(c, i));
+            __m256i savings = _mm256_and_si256(balance, _mm256_cmpgt_epi64(balance, zero));
+            // savings >= goal  <=>  !(goal > savings); lanes are -1 when missed
+            __m256i missed = _mm256_cmpgt_epi64(load(c.column[COL_SAVINGS_GOAL] + i), savings);
+            metCount = _mm256_add_epi64(metCount, _mm256_add_epi64(missed, _mm256_set1_epi64x(1)));
+        }
+        return static_cast<size_t>(horizontalSum(metCount)) + ScalarLedgerKernels::countGoalMetRange(c, i);
+    }
+};
+#endif
+
+inline const LedgerKernels& LedgerKernels::scalar() {
+    static const LedgerKernels kernels = {"scalar", ScalarLedgerKernels::sum, ScalarLedgerKernels::minMax,
+                                          ScalarLedgerKernels::totals, ScalarLedgerKernels::countGoalMet};
+    return kernels;
+}
+
+inline const LedgerKernels* LedgerKernels::avx2() {
+#ifdef BUDGET_HAVE_AVX2_KERNELS
+    static const LedgerKernels kernels = {"avx2", Avx2LedgerKernels::sum, Avx2LedgerKernels::minMax,
+                                          Avx2LedgerKernels::totals, Avx2LedgerKernels::countGoalMet};
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported ? &kernels : nullptr;
+#else
+    return nullptr;
+#endif
+}
+
+inline const LedgerKernels& LedgerKernels::best() {
+    const LedgerKernels* vectorized = avx2();
+    return vectorized ? *vectorized : scalar();
+}
+
+// Structure-of-arrays budget container: every income/expense field is a
+// contiguous column of cents, user and month are interned ids
+class BudgetLedger {
+private:
+    StringInterner users;
+    StringInterner months;
+    vector<uint32_t> userIds;
+    vector<uint32_t> monthIds;
+    vector<int64_t> columns[NUM_BUDGET_COLUMNS];
+    const LedgerKernels* kernels;
+
+public:
+    BudgetLedger() : kernels(&LedgerKernels::best()) {}
+
+    // Force a kernel implementation (benchmarks and verification)
+    void setKernels(const LedgerKernels& k) { kernels = &k; }
+    const LedgerKernels& getKernels() const { return *kernels; }
+
+    size_t size() const { return userIds.size(); }
+
+    void reserve(size_t n) {
+        userIds.reserve(n);
+        monthIds.reserve(n);
+        for (auto& column : columns) column.reserve(n);
+    }
+
+    void clear() {
+        users.clear();
+        months.clear();
+        userIds.clear();
+        monthIds.clear();
+        for (auto& column : columns) column.clear();
+    }
+
+    void add(const Budget& budget) {
+        userIds.push_back(users.intern(budget.getUserName()));
+        monthIds.push_back(months.intern(budget.getMonth()));
+        for (int c = 0; c < NUM_BUDGET_COLUMNS; c++) {
+            columns[c].push_back(BudgetColumns::get(budget, c).getCents());
+        }
+    }
+
+    void add(const BudgetRecordSet& set) {
+        reserve(size() + set.size());
+        for (const BudgetRecord& record : set.records) {
+            userIds.push_back(users.intern(set.users.lookup(record.userId)));
+            monthIds.push_back(months.intern(set.months.lookup(record.monthId)));
+            for (int c = 0; c < NUM_BUDGET_COLUMNS; c++) {
+                columns[c].push_back(record.values[c].getCents());
+            }
+        }
+    }
+
+    const int64_t* column(BudgetColumn c) const { return columns[c].data(); }
+    const vector<uint32_t>& getUserIds() const { return userIds; }
+    const vector<uint32_t>& getMonthIds() const { return monthIds; }
+    const StringInterner& getUsers() const { return users; }
+    const StringInterner& getMonths() const { return months; }
+
+    LedgerColumns view() const {
+        LedgerColumns v;
+        for (int c = 0; c < NUM_BUDGET_COLUMNS; c++) v.column[c] = columns[c].data();
+        v.size = size();
+        return v;
+    }
+
+    // Total of one field over all records
+    Money columnSum(BudgetColumn c) const {
+        return Money::fromCents(kernels->sum(columns[c].data(), size()));
+    }
+
+    Money columnMin(BudgetColumn c) const {
+        int64_t low, high;
+        kernels->minMax(columns[c].data(), size(), low, high);
+        return Money::fromCents(low);
+    }
+
+    Money columnMax(BudgetColumn c) const {
+        int64_t low, high;
+        kernels->minMax(columns[c].data(), size(), low, high);
+        return Money::fromCents(high);
+    }
+
+    // Per-record total income, total expenses and balance, in cents
+    void computeTotals(vector<int64_t>& income, vector<int64_t>& expenses, vector<int64_t>& balance) const {
+        income.resize(size());
+        expenses.resize(size());
+        balance.resize(size());
+        kernels->totals(view(), income.data(), expenses.data(), balance.data());
+    }
+
+    // Per-record Budget::getSavingsPercentage
+    vector<double> savingsPercentages() const {
+        LedgerColumns v = view();
+        vector<double> result(size());
+        for (size_t i = 0; i < size(); i++) {
+            int64_t income = ScalarLedgerKernels::income(v, i);
+            int64_t balance = income - ScalarLedgerKernels::expenses(v, i);
+            int64_t savings = balance > 0 ? balance : 0;
+            result[i] = income == 0 ? 0 : (Money::fromCents(savings).toDouble() / Money::fromCents(income).toDouble()) * 100;
+        }
+        return result;
+    }
+
+    // Number of records whose savings reach their goal
+    size_t countSavingsGoalMet() const { return kernels->countGoalMet(view()); }
+};
+
+#endif
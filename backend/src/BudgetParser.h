@@ -0,0 +1,275 @@
+#ifndef BUDGETPARSER_H
+#define BUDGETPARSER_H
+
+#include "Budget.h"
+#include "ColumnarStore.h"
+#include "SystemIO.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <charconv>
+#include <string_view>
+#include <vector>
+
+// A malformed line found while loading a budget file
+struct ParseError {
+    size_t line;
+    string message;
+};
+
+// Keys of the text format that are not numeric BudgetColumns
+enum BudgetTextKey {
+    KEY_UNKNOWN = -1,
+    KEY_USER = NUM_BUDGET_COLUMNS,
+    KEY_MONTH
+};
+
+// Parser sinks receive begin() for each new record, setText/setValue for
+// its fields, commit(start, end) with the record's byte range once its "---"
+// is seen, and discard() for a trailing incomplete record.
+
+// Common field handling for sinks that fill a Budget
+class BudgetFieldSink {
+protected:
+    Budget* current;
+
+public:
+    BudgetFieldSink() : current(nullptr) {}
+
+    void setText(int key, string_view value) {
+        if (key == KEY_USER) current->setUserName(string(value));
+        else current->setMonth(string(value));
+    }
+    void setValue(int column, Money value) { BudgetColumns::set(*current, column, value); }
+    void reserve(size_t) {}
+};
+
+// Sink that appends every record straight into a vector
+class VectorBudgetSink : public BudgetFieldSink {
+private:
+    vector<Budget>& budgets;
+
+public:
+    explicit VectorBudgetSink(vector<Budget>& out) : budgets(out) {}
+
+    void begin() { current = &budgets.emplace_back(); }
+    void commit(uint64_t, uint64_t) {}
+    void discard() { budgets.pop_back(); }
+    void reserve(size_t expected) { budgets.reserve(budgets.size() + expected); }
+};
+
+// Sink that reuses one Budget and hands each finished record to a callback
+template<typename Visitor>
+class VisitorBudgetSink : public BudgetFieldSink {
+private:
+    Visitor& visit;
+    Budget scratch;
+
+public:
+    explicit VisitorBudgetSink(Visitor& v) : visit(v) {}
+
+    void begin() {
+        scratch = Budget();
+        current = &scratch;
+    }
+    void commit(uint64_t, uint64_t) { visit(static_cast<const Budget&>(scratch)); }
+    void discard() {}
+};
+
+// Streaming parser for the KEY:value text format.
+// The file is read in large blocks and tokenized in place; nothing is
+// allocated per line except the user and month strings themselves.
+class BudgetTextParser {
+public:
+    static constexpr size_t BLOCK_SIZE = 1 << 20;
+
+private:
+    vector<char> buffer;
+    vector<ParseError> parseErrors;
+    size_t lineNumber;
+    size_t recordCount;
+    uint64_t recordStart;
+
+    template<typename Sink>
+    void handleLine(string_view line, uint64_t lineOffset, uint64_t nextOffset,
+                    Sink& sink, bool& inRecord) {
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+
+        if (line == "---") {
+            if (!inRecord) {
+                sink.begin();
+                recordStart = lineOffset;
+            }
+            sink.commit(recordStart, nextOffset);
+            inRecord = false;
+            recordCount++;
+            return;
+        }
+
+        size_t pos = line.find(':');
+        if (pos == string_view::npos) return;
+
+        int key = lookupKey(line.substr(0, pos));
+        if (key == KEY_UNKNOWN) return;
+
+        string_view value = line.substr(pos + 1);
+        if (!inRecord) {
+            sink.begin();
+            inRecord = true;
+            recordStart = lineOffset;
+        }
+
+        if (key == KEY_USER || key == KEY_MONTH) {
+            sink.setText(key, value);
+        } else {
+            Money number;
+            if (parseNumber(value, number)) {
+                sink.setValue(key, number);
+            } else {
+                parseErrors.push_back({lineNumber, "invalid number '" + string(value) + "'"});
+            }
+        }
+    }
+
+    // Newlines in the first end bytes of the file, so errors found after
+    // startOffset can be reported with whole-file line numbers
+    size_t countLines(FILE* file, uint64_t end) {
+        if (!seekFile(file, 0)) return 0;
+        size_t lines = 0;
+        while (end > 0) {
+            size_t got = fread(buffer.data(), 1, static_cast<size_t>(min<uint64_t>(end, buffer.size())), file);
+            if (got == 0) break;
+            lines += count(buffer.data(), buffer.data() + got, '\n');
+            end -= got;
+        }
+        return lines;
+    }
+
+public:
+    BudgetTextParser() : lineNumber(0), recordCount(0), recordStart(0) {}
+
+    // Map a key to a BudgetColumn, KEY_USER or KEY_MONTH
+    static int lookupKey(string_view key) {
+        switch (key.size()) {
+            case 4:
+                if (key == "USER") return KEY_USER;
+                break;
+            case 5:
+                if (key == "MONTH") return KEY_MONTH;
+                break;
+            case 6:
+                if (key == "SALARY") return COL_SALARY;
+                break;
+            case 9:
+                if (key == "FREELANCE") return COL_FREELANCE;
+                break;
+            case 11:
+                if (key == "INVESTMENTS") return COL_INVESTMENTS;
+                break;
+            case 12:
+                if (key[0] == 'O' && key == "OTHER_INCOME") return COL_OTHER_INCOME;
+                if (key[0] == 'S' && key == "SAVINGS_GOAL") return COL_SAVINGS_GOAL;
+                break;
+        }
+        int category = findExpenseCategory<&CategoryDescriptor::fileKey>(key);
+        if (category < 0) return KEY_UNKNOWN;
+        return expenseColumn(category);
+    }
+
+    // Locale-independent amount parsing, false on malformed input
+    static bool parseNumber(string_view text, Money& value) {
+        return Money::fromChars(text, value);
+    }
+
+    const vector<ParseError>& errors() const { return parseErrors; }
+    size_t records() const { return recordCount; }
+
+    // Parse a file into the sink starting at byte startOffset, stopping
+    // after maxRecords records (0 = all). Returns false if it cannot be opened.
+    template<typename Sink>
+    bool parseFile(const string& path, Sink& sink, uint64_t startOffset = 0, size_t maxRecords = 0) {
+        FILE* file = fopen(path.c_str(), "rb");
+        if (!file) return false;
+
+        uint64_t fileSize = streamSize(file);
+        if (startOffset > 0 && !seekFile(file, startOffset)) {
+            fclose(file);
+            return false;
+        }
+
+        parseErrors.clear();
+        lineNumber = 0;
+        recordCount = 0;
+        bool reserved = maxRecords != 0;
+        // A point lookup only needs a small read
+        buffer.resize(maxRecords == 1 ? 4096 : BLOCK_SIZE);
+        bool inRecord = false;
+        size_t carried = 0;
+        uint64_t bufferOffset = startOffset;   // file offset of buffer[0]
+        bool done = false;
+
+        while (!done) {
+            if (carried == buffer.size()) buffer.resize(buffer.size() * 2);
+            size_t got = fread(buffer.data() + carried, 1, buffer.size() - carried, file);
+            BUDGET_STAT_ADD(STAT_READ_CALLS, 1);
+            BUDGET_STAT_ADD(STAT_BYTES_READ, got);
+            size_t filled = carried + got;
+            bool atEnd = got == 0;
+
+            const char* start = buffer.data();
+            const char* end = start + filled;
+            const char* lineStart = start;
+            while (true) {
+                const char* newline = static_cast<const char*>(memchr(lineStart, '\n', end - lineStart));
+                if (!newline) break;
+                lineNumber++;
+                uint64_t lineOffset = bufferOffset + (lineStart - start);
+                handleLine(string_view(lineStart, newline - lineStart), lineOffset,
+                           lineOffset + (newline - lineStart) + 1, sink, inRecord);
+                lineStart = newline + 1;
+
+                if (maxRecords != 0 && recordCount == maxRecords) {
+                    done = true;
+                    break;
+                }
+
+                // Size the output from the density of the first records,
+                // only between records so no open Budget is invalidated
+                if (!reserved && !inRecord && recordCount == 64 && fileSize > 0) {
+                    uint64_t consumed = bufferOffset + (lineStart - start) - startOffset;
+                    double remaining = static_cast<double>(fileSize - startOffset);
+                    sink.reserve(static_cast<size_t>(recordCount * remaining / consumed));
+                    reserved = true;
+                }
+            }
+            if (done) break;
+
+            carried = end - lineStart;
+            if (atEnd) {
+                // Last line without a trailing newline
+                if (carried > 0) {
+                    lineNumber++;
+                    uint64_t lineOffset = bufferOffset + (lineStart - start);
+                    handleLine(string_view(lineStart, carried), lineOffset, lineOffset + carried, sink, inRecord);
+                }
+                break;
+            }
+            bufferOffset += lineStart - start;
+            memmove(buffer.data(), lineStart, carried);
+        }
+
+        // Malformed lines are rare, so the lines before a tail are only
+        // counted when one needs reporting
+        if (startOffset > 0 && !parseErrors.empty()) {
+            size_t before = countLines(file, startOffset);
+            for (ParseError& error : parseErrors) error.line += before;
+        }
+        fclose(file);
+
+        // A record without its terminating "---" is incomplete
+        if (inRecord) sink.discard();
+        return true;
+    }
+};
+
+#endif
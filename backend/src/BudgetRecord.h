@@ -0,0 +1,114 @@
+#ifndef BUDGETRECORD_H
+#define BUDGETRECORD_H
+
+#include "Budget.h"
+#include "ColumnarStore.h"
+#include "StringInterner.h"
+#include "BudgetParser.h"
+#include <type_traits>
+#include <vector>
+
+// Flat, trivially copyable budget: no vtables, no strings.
+// User and month are ids into a StringInterner owned by the caller.
+struct BudgetRecord {
+    uint32_t userId;
+    uint32_t monthId;
+    Money values[NUM_BUDGET_COLUMNS];
+
+    Money get(BudgetColumn c) const { return values[c]; }
+    void set(BudgetColumn c, Money v) { values[c] = v; }
+
+    // Same arithmetic as Income/Expense/Budget
+    Money getTotalIncome() const {
+        return values[COL_SALARY] + values[COL_FREELANCE] + values[COL_INVESTMENTS] + values[COL_OTHER_INCOME];
+    }
+
+    Money getTotalExpenses() const {
+        Money total;
+        for (int c = COL_RENT; c <= COL_OTHER_EXPENSES; c++) total += values[c];
+        return total;
+    }
+
+    Money getBalance() const { return getTotalIncome() - getTotalExpenses(); }
+
+    Money getSavings() const {
+        Money balance = getBalance();
+        return (balance > Money()) ? balance : Money();
+    }
+
+    bool isSavingsGoalMet() const { return getSavings() >= values[COL_SAVINGS_GOAL]; }
+
+    double getSavingsPercentage() const {
+        Money totalIncome = getTotalIncome();
+        if (totalIncome == Money()) return 0;
+        return (getSavings().toDouble() / totalIncome.toDouble()) * 100;
+    }
+};
+
+static_assert(is_trivially_copyable<BudgetRecord>::value, "BudgetRecord must stay memcpy-able");
+static_assert(is_standard_layout<BudgetRecord>::value, "BudgetRecord must have a fixed layout");
+
+// Records plus the dictionaries their ids refer to
+class BudgetRecordSet {
+public:
+    vector<BudgetRecord> records;
+    StringInterner users;
+    StringInterner months;
+
+    size_t size() const { return records.size(); }
+
+    // Adapter from the Budget class hierarchy
+    void add(const Budget& budget) {
+        BudgetRecord record;
+        record.userId = users.intern(budget.getUserName());
+        record.monthId = months.intern(budget.getMonth());
+        for (int c = 0; c < NUM_BUDGET_COLUMNS; c++) {
+            record.values[c] = BudgetColumns::get(budget, c);
+        }
+        records.push_back(record);
+    }
+
+    // Adapter back to the Budget class hierarchy
+    Budget toBudget(size_t i) const {
+        const BudgetRecord& record = records[i];
+        Budget budget(users.lookup(record.userId), months.lookup(record.monthId));
+        for (int c = 0; c < NUM_BUDGET_COLUMNS; c++) {
+            BudgetColumns::set(budget, c, record.values[c]);
+        }
+        return budget;
+    }
+
+    void clear() {
+        records.clear();
+        users.clear();
+        months.clear();
+    }
+};
+
+// Parser sink that writes straight into a BudgetRecordSet; names are
+// interned from the line buffer, so a load allocates only for new
+// distinct names and vector growth
+class RecordSetSink {
+private:
+    BudgetRecordSet& set;
+
+public:
+    explicit RecordSetSink(BudgetRecordSet& out) : set(out) {}
+
+    void begin() {
+        BudgetRecord& record = set.records.emplace_back();
+        record.userId = set.users.intern(string_view());
+        record.monthId = set.months.intern(string_view());
+    }
+    void setText(int key, string_view value) {
+        BudgetRecord& record = set.records.back();
+        if (key == KEY_USER) record.userId = set.users.intern(value);
+        else record.monthId = set.months.intern(value);
+    }
+    void setValue(int column, Money value) { set.records.back().values[column] = value; }
+    void commit(uint64_t, uint64_t) {}
+    void discard() { set.records.pop_back(); }
+    void reserve(size_t expected) { set.records.reserve(set.records.size() + expected); }
+};
+
+#endif
@@ -0,0 +1,382 @@
+#ifndef BUDGETSTORE_H
+#define BUDGETSTORE_H
+
+#include "BudgetParser.h"
+#include "BudgetWriter.h"
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+// Epoch-based reclamation. A reader announces the global epoch in a slot
+// before touching shared objects and clears it when done; a writer that
+// unlinks an object retires it with the current epoch, and it is deleted
+// once every announced reader epoch is newer than that.
+class EpochManager {
+public:
+    static constexpr size_t MAX_READERS = 256;
+    static constexpr size_t RECLAIM_BATCH = 64;
+
+private:
+    struct alignas(64) ReaderSlot {
+        atomic<uint64_t> epoch;     // 0 = free
+    };
+
+    struct Retired {
+        void* object;
+        void (*destroy)(void*);
+        uint64_t epoch;
+    };
+
+    ReaderSlot slots[MAX_READERS];
+    atomic<uint64_t> globalEpoch;
+    mutex retireLock;
+    vector<Retired> retired;
+
+    // Free everything no reader can still see; retireLock must be held
+    void reclaimLocked() {
+        globalEpoch.fetch_add(1);
+        uint64_t oldest = ~uint64_t(0);
+        for (ReaderSlot& slot : slots) {
+            uint64_t epoch = slot.epoch.load();
+            if (epoch != 0 && epoch < oldest) oldest = epoch;
+        }
+        size_t kept = 0;
+        for (Retired& r : retired) {
+            if (r.epoch < oldest) r.destroy(r.object);
+            else retired[kept++] = r;
+        }
+        retired.resize(kept);
+    }
+
+public:
+    EpochManager() : globalEpoch(1) {
+        for (ReaderSlot& slot : slots) slot.epoch.store(0, memory_order_relaxed);
+    }
+
+    ~EpochManager() {
+        for (Retired& r : retired) r.destroy(r.object);
+    }
+
+    EpochManager(const EpochManager&) = delete;
+    EpochManager& operator=(const EpochManager&) = delete;
+
+    // Claim a free slot holding the current epoch; returns the slot
+    size_t enter() {
+        size_t start = hash<thread::id>()(this_thread::get_id()) % MAX_READERS;
+        while (true) {
+            for (size_t k = 0; k < MAX_READERS; k++) {
+                ReaderSlot& slot = slots[(start + k) % MAX_READERS];
+                uint64_t expected = 0;
+                if (slot.epoch.load(memory_order_relaxed) == 0 &&
+                    slot.epoch.compare_exchange_strong(expected, globalEpoch.load())) {
+                    return (start + k) % MAX_READERS;
+                }
+            }
+            this_thread::yield();
+        }
+    }
+
+    void exit(size_t slot) { slots[slot].epoch.store(0, memory_order_release); }
+
+    // Delete object once no reader that might have seen it is active
+    template<typename T>
+    void retire(const T* object) {
+        if (!object) return;
+        lock_guard<mutex> guard(retireLock);
+        retired.push_back({const_cast<T*>(object), [](void* p) { delete static_cast<T*>(p); }, globalEpoch.load()});
+        if (retired.size() >= RECLAIM_BATCH) reclaimLocked();
+    }
+
+    // Retired objects not yet deleted
+    size_t pending() {
+        lock_guard<mutex> guard(retireLock);
+        return retired.size();
+    }
+};
+
+// Every saved month of one user; immutable once published
+struct UserBudgets {
+    string user;
+    vector<Budget> months;      // latest per month, in first-saved order
+
+    const Budget* find(const string& month) const {
+        for (const Budget& b : months) {
+            if (b.getMonth() == month) return &b;
+        }
+        return nullptr;
+    }
+};
+
+// Users of one shard sorted by name; immutable once published
+struct StoreShard {
+    vector<const UserBudgets*> users;
+
+    size_t lowerBound(const string& user) const {
+        return lower_bound(users.begin(), users.end(), user,
+                           [](const UserBudgets* u, const string& name) { return u->user < name; }) - users.begin();
+    }
+
+    const UserBudgets* find(const string& user) const {
+        size_t i = lowerBound(user);
+        return i < users.size() && users[i]->user == user ? users[i] : nullptr;
+    }
+};
+
+// One published state of the whole store
+struct StoreRoot {
+    vector<const StoreShard*> shards;
+    uint64_t sequence;          // number of saves applied
+    size_t budgetCount;
+};
+
+// Consistent read-only view of a BudgetStore. Holding one keeps the
+// objects it sees alive; it costs one slot claim and no locks.
+class BudgetSnapshot {
+private:
+    EpochManager* epochs;
+    size_t slot;
+    const StoreRoot* root;
+
+public:
+    BudgetSnapshot(EpochManager& manager, const atomic<const StoreRoot*>& current)
+        : epochs(&manager), slot(manager.enter()), root(current.load()) {}
+    ~BudgetSnapshot() {
+        if (epochs) epochs->exit(slot);
+    }
+
+    BudgetSnapshot(const BudgetSnapshot&) = delete;
+    BudgetSnapshot& operator=(const BudgetSnapshot&) = delete;
+    BudgetSnapshot(BudgetSnapshot&& other) : epochs(other.epochs), slot(other.slot), root(other.root) {
+        other.epochs = nullptr;
+    }
+
+    static size_t shardOf(const string& user, size_t shardCount) { return hash<string>()(user) % shardCount; }
+
+    const UserBudgets* findUser(const string& user) const {
+        return root->shards[shardOf(user, root->shards.size())]->find(user);
+    }
+
+    const Budget* find(const string& user, const string& month) const {
+        const UserBudgets* u = findUser(user);
+        return u ? u->find(month) : nullptr;
+    }
+
+    // visit(const Budget&) for every budget, shard by shard
+    template<typename Visitor>
+    void forEach(Visitor visit) const {
+        for (const StoreShard* shard : root->shards) {
+            for (const UserBudgets* u : shard->users) {
+                for (const Budget& b : u->months) visit(b);
+            }
+        }
+    }
+
+    size_t size() const { return root->budgetCount; }
+    uint64_t sequence() const { return root->sequence; }
+};
+
+// In-process budget store for many threads. Readers take lock-free
+// snapshots; writers lock only the shard their user hashes to, append the
+// budget to one ordered text log (BudgetWriter, same format as
+// budgets.txt) and publish copies of the changed user, shard and root.
+// Old versions are freed through the EpochManager. A lock file keeps
+// other processes from appending to the same log.
+class BudgetStore {
+public:
+    struct Options {
+        size_t shards;
+        WriterOptions writer;
+
+        Options(size_t s = 16, const WriterOptions& w = WriterOptions(256, chrono::milliseconds(2)))
+            : shards(s), writer(w) {}
+    };
+
+private:
+    // Mutex padded to its own cache line so shards don't false-share
+    struct alignas(64) ShardLock {
+        mutex lock;
+    };
+
+    EpochManager epochs;
+    atomic<const StoreRoot*> root;
+    unique_ptr<ShardLock[]> shardLocks;
+    size_t shardCount;
+    BudgetWriter writer;
+    FileLock ownerLock;
+    string path;
+
+    // Delete the current state (nothing may be reading)
+    void destroyRoot() {
+        const StoreRoot* current = root.exchange(nullptr);
+        if (!current) return;
+        for (const StoreShard* shard : current->shards) {
+            for (const UserBudgets* u : shard->users) delete u;
+            delete shard;
+        }
+        delete current;
+    }
+
+    // Build the initial state from the records already in the log
+    void replay() {
+        unordered_map<string, UserBudgets*> users;
+        size_t budgets = 0;
+        uint64_t records = 0;
+        auto apply = [&](const Budget& b) {
+            records++;
+            UserBudgets*& u = users[b.getUserName()];
+            if (!u) {
+                u = new UserBudgets();
+                u->user = b.getUserName();
+            }
+            for (Budget& existing : u->months) {
+                if (existing.getMonth() == b.getMonth()) {
+                    existing = b;
+                    return;
+                }
+            }
+            u->months.push_back(b);
+            budgets++;
+        };
+        VisitorBudgetSink<decltype(apply)> sink(apply);
+        BudgetTextParser parser;
+        parser.parseFile(path, sink);
+        if (!parser.errors().empty()) {
+            cerr << "Warning: " << parser.errors().size() << " malformed lines skipped in " << path << endl;
+        }
+
+        vector<StoreShard*> shards(shardCount);
+        for (StoreShard*& shard : shards) shard = new StoreShard();
+        for (auto& entry : users) shards[BudgetSnapshot::shardOf(entry.first, shardCount)]->users.push_back(entry.second);
+        StoreRoot* initial = new StoreRoot();
+        for (StoreShard* shard : shards) {
+            sort(shard->users.begin(), shard->users.end(),
+                 [](const UserBudgets* a, const UserBudgets* b) { return a->user < b->user; });
+            initial->shards.push_back(shard);
+        }
+        initial->sequence = records;
+        initial->budgetCount = budgets;
+        root.store(initial);
+    }
+
+public:
+    BudgetStore() : root(nullptr), shardCount(0) {}
+    ~BudgetStore() { close(); }
+
+    BudgetStore(const BudgetStore&) = delete;
+    BudgetStore& operator=(const BudgetStore&) = delete;
+
+    // Load the log at logPath (if any) and open it for appending
+    bool open(const string& logPath, const Options& options = Options()) {
+        close();
+        path = logPath;
+        shardCount = max<size_t>(1, options.shards);
+        if (!ownerLock.tryLock(path + ".lock")) {
+            cerr << "Error: " << path << " is in use by another process!" << endl;
+            return false;
+        }
+        shardLocks.reset(new ShardLock[shardCount]);
+        replay();
+        if (!writer.open(path, options.writer)) {
+            cerr << "Error: Could not open " << path << " for writing!" << endl;
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    bool isOpen() const { return root.load() != nullptr; }
+
+    // Persist and publish one budget, replacing any for the same user and month
+    bool put(const Budget& budget) {
+        if (!budget.hasValidNames()) {
+            cerr << "Error: Invalid user name or month for " << path << "!" << endl;
+            return false;
+        }
+        
+        const string& user = budget.getUserName();
+        size_t s = BudgetSnapshot::shardOf(user, shardCount);
+        lock_guard<mutex> shardGuard(shardLocks[s].lock);
+
+        // Logged under the shard lock, so the log orders saves of a user
+        // exactly as they are published
+        if (!writer.append(budget)) {
+            cerr << "Error: Could not append to " << path << "!" << endl;
+            return false;
+        }
+
+        size_t slot = epochs.enter();
+        const StoreShard* oldShard = root.load()->shards[s];   // only this shard's writer replaces it
+        StoreShard* newShard = new StoreShard(*oldShard);
+        size_t i = oldShard->lowerBound(user);
+        const UserBudgets* oldUser = i < oldShard->users.size() && oldShard->users[i]->user == user ? oldShard->users[i] : nullptr;
+
+        UserBudgets* newUser = oldUser ? new UserBudgets(*oldUser) : new UserBudgets();
+        newUser->user = user;
+        size_t added = 1;
+        for (Budget& existing : newUser->months) {
+            if (existing.getMonth() == budget.getMonth()) {
+                existing = budget;
+                added = 0;
+                break;
+            }
+        }
+        if (added) newUser->months.push_back(budget);
+        if (oldUser) newShard->users[i] = newUser;
+        else newShard->users.insert(newShard->users.begin() + i, newUser);
+
+        // Other shards publish concurrently; retry until our root wins
+        StoreRoot* next = new StoreRoot();
+        const StoreRoot* current = root.load();
+        do {
+            *next = *current;
+            next->shards[s] = newShard;
+            next->sequence = current->sequence + 1;
+            next->budgetCount = current->budgetCount + added;
+        } while (!root.compare_exchange_weak(current, next));
+        epochs.exit(slot);
+
+        epochs.retire(current);
+        epochs.retire(oldShard);
+        epochs.retire(oldUser);
+        return true;
+    }
+
+    // Consistent view of every budget published so far
+    BudgetSnapshot snapshot() { return BudgetSnapshot(epochs, root); }
+
+    // Copy of the latest budget for user and month
+    bool get(const string& user, const string& month, Budget& result) {
+        BudgetSnapshot view = snapshot();
+        const Budget* b = view.find(user, month);
+        if (b) result = *b;
+        return b != nullptr;
+    }
+
+    vector<string> months(const string& user) {
+        BudgetSnapshot view = snapshot();
+        vector<string> result;
+        if (const UserBudgets* u = view.findUser(user)) {
+            for (const Budget& b : u->months) result.push_back(b.getMonth());
+        }
+        return result;
+    }
+
+    size_t size() { return snapshot().size(); }
+    size_t getShardCount() const { return shardCount; }
+    size_t pendingReclaim() { return epochs.pending(); }
+
+    // Commit batched log records
+    bool flush() { return writer.flush(); }
+
+    // Flush the log and drop the in-memory state; no snapshot may be alive
+    void close() {
+        writer.close();
+        destroyRoot();
+        ownerLock.unlock();
+    }
+};
+
+#endif
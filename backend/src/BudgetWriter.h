@@ -0,0 +1,240 @@
+#ifndef BUDGETWRITER_H
+#define BUDGETWRITER_H
+
+#include "Budget.h"
+#include "ColumnarStore.h"
+#include "SystemIO.h"
+#include <charconv>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// What a commit guarantees once it returns
+enum DurabilityMode {
+    DURABILITY_NONE,        // handed to the OS with write()
+    DURABILITY_FDATASYNC    // fdatasync after every batch
+};
+
+struct WriterOptions {
+    size_t batchSize;                   // commit once this many records are pending
+    chrono::milliseconds maxLatency;    // or once the oldest pending record is this old
+    DurabilityMode durability;
+
+    WriterOptions(size_t batch = 1, chrono::milliseconds latency = chrono::milliseconds(0),
+                  DurabilityMode mode = DURABILITY_NONE)
+        : batchSize(batch), maxLatency(latency), durability(mode) {}
+};
+
+// Persistent text-format writer with group commit.
+// Records are serialized into a reusable buffer; a batch is written with a
+// single write() (plus an optional fdatasync) when it reaches batchSize or
+// when the background flusher sees it has waited maxLatency.
+class BudgetWriter {
+private:
+    AppendFile file;
+    WriterOptions options;
+    string pending;         // records waiting for the next commit
+    string committing;      // buffer being written, swapped with pending
+    size_t pendingCount;
+    uint64_t nextOffset;    // file offset the next record will land at
+    uint64_t committedEnd;  // everything before this offset is committed
+    chrono::steady_clock::time_point oldestPending;
+    atomic<size_t> commitCount;
+
+    mutex appendMutex;      // guards pending
+    mutex commitMutex;      // serializes commits so batches stay in order
+    condition_variable flusherWake;
+    thread flusher;
+    bool stopping;
+    atomic<bool> failed;
+
+    static void appendNumber(string& out, Money value) {
+        char digits[Money::MAX_CHARS];
+        out.append(digits, value.toChars(digits, digits + sizeof(digits)));
+    }
+
+    // Write everything pending as one batch; caller must not hold appendMutex
+    bool commit() {
+        lock_guard<mutex> commitLock(commitMutex);
+        uint64_t batchEnd;
+        {
+            lock_guard<mutex> lock(appendMutex);
+            if (pending.empty()) return !failed;
+            committing.swap(pending);
+            pending.clear();
+            pendingCount = 0;
+            batchEnd = nextOffset;
+        }
+        BUDGET_STAT_TIMER(TIMER_COMMIT);
+
+        bool ok = file.write(committing.data(), committing.size());
+        if (ok && options.durability == DURABILITY_FDATASYNC) ok = file.sync();
+        committing.clear();
+        commitCount++;
+        if (ok) {
+            lock_guard<mutex> lock(appendMutex);
+            committedEnd = batchEnd;
+        } else {
+            failed = true;
+        }
+        return ok;
+    }
+
+    void flusherLoop() {
+        unique_lock<mutex> lock(appendMutex);
+        while (!stopping) {
+            flusherWake.wait_for(lock, options.maxLatency);
+            if (pendingCount > 0 && chrono::steady_clock::now() - oldestPending >= options.maxLatency) {
+                lock.unlock();
+                commit();
+                lock.lock();
+            }
+        }
+    }
+
+    // Queue one serialized record, optionally reporting its file offset
+    void enqueue(const Budget& budget, uint64_t* offset) {
+        if (pendingCount == 0) oldestPending = chrono::steady_clock::now();
+        size_t before = pending.size();
+        serialize(budget, pending);
+        if (offset) *offset = nextOffset;
+        nextOffset += pending.size() - before;
+        pendingCount++;
+    }
+
+public:
+    static constexpr size_t MAX_BATCH_BYTES = 4 << 20;
+
+    BudgetWriter()
+        : pendingCount(0), nextOffset(0), committedEnd(0), commitCount(0), stopping(false), failed(false) {}
+    ~BudgetWriter() { close(); }
+
+    BudgetWriter(const BudgetWriter&) = delete;
+    BudgetWriter& operator=(const BudgetWriter&) = delete;
+
+    // File key of a numeric column; expense keys come from EXPENSE_CATEGORIES
+    static string_view key(int column) {
+        static const char* const incomeKeys[] = {"SALARY", "FREELANCE", "INVESTMENTS", "OTHER_INCOME"};
+        if (isExpenseColumn(column)) return expenseCategory(columnCategory(column)).fileKey;
+        if (column == COL_SAVINGS_GOAL) return "SAVINGS_GOAL";
+        return incomeKeys[column];
+    }
+
+    // Append one budget in the KEY:value text format
+    static void serialize(const Budget& budget, string& out) {
+        out += "USER:";
+        out += budget.getUserName();
+        out += "\nMONTH:";
+        out += budget.getMonth();
+        out += '\n';
+        for (int c = 0; c < NUM_BUDGET_COLUMNS; c++) {
+            out += key(c);
+            out += ':';
+            appendNumber(out, BudgetColumns::get(budget, c));
+            out += '\n';
+        }
+        out += "---\n";
+    }
+
+    bool open(const string& path, const WriterOptions& opts = WriterOptions()) {
+        close();
+        options = opts;
+        if (options.batchSize == 0) options.batchSize = 1;
+        failed = false;
+        stopping = false;
+        if (!file.open(path)) return false;
+        nextOffset = committedEnd = file.size();
+        if (options.batchSize > 1 && options.maxLatency.count() > 0) {
+            flusher = thread(&BudgetWriter::flusherLoop, this);
+        }
+        return true;
+    }
+
+    bool isOpen() const { return file.isOpen(); }
+    const WriterOptions& getOptions() const { return options; }
+    size_t getCommitCount() const { return commitCount; }
+
+    // End of the log once everything queued so far is committed
+    uint64_t endOffset() {
+        lock_guard<mutex> lock(appendMutex);
+        return nextOffset;
+    }
+
+    // Return once everything before end is committed; false if the commit
+    // covering it failed. Rather than sit out maxLatency the caller commits
+    // the pending batch itself, for everyone queued behind it too.
+    bool waitFor(uint64_t end) {
+        {
+            lock_guard<mutex> lock(appendMutex);
+            if (committedEnd >= end) return true;
+        }
+        commit();
+        lock_guard<mutex> lock(appendMutex);
+        return committedEnd >= end;
+    }
+
+    // Add one budget; commits when the batch fills up
+    bool append(const Budget& budget, uint64_t* offset = nullptr) {
+        bool full;
+        {
+            lock_guard<mutex> lock(appendMutex);
+            if (failed) return false;
+            enqueue(budget, offset);
+            full = pendingCount >= options.batchSize;
+        }
+        return full ? commit() : true;
+    }
+
+    // Add many budgets as one group; the buffer is committed every
+    // MAX_BATCH_BYTES and at the end once batchSize is reached
+    bool append(const Budget* budgets, size_t count, uint64_t* offsets = nullptr) {
+        for (size_t i = 0; i < count; ) {
+            bool full;
+            {
+                lock_guard<mutex> lock(appendMutex);
+                if (failed) return false;
+                while (i < count && pending.size() < MAX_BATCH_BYTES) {
+                    enqueue(budgets[i], offsets ? offsets + i : nullptr);
+                    i++;
+                }
+                full = pending.size() >= MAX_BATCH_BYTES || pendingCount >= options.batchSize;
+            }
+            if (full && !commit()) return false;
+        }
+        return true;
+    }
+
+    // Commit whatever is pending right now
+    bool flush() { return commit(); }
+
+    void close() {
+        if (flusher.joinable()) {
+            {
+                lock_guard<mutex> lock(appendMutex);
+                stopping = true;
+            }
+            flusherWake.notify_all();
+            flusher.join();
+        }
+        if (file.isOpen()) {
+            commit();
+            file.close();
+        }
+    }
+};
+
+// The records appended so far to one writer. Holding the ticket keeps the
+// writer alive, so it can be waited on after the handler replaced it.
+struct CommitTicket {
+    shared_ptr<BudgetWriter> writer;
+    uint64_t end;
+
+    CommitTicket() : end(0) {}
+
+    bool wait() const { return !writer || writer->waitFor(end); }
+};
+
+#endif
@@ -0,0 +1,205 @@
+#ifndef CATEGORYRULES_H
+#define CATEGORYRULES_H
+
+#include "BudgetParser.h"
+#include "CsvFields.h"
+#include <fstream>
+#include <queue>
+#include <sstream>
+
+// Maps merchant descriptions to budget columns with an Aho-Corasick
+// automaton over every rule pattern, so a description is classified in one
+// pass no matter how many rules there are. Rules files look like:
+//
+//   # comment
+//   groceries: whole foods, trader joe, safeway
+//   rent: property management, apartments
+//   salary: payroll
+//
+// The category is a budget file key in any case (RENT, OTHER_EXPENSES,
+// SALARY, OTHER_INCOME, ...) or an expense JSON key. Matching ignores case
+// and treats every run of non-alphanumeric bytes as one separator. Patterns
+// match whole words only: both the automaton input and every pattern are
+// framed by separators, so "rent" doesn't match "Parent" nor "at&t" "what
+// to". When several patterns match, the longest wins, then the one listed
+// first.
+class CategoryRules {
+public:
+    static constexpr int NO_MATCH = -1;
+
+private:
+    // a-z, 0-9 and one class for everything else
+    static constexpr int NUM_CLASSES = 37;
+    static constexpr int SEPARATOR = 0;
+
+    struct Rule {
+        string pattern;
+        int column;
+        uint32_t length;
+    };
+
+    vector<Rule> rules;
+    vector<int32_t> transitions;    // state * NUM_CLASSES + class -> state
+    vector<int32_t> best;           // state -> best rule ending here, or -1
+    uint8_t classOf[256];
+
+    void initClasses() {
+        for (int b = 0; b < 256; b++) {
+            if (b >= 'a' && b <= 'z') classOf[b] = static_cast<uint8_t>(b - 'a' + 1);
+            else if (b >= 'A' && b <= 'Z') classOf[b] = static_cast<uint8_t>(b - 'A' + 1);
+            else if (b >= '0' && b <= '9') classOf[b] = static_cast<uint8_t>(b - '0' + 27);
+            else classOf[b] = SEPARATOR;
+        }
+    }
+
+    bool better(int32_t candidate, int32_t current) const {
+        if (candidate < 0) return false;
+        if (current < 0) return true;
+        if (rules[candidate].length != rules[current].length) return rules[candidate].length > rules[current].length;
+        return candidate < current;
+    }
+
+    static int lookupCategory(string_view name) {
+        string key(name);
+        for (char& c : key) c = static_cast<char>(toupper(static_cast<unsigned char>(c)));
+        int column = BudgetTextParser::lookupKey(key);
+        if (column >= 0 && column < NUM_BUDGET_COLUMNS && column != COL_SAVINGS_GOAL) return column;
+        for (char& c : key) c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+        int category = findExpenseCategory<&CategoryDescriptor::jsonKey>(key);
+        return category < 0 ? NO_MATCH : expenseColumn(static_cast<ExpenseCategory>(category));
+    }
+
+    // Build the trie, then turn it into a full DFA with failure links
+    void build() {
+        transitions.assign(NUM_CLASSES, -1);
+        best.assign(1, -1);
+        for (size_t r = 0; r < rules.size(); r++) {
+            int32_t state = 0;
+            auto step = [&](int c) {
+                int32_t& next = transitions[state * NUM_CLASSES + c];
+                if (next < 0) {
+                    next = static_cast<int32_t>(best.size());
+                    best.push_back(-1);
+                    transitions.resize(transitions.size() + NUM_CLASSES, -1);
+                }
+                state = transitions[state * NUM_CLASSES + c];
+            };
+            // " pattern " with separator runs collapsed, as match() feeds the input
+            int previous = SEPARATOR;
+            step(SEPARATOR);
+            for (unsigned char b : rules[r].pattern) {
+                int c = classOf[b];
+                if (c != SEPARATOR || previous != SEPARATOR) step(c);
+                previous = c;
+            }
+            if (previous != SEPARATOR) step(SEPARATOR);
+            if (better(static_cast<int32_t>(r), best[state])) best[state] = static_cast<int32_t>(r);
+        }
+
+        vector<int32_t> fail(best.size(), 0);
+        queue<int32_t> pending;
+        for (int c = 0; c < NUM_CLASSES; c++) {
+            int32_t& next = transitions[c];
+            if (next < 0) {
+                next = 0;
+            } else {
+                fail[next] = 0;
+                pending.push(next);
+            }
+        }
+        while (!pending.empty()) {
+            int32_t state = pending.front();
+            pending.pop();
+            if (better(best[fail[state]], best[state])) best[state] = best[fail[state]];
+            for (int c = 0; c < NUM_CLASSES; c++) {
+                int32_t& next = transitions[state * NUM_CLASSES + c];
+                int32_t fallback = transitions[fail[state] * NUM_CLASSES + c];
+                if (next < 0) {
+                    next = fallback;
+                } else {
+                    fail[next] = fallback;
+                    pending.push(next);
+                }
+            }
+        }
+    }
+
+public:
+    CategoryRules() {
+        initClasses();
+        build();
+    }
+
+    // Parse rules text; bad lines are reported and skipped
+    bool loadText(const string& text, const string& source = "rules") {
+        rules.clear();
+        bool clean = true;
+        size_t lineNumber = 0;
+        size_t start = 0;
+        while (start < text.size()) {
+            size_t end = text.find('\n', start);
+            if (end == string::npos) end = text.size();
+            string_view line = CsvFields::trim(string_view(text).substr(start, end - start));
+            start = end + 1;
+            lineNumber++;
+            if (line.empty() || line[0] == '#') continue;
+
+            size_t colon = line.find(':');
+            int column = colon == string_view::npos ? NO_MATCH : lookupCategory(CsvFields::trim(line.substr(0, colon)));
+            if (column == NO_MATCH) {
+                cerr << "Warning: " << source << ":" << lineNumber << ": unknown category" << endl;
+                clean = false;
+                continue;
+            }
+            string_view patterns = line.substr(colon + 1);
+            while (!patterns.empty()) {
+                size_t comma = patterns.find(',');
+                string_view pattern = CsvFields::trim(patterns.substr(0, comma));
+                patterns.remove_prefix(comma == string_view::npos ? patterns.size() : comma + 1);
+                if (pattern.empty()) continue;
+                // Nothing but separators would match every description
+                if (all_of(pattern.begin(), pattern.end(), [&](char b) { return classOf[static_cast<unsigned char>(b)] == SEPARATOR; })) {
+                    cerr << "Warning: " << source << ":" << lineNumber << ": pattern without letters or digits" << endl;
+                    clean = false;
+                    continue;
+                }
+                rules.push_back({string(pattern), column, static_cast<uint32_t>(pattern.size())});
+            }
+        }
+        build();
+        return clean;
+    }
+
+    bool load(const string& path) {
+        ifstream file(path, ios::binary);
+        if (!file.is_open()) return false;
+        stringstream text;
+        text << file.rdbuf();
+        return loadText(text.str(), path);
+    }
+
+    size_t size() const { return rules.size(); }
+    size_t stateCount() const { return best.size(); }
+
+    // Budget column of the best matching rule, or NO_MATCH
+    int match(string_view description) const {
+        const int32_t* delta = transitions.data();
+        int32_t state = delta[SEPARATOR];
+        int32_t found = -1;
+        int previous = SEPARATOR;
+        for (unsigned char b : description) {
+            int c = classOf[b];
+            if (c == SEPARATOR && previous == SEPARATOR) continue;
+            previous = c;
+            state = delta[state * NUM_CLASSES + c];
+            if (better(best[state], found)) found = best[state];
+        }
+        if (previous != SEPARATOR) {
+            state = delta[state * NUM_CLASSES + SEPARATOR];
+            if (better(best[state], found)) found = best[state];
+        }
+        return found < 0 ? NO_MATCH : rules[found].column;
+    }
+};
+
+#endif
@@ -0,0 +1,237 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "ColumnarStore.h"
+#include "SystemIO.h"
+#include "Stats.h"
+#include <cstring>
+
+// Trailer of a checkpoint file. The body before it is a columnar file
+// holding every record of the log up to logOffset, in log order.
+struct CheckpointFooter {
+    char magic[4];
+    uint32_t version;
+    uint64_t logOffset;     // the checkpoint covers log bytes [0, logOffset)
+    uint64_t logTailHash;   // checksum of the log bytes just before logOffset
+    uint64_t records;
+    uint64_t bodyBytes;
+    uint64_t bodyHash;
+    uint64_t footerHash;    // checksum of the fields above
+};
+
+// Records a sink's last committed byte, so a load knows how far into the
+// log its budgets reach
+template<typename Sink>
+class CommitTracker {
+private:
+    Sink& inner;
+    uint64_t committedEnd;
+
+public:
+    CommitTracker(Sink& sink, uint64_t start) : inner(sink), committedEnd(start) {}
+
+    void begin() { inner.begin(); }
+    void setText(int key, string_view value) { inner.setText(key, value); }
+    void setValue(int column, Money value) { inner.setValue(column, value); }
+    void commit(uint64_t start, uint64_t end) {
+        inner.commit(start, end);
+        committedEnd = end;
+    }
+    void discard() { inner.discard(); }
+    void reserve(size_t expected) { inner.reserve(expected); }
+
+    uint64_t end() const { return committedEnd; }
+};
+
+// Binary snapshot of a text budget log, so a load maps the snapshot and
+// parses only the log written after it. Two generations are kept,
+// "<log>.ckpt" and "<log>.ckpt.prev". A checkpoint is used only if its
+// checksums hold and the log still ends the same way at logOffset;
+// otherwise open() falls back to the older one or to a full parse.
+class Checkpoint {
+private:
+    static constexpr char MAGIC[4] = {'B', 'G', 'C', 'K'};
+    static constexpr uint32_t VERSION = 1;
+    static constexpr size_t TAIL_BYTES = 4096;      // log bytes fingerprinted before logOffset
+
+    static constexpr uint64_t PRIME1 = 0x9E3779B185EBCA87ULL;
+    static constexpr uint64_t PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+
+    ColumnarReader reader;
+    CheckpointFooter footer;
+    bool valid;
+
+    static uint64_t mix(uint64_t acc, uint64_t word) {
+        acc += word * PRIME2;
+        acc = (acc << 31) | (acc >> 33);
+        return acc * PRIME1;
+    }
+
+    static uint64_t footerChecksum(const CheckpointFooter& f) {
+        return checksum(reinterpret_cast<const char*>(&f), offsetof(CheckpointFooter, footerHash));
+    }
+
+    // Checksum of the log bytes [offset - TAIL_BYTES, offset), false if the
+    // log is now shorter than offset
+    static bool logTail(const string& log, uint64_t offset, uint64_t& hash) {
+        FILE* file = fopen(log.c_str(), "rb");
+        if (!file) return false;
+        size_t length = static_cast<size_t>(min<uint64_t>(offset, TAIL_BYTES));
+        char bytes[TAIL_BYTES];
+        bool ok = streamSize(file) >= offset && seekFile(file, offset - length) &&
+                  fread(bytes, 1, length, file) == length;
+        fclose(file);
+        if (ok) hash = checksum(bytes, length);
+        return ok;
+    }
+
+    // Validate one checkpoint file against the log; why it was rejected
+    // goes to problem, empty if the file just doesn't exist
+    bool load(const string& path, const string& log, string& problem) {
+        valid = false;
+        MappedFile mapped;
+        if (!mapped.open(path)) return false;
+        if (mapped.size() < sizeof(ColumnarHeader) + sizeof(CheckpointFooter)) {
+            problem = "truncated";
+            return false;
+        }
+        memcpy(&footer, mapped.begin() + mapped.size() - sizeof(CheckpointFooter), sizeof(CheckpointFooter));
+        if (memcmp(footer.magic, MAGIC, 4) != 0 || footer.footerHash != footerChecksum(footer) ||
+            footer.bodyBytes != mapped.size() - sizeof(CheckpointFooter)) {
+            problem = "torn or damaged footer";
+            return false;
+        }
+        if (footer.version != VERSION) {
+            problem = "unsupported version " + to_string(footer.version);
+            return false;
+        }
+        if (checksum(mapped.begin(), static_cast<size_t>(footer.bodyBytes)) != footer.bodyHash) {
+            problem = "checksum mismatch";
+            return false;
+        }
+        uint64_t tailHash;
+        if (!logTail(log, footer.logOffset, tailHash) || tailHash != footer.logTailHash) {
+            problem = "the budget file was rewritten since";
+            return false;
+        }
+        mapped.close();
+        if (!reader.open(path) || reader.size() != footer.records) {
+            problem = "unreadable records";
+            return false;
+        }
+        valid = true;
+        return true;
+    }
+
+public:
+    Checkpoint() : footer(), valid(false) {}
+
+    Checkpoint(const Checkpoint&) = delete;
+    Checkpoint& operator=(const Checkpoint&) = delete;
+
+    static string pathFor(const string& log) { return log + ".ckpt"; }
+    static string previousPathFor(const string& log) { return log + ".ckpt.prev"; }
+
+    // 64-bit checksum over four independent lanes (xxHash64 rounds), fast
+    // enough to verify a snapshot at memory bandwidth on every start
+    static uint64_t checksum(const char* data, size_t size) {
+        uint64_t lanes[4] = {PRIME1 + PRIME2, PRIME2, 0, 0 - PRIME1};
+        size_t i = 0;
+        for (; i + 32 <= size; i += 32) {
+            for (int k = 0; k < 4; k++) {
+                uint64_t word;
+                memcpy(&word, data + i + k * 8, 8);
+                lanes[k] = mix(lanes[k], word);
+            }
+        }
+        uint64_t hash = static_cast<uint64_t>(size) * PRIME1;
+        for (int k = 0; k < 4; k++) hash = (hash ^ mix(0, lanes[k])) * PRIME1 + PRIME2;
+        for (; i + 8 <= size; i += 8) {
+            uint64_t word;
+            memcpy(&word, data + i, 8);
+            hash = mix(hash, word);
+        }
+        for (; i < size; i++) hash = mix(hash, static_cast<unsigned char>(data[i]));
+        hash ^= hash >> 33;
+        hash *= PRIME2;
+        hash ^= hash >> 29;
+        hash *= PRIME1;
+        return hash ^ (hash >> 32);
+    }
+
+    // Open the newest intact checkpoint that still matches log; false if
+    // there is none and the whole log has to be parsed. Damaged or stale
+    // checkpoints are deleted.
+    bool open(const string& log) {
+        const string paths[2] = {pathFor(log), previousPathFor(log)};
+        for (const string& path : paths) {
+            string problem;
+            if (load(path, log, problem)) {
+                BUDGET_STAT_ADD(STAT_CHECKPOINTS_LOADED, 1);
+                return true;
+            }
+            // A rejected checkpoint must not be rotated into the fallback slot
+            if (!problem.empty()) {
+                cerr << "Warning: Removing checkpoint " << path << ": " << problem << endl;
+                remove(path.c_str());
+            }
+        }
+        return false;
+    }
+
+    // Unmap the checkpoint; a new one can't replace it while mapped on Windows
+    void close() {
+        reader.close();
+        valid = false;
+    }
+
+    bool isOpen() const { return valid; }
+    uint64_t logOffset() const { return valid ? footer.logOffset : 0; }
+    const ColumnarReader& records() const { return reader; }
+
+    // Snapshot budgets, the log's records up to logOffset, as the newest
+    // checkpoint. The file is written and synced under a temporary name,
+    // then the current checkpoint becomes the previous one.
+    static bool write(const string& log, const vector<Budget>& budgets, uint64_t logOffset) {
+        string path = pathFor(log);
+        string temp = path + ".tmp";
+        if (!ColumnarStore::write(temp, budgets)) return false;
+
+        CheckpointFooter trailer = {};
+        memcpy(trailer.magic, MAGIC, 4);
+        trailer.version = VERSION;
+        trailer.logOffset = logOffset;
+        trailer.records = budgets.size();
+        bool ok = logTail(log, logOffset, trailer.logTailHash);
+        if (ok) {
+            MappedFile body;
+            ok = body.open(temp);
+            trailer.bodyBytes = body.size();
+            trailer.bodyHash = checksum(body.begin(), body.size());
+        }
+        trailer.footerHash = footerChecksum(trailer);
+
+        AppendFile out;
+        ok = ok && out.open(temp) && out.write(reinterpret_cast<const char*>(&trailer), sizeof(trailer)) && out.sync();
+        out.close();
+        if (ok) {
+            replaceFile(path, previousPathFor(log));
+            ok = replaceFile(temp, path);
+        }
+        if (!ok) {
+            cerr << "Error: Could not write checkpoint " << path << "!" << endl;
+            remove(temp.c_str());
+            return false;
+        }
+        BUDGET_STAT_ADD(STAT_CHECKPOINTS_WRITTEN, 1);
+        return true;
+    }
+
+    // Drop every checkpoint of log, after it was rewritten
+    static void removeAll(const string& log) {
+        remove(pathFor(log).c_str());
+        remove(previousPathFor(log).c_str());
+    }
+};
+
+#endif
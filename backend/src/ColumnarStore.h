@@ -0,0 +1,332 @@
+#ifndef COLUMNARSTORE_H
+#define COLUMNARSTORE_H
+
+#include "Budget.h"
+#include "SystemIO.h"
+#include "StringInterner.h"
+#include <fstream>
+#include <vector>
+#include <string_view>
+#include <cstring>
+
+// Numeric columns of the binary budget store, in file order
+enum BudgetColumn {
+    COL_SALARY,
+    COL_FREELANCE,
+    COL_INVESTMENTS,
+    COL_OTHER_INCOME,
+    COL_RENT,
+    COL_GROCERIES,
+    COL_UTILITIES,
+    COL_TRANSPORTATION,
+    COL_ENTERTAINMENT,
+    COL_HEALTHCARE,
+    COL_EDUCATION,
+    COL_SHOPPING,
+    COL_OTHER_EXPENSES,
+    COL_SAVINGS_GOAL,
+    NUM_BUDGET_COLUMNS
+};
+
+// Expense columns are COL_RENT + ExpenseCategory, in table order
+static_assert(COL_OTHER_EXPENSES - COL_RENT + 1 == NUM_EXPENSE_CATEGORIES,
+              "BudgetColumn needs one expense column per ExpenseCategory");
+
+constexpr bool isExpenseColumn(int column) { return column >= COL_RENT && column <= COL_OTHER_EXPENSES; }
+constexpr ExpenseCategory columnCategory(int column) { return static_cast<ExpenseCategory>(column - COL_RENT); }
+constexpr BudgetColumn expenseColumn(int category) { return static_cast<BudgetColumn>(COL_RENT + category); }
+
+// Maps a column to the matching Budget getter/setter
+struct BudgetColumns {
+    static Money get(const Budget& b, int column) {
+        if (isExpenseColumn(column)) return b.getExpense(columnCategory(column));
+        switch (column) {
+            case COL_SALARY: return b.getSalary();
+            case COL_FREELANCE: return b.getFreelance();
+            case COL_INVESTMENTS: return b.getInvestments();
+            case COL_OTHER_INCOME: return b.getOtherIncome();
+            case COL_SAVINGS_GOAL: return b.getSavingsGoal();
+        }
+        return Money();
+    }
+
+    static void set(Budget& b, int column, Money value) {
+        if (isExpenseColumn(column)) {
+            b.setExpense(columnCategory(column), value);
+            return;
+        }
+        switch (column) {
+            case COL_SALARY: b.setSalary(value); break;
+            case COL_FREELANCE: b.setFreelance(value); break;
+            case COL_INVESTMENTS: b.setInvestments(value); break;
+            case COL_OTHER_INCOME: b.setOtherIncome(value); break;
+            case COL_SAVINGS_GOAL: b.setSavingsGoal(value); break;
+        }
+    }
+};
+
+// On-disk layout (little-endian, every section 8-byte aligned):
+// Value columns are int64 cents since version 2 (version 1 stored doubles).
+//   header | user dictionary | month dictionary | user ids | month ids | value columns
+// A dictionary is uint32 offsets[count + 1] followed by the concatenated strings.
+struct ColumnarHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t recordCount;
+    uint32_t userCount;
+    uint32_t monthCount;
+    uint32_t columnCount;
+    uint32_t reserved;
+    uint64_t userDictOffset;
+    uint64_t monthDictOffset;
+    uint64_t userIdOffset;
+    uint64_t monthIdOffset;
+    uint64_t valueOffset;
+};
+
+class ColumnarStore {
+public:
+    static constexpr char MAGIC[4] = {'B', 'G', 'T', 'C'};
+    static constexpr uint32_t VERSION = 2;
+    static constexpr uint32_t MIN_VERSION = 1;
+
+    // Check whether a file starts with the columnar magic
+    static bool isColumnarFile(const string& path) {
+        ifstream file(path, ios::binary);
+        char magic[4];
+        return file.read(magic, 4) && memcmp(magic, MAGIC, 4) == 0;
+    }
+
+    // Write all budgets as a fresh columnar file
+    static bool write(const string& path, const vector<Budget>& budgets) {
+        StringInterner users, months;
+        vector<uint32_t> userIds, monthIds;
+        userIds.reserve(budgets.size());
+        monthIds.reserve(budgets.size());
+
+        for (const Budget& b : budgets) {
+            userIds.push_back(users.intern(b.getUserName()));
+            monthIds.push_back(months.intern(b.getMonth()));
+        }
+
+        string userDict = encodeDictionary(users);
+        string monthDict = encodeDictionary(months);
+
+        ColumnarHeader header = {};
+        memcpy(header.magic, MAGIC, 4);
+        header.version = VERSION;
+        header.recordCount = budgets.size();
+        header.userCount = static_cast<uint32_t>(users.size());
+        header.monthCount = static_cast<uint32_t>(months.size());
+        header.columnCount = NUM_BUDGET_COLUMNS;
+        header.userDictOffset = align(sizeof(ColumnarHeader));
+        header.monthDictOffset = align(header.userDictOffset + userDict.size());
+        header.userIdOffset = align(header.monthDictOffset + monthDict.size());
+        header.monthIdOffset = align(header.userIdOffset + userIds.size() * sizeof(uint32_t));
+        header.valueOffset = align(header.monthIdOffset + monthIds.size() * sizeof(uint32_t));
+
+        ofstream file(path, ios::binary | ios::trunc);
+        if (!file.is_open()) {
+            cerr << "Error: Could not open columnar file for writing!" << endl;
+            return false;
+        }
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        writeAt(file, header.userDictOffset, userDict.data(), userDict.size());
+        writeAt(file, header.monthDictOffset, monthDict.data(), monthDict.size());
+        writeAt(file, header.userIdOffset, userIds.data(), userIds.size() * sizeof(uint32_t));
+        writeAt(file, header.monthIdOffset, monthIds.data(), monthIds.size() * sizeof(uint32_t));
+
+        padTo(file, header.valueOffset);
+        vector<int64_t> column(budgets.size());
+        for (int c = 0; c < NUM_BUDGET_COLUMNS; c++) {
+            for (size_t i = 0; i < budgets.size(); i++) {
+                column[i] = BudgetColumns::get(budgets[i], c).getCents();
+            }
+            file.write(reinterpret_cast<const char*>(column.data()), column.size() * sizeof(int64_t));
+        }
+
+        return static_cast<bool>(file);
+    }
+
+    // Write aside, sync and rename over, so a failed rewrite keeps the old file
+    static bool replace(const string& path, const vector<Budget>& budgets) {
+        string temp = path + ".tmp";
+        AppendFile synced;
+        if (!write(temp, budgets) || !synced.open(temp) || !synced.sync()) {
+            cerr << "Error: Could not write columnar file " << path << "!" << endl;
+            synced.close();
+            remove(temp.c_str());
+            return false;
+        }
+        synced.close();
+        if (!replaceFile(temp, path)) {
+            cerr << "Error: Could not replace " << path << "!" << endl;
+            remove(temp.c_str());
+            return false;
+        }
+        return true;
+    }
+
+private:
+    static uint64_t align(uint64_t offset) { return (offset + 7) & ~uint64_t(7); }
+
+    static string encodeDictionary(const StringInterner& values) {
+        vector<uint32_t> offsets;
+        string blob;
+        offsets.push_back(0);
+        for (uint32_t id = 0; id < values.size(); id++) {
+            blob += values.lookup(id);
+            offsets.push_back(static_cast<uint32_t>(blob.size()));
+        }
+        string out(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(uint32_t));
+        return out + blob;
+    }
+
+    static void padTo(ofstream& file, uint64_t offset) {
+        uint64_t pos = static_cast<uint64_t>(file.tellp());
+        static const char zeros[8] = {};
+        if (offset > pos) file.write(zeros, offset - pos);
+    }
+
+    static void writeAt(ofstream& file, uint64_t offset, const void* data, size_t size) {
+        padTo(file, offset);
+        file.write(static_cast<const char*>(data), size);
+    }
+};
+
+// Zero-copy view over a mapped columnar file
+class ColumnarReader {
+private:
+    MappedFile mapped;
+    ColumnarHeader header;
+    const uint32_t* userDict;
+    const uint32_t* monthDict;
+    const uint32_t* userIdColumn;
+    const uint32_t* monthIdColumn;
+    const int64_t* valueColumns;
+    vector<int64_t> convertedColumns;   // version 1 files, converted from doubles
+    bool valid;
+
+    // count elements of elementBytes at offset; divides so a huge count can't wrap
+    bool sectionFits(uint64_t offset, uint64_t count, uint64_t elementBytes) const {
+        return offset <= mapped.size() && count <= (mapped.size() - offset) / elementBytes;
+    }
+
+    // count + 1 blob offsets that never decrease, with the blob inside the file
+    bool dictionaryFits(uint64_t offset, uint32_t count) const {
+        if (!sectionFits(offset, count + 1ULL, sizeof(uint32_t))) return false;
+        const uint32_t* dict = reinterpret_cast<const uint32_t*>(mapped.begin() + offset);
+        for (uint32_t i = 0; i < count; i++) {
+            if (dict[i + 1] < dict[i]) return false;
+        }
+        uint64_t blob = offset + (count + 1ULL) * sizeof(uint32_t);
+        return dict[count] <= mapped.size() - blob;
+    }
+
+    string_view lookup(const uint32_t* dict, uint32_t count, uint32_t id) const {
+        if (id >= count) return string_view();
+        const char* blob = reinterpret_cast<const char*>(dict + count + 1);
+        return string_view(blob + dict[id], dict[id + 1] - dict[id]);
+    }
+
+public:
+    ColumnarReader() : header(), userDict(nullptr), monthDict(nullptr), userIdColumn(nullptr),
+                       monthIdColumn(nullptr), valueColumns(nullptr), valid(false) {}
+
+    explicit ColumnarReader(const string& path) : ColumnarReader() { open(path); }
+
+    // Map the file and validate its header
+    bool open(const string& path) {
+        valid = false;
+        if (!mapped.open(path) || mapped.size() < sizeof(ColumnarHeader)) return false;
+
+        memcpy(&header, mapped.begin(), sizeof(header));
+        if (memcmp(header.magic, ColumnarStore::MAGIC, 4) != 0) {
+            cerr << "Error: " << path << " is not a columnar budget file!" << endl;
+            return false;
+        }
+        if (header.version < ColumnarStore::MIN_VERSION || header.version > ColumnarStore::VERSION ||
+            header.columnCount != NUM_BUDGET_COLUMNS) {
+            cerr << "Error: Unsupported columnar file version " << header.version << "!" << endl;
+            return false;
+        }
+
+        uint64_t n = header.recordCount;
+        if (!sectionFits(header.userIdOffset, n, sizeof(uint32_t)) ||
+            !sectionFits(header.monthIdOffset, n, sizeof(uint32_t)) ||
+            !sectionFits(header.valueOffset, n, sizeof(int64_t) * NUM_BUDGET_COLUMNS)) {
+            cerr << "Error: Columnar file is truncated!" << endl;
+            return false;
+        }
+        if (!dictionaryFits(header.userDictOffset, header.userCount) ||
+            !dictionaryFits(header.monthDictOffset, header.monthCount)) {
+            cerr << "Error: " << path << " is damaged (dictionary)!" << endl;
+            return false;
+        }
+
+        const char* base = mapped.begin();
+        userDict = reinterpret_cast<const uint32_t*>(base + header.userDictOffset);
+        monthDict = reinterpret_cast<const uint32_t*>(base + header.monthDictOffset);
+        userIdColumn = reinterpret_cast<const uint32_t*>(base + header.userIdOffset);
+        monthIdColumn = reinterpret_cast<const uint32_t*>(base + header.monthIdOffset);
+        if (header.version == 1) {
+            const double* legacy = reinterpret_cast<const double*>(base + header.valueOffset);
+            convertedColumns.resize(n * NUM_BUDGET_COLUMNS);
+            for (size_t i = 0; i < convertedColumns.size(); i++) {
+                convertedColumns[i] = Money::fromDouble(legacy[i]).getCents();
+            }
+            valueColumns = convertedColumns.data();
+        } else {
+            convertedColumns.clear();
+            valueColumns = reinterpret_cast<const int64_t*>(base + header.valueOffset);
+        }
+        valid = true;
+        return true;
+    }
+
+    void close() {
+        mapped.close();
+        convertedColumns.clear();
+        valid = false;
+    }
+
+    bool isValid() const { return valid; }
+    size_t size() const { return valid ? static_cast<size_t>(header.recordCount) : 0; }
+    uint32_t userCount() const { return header.userCount; }
+    uint32_t monthCount() const { return header.monthCount; }
+
+    // Raw column access, values in cents
+    const int64_t* column(BudgetColumn c) const { return valueColumns + c * size(); }
+    const uint32_t* userIds() const { return userIdColumn; }
+    const uint32_t* monthIds() const { return monthIdColumn; }
+
+    string_view userName(uint32_t id) const { return lookup(userDict, header.userCount, id); }
+    string_view month(uint32_t id) const { return lookup(monthDict, header.monthCount, id); }
+
+    // Sum one column without materializing any Budget
+    Money sum(BudgetColumn c) const {
+        const int64_t* values = column(c);
+        int64_t total = 0;
+        for (size_t i = 0; i < size(); i++) total += values[i];
+        return Money::fromCents(total);
+    }
+
+    // Materialize one record
+    Budget toBudget(size_t i) const {
+        Budget b(string(userName(userIdColumn[i])), string(month(monthIdColumn[i])));
+        for (int c = 0; c < NUM_BUDGET_COLUMNS; c++) {
+            BudgetColumns::set(b, c, Money::fromCents(valueColumns[c * size() + i]));
+        }
+        return b;
+    }
+
+    vector<Budget> toBudgets() const {
+        vector<Budget> budgets;
+        budgets.reserve(size());
+        for (size_t i = 0; i < size(); i++) budgets.push_back(toBudget(i));
+        return budgets;
+    }
+};
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef CSVFIELDS_H
+#define CSVFIELDS_H
+
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+// Field splitting shared by the CSV/TSV readers
+struct CsvFields {
+    static string_view trim(string_view s) {
+        while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+        while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r')) s.remove_suffix(1);
+        return s;
+    }
+
+    // Split one record into fields that view it. Quoted fields may hold the
+    // delimiter, newlines and "" for a quote; those needing unescaping are
+    // copied into unquoted. False if a quote is left open.
+    static bool split(string_view line, char delimiter, vector<string_view>& fields, deque<string>& unquoted) {
+        fields.clear();
+        size_t pos = 0;
+        while (true) {
+            size_t start = pos;
+            while (start < line.size() && line[start] == ' ') start++;
+            if (start < line.size() && line[start] == '"') {
+                size_t end = start + 1;
+                bool escaped = false;
+                while (true) {
+                    end = line.find('"', end);
+                    if (end == string_view::npos) return false;
+                    if (end + 1 < line.size() && line[end + 1] == '"') {
+                        escaped = true;
+                        end += 2;
+                        continue;
+                    }
+                    break;
+                }
+                string_view field = line.substr(start + 1, end - start - 1);
+                if (escaped) {
+                    unquoted.emplace_back();
+                    for (size_t i = 0; i < field.size(); i++) {
+                        unquoted.back() += field[i];
+                        if (field[i] == '"') i++;
+                    }
+                    field = unquoted.back();
+                }
+                fields.push_back(field);
+                pos = line.find(delimiter, end + 1);
+            } else {
+                pos = line.find(delimiter, start);
+                fields.push_back(trim(line.substr(start, pos == string_view::npos ? string_view::npos : pos - start)));
+            }
+            if (pos == string_view::npos) return true;
+            pos++;
+        }
+    }
+};
+
+#endif
@@ -2,72 +2,66 @@
 #define EXPENSE_H
 
 #include "User.h"
-#include <map>
+#include "ExpenseCategory.h"
+
+// One row of an expense breakdown
+struct ExpenseItem {
+    string_view name;
+    Money amount;
+};
+
+using ExpenseBreakdown = array<ExpenseItem, NUM_EXPENSE_CATEGORIES>;
 
 // Derived class demonstrating Inheritance
 class Expense : public User {
 protected:
-    double rent;
-    double groceries;
-    double utilities;
-    double transportation;
-    double entertainment;
-    double healthcare;
-    double education;
-    double shopping;
-    double otherExpenses;
+    ExpenseAmounts amounts;
     
 public:
-    Expense() : User(), rent(0), groceries(0), utilities(0), 
-                transportation(0), entertainment(0), healthcare(0),
-                education(0), shopping(0), otherExpenses(0) {}
+    Expense() : User(), amounts() {}
+    
+    Expense(string name, string mon) : User(name, mon), amounts() {}
     
-    Expense(string name, string mon) : User(name, mon),
-                                       rent(0), groceries(0), utilities(0),
-                                       transportation(0), entertainment(0),
-                                       healthcare(0), education(0),
-                                       shopping(0), otherExpenses(0) {}
+    // Access by category
+    Money getExpense(ExpenseCategory category) const { return amounts[category]; }
+    void setExpense(ExpenseCategory category, Money value) { amounts[category] = value; }
+    const ExpenseAmounts& getAmounts() const { return amounts; }
     
     // Setters
-    void setRent(double r) { rent = r; }
-    void setGroceries(double g) { groceries = g; }
-    void setUtilities(double u) { utilities = u; }
-    void setTransportation(double t) { transportation = t; }
-    void setEntertainment(double e) { entertainment = e; }
-    void setHealthcare(double h) { healthcare = h; }
-    void setEducation(double ed) { education = ed; }
-    void setShopping(double s) { shopping = s; }
-    void setOtherExpenses(double o) { otherExpenses = o; }
+    void setRent(Money r) { amounts[EXP_RENT] = r; }
+    void setGroceries(Money g) { amounts[EXP_GROCERIES] = g; }
+    void setUtilities(Money u) { amounts[EXP_UTILITIES] = u; }
+    void setTransportation(Money t) { amounts[EXP_TRANSPORTATION] = t; }
+    void setEntertainment(Money e) { amounts[EXP_ENTERTAINMENT] = e; }
+    void setHealthcare(Money h) { amounts[EXP_HEALTHCARE] = h; }
+    void setEducation(Money ed) { amounts[EXP_EDUCATION] = ed; }
+    void setShopping(Money s) { amounts[EXP_SHOPPING] = s; }
+    void setOtherExpenses(Money o) { amounts[EXP_OTHER] = o; }
     
     // Getters
-    double getRent() const { return rent; }
-    double getGroceries() const { return groceries; }
-    double getUtilities() const { return utilities; }
-    double getTransportation() const { return transportation; }
-    double getEntertainment() const { return entertainment; }
-    double getHealthcare() const { return healthcare; }
-    double getEducation() const { return education; }
-    double getShopping() const { return shopping; }
-    double getOtherExpenses() const { return otherExpenses; }
+    Money getRent() const { return amounts[EXP_RENT]; }
+    Money getGroceries() const { return amounts[EXP_GROCERIES]; }
+    Money getUtilities() const { return amounts[EXP_UTILITIES]; }
+    Money getTransportation() const { return amounts[EXP_TRANSPORTATION]; }
+    Money getEntertainment() const { return amounts[EXP_ENTERTAINMENT]; }
+    Money getHealthcare() const { return amounts[EXP_HEALTHCARE]; }
+    Money getEducation() const { return amounts[EXP_EDUCATION]; }
+    Money getShopping() const { return amounts[EXP_SHOPPING]; }
+    Money getOtherExpenses() const { return amounts[EXP_OTHER]; }
     
     // Calculate total expenses
-    double getTotalExpenses() const {
-        return rent + groceries + utilities + transportation + 
-               entertainment + healthcare + education + shopping + otherExpenses;
+    Money getTotalExpenses() const {
+        Money total;
+        for (Money amount : amounts) total += amount;
+        return total;
     }
     
-    // Get expense breakdown as map
-    map<string, double> getExpenseBreakdown() const {
-        map<string, double> breakdown;
-        breakdown["Rent"] = rent;
-        breakdown["Groceries"] = groceries;
-        breakdown["Utilities"] = utilities;
-        breakdown["Transportation"] = transportation;
-        breakdown["Entertainment"] = entertainment;
-        breakdown["Healthcare"] = healthcare;
-        breakdown["Education"] = education;
-        breakdown["Shopping"] = shopping;
-        breakdown["Other"] = otherExpenses;
+    // Get expense breakdown in category order, without allocating
+    ExpenseBreakdown getExpenseBreakdown() const {
+        ExpenseBreakdown breakdown;
+        for (const CategoryDescriptor& category : EXPENSE_CATEGORIES) {
+            breakdown[category.id] = ExpenseItem{category.displayName, amounts[category.id]};
+        }
         return breakdown;
     }
     
@@ -75,15 +69,9 @@ public:
     void display() override {
         User::display();
         cout << "\n--- Expense Details ---" << endl;
-        cout << "Rent: $" << rent << endl;
-        cout << "Groceries: $" << groceries << endl;
-        cout << "Utilities: $" << utilities << endl;
-        cout << "Transportation: $" << transportation << endl;
-        cout << "Entertainment: $" << entertainment << endl;
-        cout << "Healthcare: $" << healthcare << endl;
-        cout << "Education: $" << education << endl;
-        cout << "Shopping: $" << shopping << endl;
-        cout << "Other: $" << otherExpenses << endl;
+        forEachExpense<&CategoryDescriptor::displayName>(amounts, [](string_view name, Money amount) {
+            cout << name << ": $" << amount << endl;
+        });
         cout << "Total Expenses: $" << getTotalExpenses() << endl;
     }
 };
@@ -0,0 +1,81 @@
+#ifndef EXPENSECATEGORY_H
+#define EXPENSECATEGORY_H
+
+#include "Money.h"
+#include <array>
+#include <string_view>
+
+using namespace std;
+
+// Expense categories, in storage and display order
+enum ExpenseCategory {
+    EXP_RENT,
+    EXP_GROCERIES,
+    EXP_UTILITIES,
+    EXP_TRANSPORTATION,
+    EXP_ENTERTAINMENT,
+    EXP_HEALTHCARE,
+    EXP_EDUCATION,
+    EXP_SHOPPING,
+    EXP_OTHER,
+    NUM_EXPENSE_CATEGORIES
+};
+
+// Everything that names a category: the menu label, the text file key,
+// the JSON key and the interactive prompt
+struct CategoryDescriptor {
+    ExpenseCategory id;
+    string_view displayName;
+    string_view fileKey;
+    string_view jsonKey;
+    string_view prompt;
+};
+
+// The one place the categories are spelled out
+inline constexpr CategoryDescriptor EXPENSE_CATEGORIES[] = {
+    {EXP_RENT,           "Rent",           "RENT",           "rent",           "rent/mortgage"},
+    {EXP_GROCERIES,      "Groceries",      "GROCERIES",      "groceries",      "groceries"},
+    {EXP_UTILITIES,      "Utilities",      "UTILITIES",      "utilities",      "utilities (electricity, water, etc.)"},
+    {EXP_TRANSPORTATION, "Transportation", "TRANSPORTATION", "transportation", "transportation"},
+    {EXP_ENTERTAINMENT,  "Entertainment",  "ENTERTAINMENT",  "entertainment",  "entertainment"},
+    {EXP_HEALTHCARE,     "Healthcare",     "HEALTHCARE",     "healthcare",     "healthcare"},
+    {EXP_EDUCATION,      "Education",      "EDUCATION",      "education",      "education"},
+    {EXP_SHOPPING,       "Shopping",       "SHOPPING",       "shopping",       "shopping"},
+    {EXP_OTHER,          "Other",          "OTHER_EXPENSES", "other",          "other expenses"},
+};
+
+constexpr bool expenseTableMatchesEnum() {
+    for (size_t i = 0; i < NUM_EXPENSE_CATEGORIES; i++) {
+        if (EXPENSE_CATEGORIES[i].id != static_cast<ExpenseCategory>(i)) return false;
+    }
+    return true;
+}
+
+static_assert(sizeof(EXPENSE_CATEGORIES) / sizeof(EXPENSE_CATEGORIES[0]) == NUM_EXPENSE_CATEGORIES,
+              "EXPENSE_CATEGORIES needs one row per ExpenseCategory");
+static_assert(expenseTableMatchesEnum(), "EXPENSE_CATEGORIES rows must follow enum order");
+
+constexpr const CategoryDescriptor& expenseCategory(size_t category) { return EXPENSE_CATEGORIES[category]; }
+
+// Amount per category
+using ExpenseAmounts = array<Money, NUM_EXPENSE_CATEGORIES>;
+
+// Category whose Key field (e.g. &CategoryDescriptor::jsonKey) equals
+// name, or -1
+template<string_view CategoryDescriptor::*Key>
+constexpr int findExpenseCategory(string_view name) {
+    for (const CategoryDescriptor& category : EXPENSE_CATEGORIES) {
+        if (category.*Key == name) return category.id;
+    }
+    return -1;
+}
+
+// Call emit(key, amount) for every category, keyed by the chosen field
+template<string_view CategoryDescriptor::*Key, typename Emit>
+void forEachExpense(const ExpenseAmounts& amounts, Emit emit) {
+    for (const CategoryDescriptor& category : EXPENSE_CATEGORIES) {
+        emit(category.*Key, amounts[category.id]);
+    }
+}
+
+#endif
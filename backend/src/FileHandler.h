@@ -2,97 +2,550 @@
 #define FILEHANDLER_H
 
 #include "Budget.h"
+#include "ColumnarStore.h"
+#include "BudgetParser.h"
+#include "BudgetWriter.h"
+#include "BudgetIndex.h"
+#include "LogCompactor.h"
+#include "Checkpoint.h"
+#include "HistoryCodec.h"
+#include "BudgetRecord.h"
+#include "JsonExporter.h"
 #include <fstream>
 #include <sstream>
 #include <vector>
+#include <memory>
+
+// Storage backends supported by FileHandler
+enum StorageFormat {
+    TEXT_FORMAT,        // KEY:value lines, one block per budget
+    COLUMNAR_FORMAT,    // Binary columnar file, see ColumnarStore.h
+    HISTORY_FORMAT      // Delta encoded per-user history, see HistoryCodec.h
+};
 
 class FileHandler {
 private:
     string filename;
+    StorageFormat format;
+    vector<ParseError> parseErrors;
+    WriterOptions writerOptions;
+    HistoryWriteOptions historyOptions;
+    shared_ptr<BudgetWriter> writer;   // opened on first save, kept open
+    unique_ptr<FileLock> ownerLock;    // filename + ".lock", taken on first write, kept
+    unique_ptr<BudgetIndex> index;     // opened on first lookup, then kept current
+    unique_ptr<LogCompactor> compactor; // background compaction in progress
+    CompactionPolicy compactionPolicy;
+    bool autoCompact = false;
+    CompactionReport lastCompaction;
+    uint64_t checkpointInterval = 0;    // log bytes replayed before a new checkpoint; 0 = never write one
+    
+    BudgetWriter* getWriter() {
+        if (!writer) {
+            if (!lockForWriting()) return nullptr;
+            writer.reset(new BudgetWriter());
+            if (!writer->open(filename, writerOptions)) {
+                writer.reset();
+                cerr << "Error: Could not open file for writing!" << endl;
+                return nullptr;
+            }
+        }
+        return writer.get();
+    }
+    
+    // Commit and close the writer; a CommitTicket may still hold the object
+    void closeWriter() {
+        if (writer) writer->close();
+        writer.reset();
+    }
+    
+    BudgetIndex* getIndex() {
+        if (!index) {
+            flush();
+            index.reset(new BudgetIndex());
+            if (!index->open(filename)) {
+                index.reset();
+                cerr << "Error: Could not open budget index!" << endl;
+                return nullptr;
+            }
+        }
+        return index.get();
+    }
+    
+    // Columnar files are rewritten as a whole, so an append is load + rewrite
+    bool saveColumnar(const Budget* budgets, size_t count) {
+        if (!lockForWriting()) return false;
+        vector<Budget> all;
+        if (!loadColumnar(all)) {
+            cerr << "Error: Not overwriting unreadable " << filename << "!" << endl;
+            return false;
+        }
+        all.insert(all.end(), budgets, budgets + count);
+        return ColumnarStore::replace(filename, all);
+    }
+    
+    // Start a background compaction when the policy says so, and install
+    // one that has finished; runs after each text save
+    void checkCompaction() {
+        if (compactor) {
+            if (compactor->ready() && !finishCompaction(lastCompaction)) {
+                cerr << "Warning: Automatic compaction disabled after a failure" << endl;
+                autoCompact = false;
+            }
+            return;
+        }
+        BudgetIndex* idx = getIndex();
+        if (idx && compactionPolicy.due(writer ? writer->endOffset() : 0, idx->getTotalRecords(), idx->getLiveRecords())) {
+            startCompaction();
+        }
+    }
+    
+    // Run the streaming text parser from startOffset and report malformed lines
+    template<typename Sink>
+    bool parseText(Sink& sink, uint64_t startOffset = 0) {
+        BudgetTextParser parser;
+        bool opened = parser.parseFile(filename, sink, startOffset);
+        parseErrors = parser.errors();
+        BUDGET_STAT_ADD(STAT_PARSE_ERRORS, parseErrors.size());
+        for (size_t i = 0; i < parseErrors.size() && i < 10; i++) {
+            cerr << "Warning: " << filename << ":" << parseErrors[i].line << ": "
+                 << parseErrors[i].message << endl;
+        }
+        if (parseErrors.size() > 10) {
+            cerr << "Warning: " << parseErrors.size() - 10 << " more malformed lines skipped" << endl;
+        }
+        return opened;
+    }
+    
+    uint64_t logSize() const {
+        FILE* file = fopen(filename.c_str(), "rb");
+        if (!file) return 0;
+        uint64_t size = streamSize(file);
+        fclose(file);
+        return size;
+    }
+    
+    bool checkpointDue(const Checkpoint& checkpoint) const {
+        return checkpointInterval > 0 && logSize() - checkpoint.logOffset() >= checkpointInterval;
+    }
+    
+    // The budgets of an open (or absent) checkpoint plus the log after it.
+    // A new checkpoint is written when force is set or the replayed tail
+    // reached checkpointInterval.
+    bool loadTextBudgets(vector<Budget>& budgets, Checkpoint& checkpoint, bool force = false) {
+        uint64_t start = checkpoint.logOffset();
+        if (checkpoint.isOpen()) budgets = checkpoint.records().toBudgets();
+        checkpoint.close();
+        
+        VectorBudgetSink inner(budgets);
+        CommitTracker<VectorBudgetSink> sink(inner, start);
+        if (!parseText(sink, start)) return false;
+        bool due = force || (checkpointInterval > 0 && sink.end() - start >= checkpointInterval);
+        // A failed automatic checkpoint doesn't fail the load
+        if (due && sink.end() > 0) return Checkpoint::write(filename, budgets, sink.end()) || !force;
+        return true;
+    }
+    
+    static void appendRecords(const ColumnarReader& reader, BudgetRecordSet& result) {
+        size_t first = result.records.size();
+        result.records.resize(first + reader.size());
+        for (size_t i = 0; i < reader.size(); i++) {
+            BudgetRecord& record = result.records[first + i];
+            record.userId = result.users.intern(reader.userName(reader.userIds()[i]));
+            record.monthId = result.months.intern(reader.month(reader.monthIds()[i]));
+            for (int c = 0; c < NUM_BUDGET_COLUMNS; c++) {
+                record.values[c] = Money::fromCents(reader.column(static_cast<BudgetColumn>(c))[i]);
+            }
+        }
+    }
+    
+    // History files are rewritten as a whole too
+    bool saveHistory(const Budget* budgets, size_t count) {
+        if (!lockForWriting()) return false;
+        vector<Budget> all;
+        if (!loadHistory(all)) {
+            cerr << "Error: Not overwriting unreadable " << filename << "!" << endl;
+            return false;
+        }
+        all.insert(all.end(), budgets, budgets + count);
+        return HistoryStore::write(filename, all, historyOptions);
+    }
+    
+    // False if the file exists but can't be decoded
+    bool loadHistory(vector<Budget>& budgets) {
+        HistoryReader reader;
+        if (!reader.open(filename)) {
+            if (ifstream(filename).is_open()) return false;
+            cerr << "Info: No existing budget file found." << endl;
+            return true;
+        }
+        VectorBudgetSink sink(budgets);
+        if (reader.decode(sink)) return true;
+        budgets.clear();
+        return false;
+    }
+    
+    // Parse the record at an index offset, true only if it has the expected key
+    bool readIndexed(uint64_t offset, const string& user, const string& month, Budget& result) {
+        bool found = false;
+        auto assign = [&](const Budget& b) {
+            if (b.getUserName() != user || b.getMonth() != month) return;
+            result = b;
+            found = true;
+        };
+        VisitorBudgetSink<decltype(assign)> sink(assign);
+        BudgetTextParser parser;
+        parser.parseFile(filename, sink, offset, 1);
+        return found;
+    }
+    
+    // False if the file exists but can't be read
+    bool loadColumnar(vector<Budget>& budgets) {
+        ColumnarReader reader;
+        if (!reader.open(filename)) {
+            if (ifstream(filename).is_open()) return false;
+            cerr << "Info: No existing budget file found." << endl;
+            return true;
+        }
+        budgets = reader.toBudgets();
+        return true;
+    }
     
 public:
-    FileHandler(string fname = "../data/budgets.txt") : filename(fname) {}
+    FileHandler(string fname = "../data/budgets.txt", StorageFormat fmt = TEXT_FORMAT)
+        : filename(fname), format(fmt) {}
     
-    // Save budget to file
-    bool saveBudget(const Budget& budget) {
-        ofstream file(filename, ios::app);
-        if (!file.is_open()) {
-            cerr << "Error: Could not open file for writing!" << endl;
+    const string& getFilename() const { return filename; }
+    StorageFormat getFormat() const { return format; }
+    
+    // One writing process per file, as BudgetStore enforces too. Taken by
+    // the first write and held from then on; long-running writers take it up front.
+    bool lockForWriting() {
+        if (ownerLock) return true;
+        unique_ptr<FileLock> lock(new FileLock());
+        if (!lock->tryLock(filename + ".lock")) {
+            cerr << "Error: " << filename << " is in use by another process!" << endl;
+            return false;
+        }
+        ownerLock = move(lock);
+        return true;
+    }
+    
+    // Convert an existing text budget file into the columnar format
+    static bool convertToColumnar(const string& textFile, const string& columnarFile) {
+        if (!ifstream(textFile).is_open()) {
+            cerr << "Error: Could not open " << textFile << " for conversion!" << endl;
+            return false;
+        }
+        FileHandler source(textFile, TEXT_FORMAT);
+        vector<Budget> budgets = source.loadBudgets();
+        return ColumnarStore::replace(columnarFile, budgets);
+    }
+    
+    // Convert an existing text budget file into the compressed history format
+    static bool convertToHistory(const string& textFile, const string& historyFile,
+                                 const HistoryWriteOptions& options = HistoryWriteOptions()) {
+        if (!ifstream(textFile).is_open()) {
+            cerr << "Error: Could not open " << textFile << " for conversion!" << endl;
             return false;
         }
+        FileHandler source(textFile, TEXT_FORMAT);
+        vector<Budget> budgets = source.loadBudgets();
+        return HistoryStore::write(historyFile, budgets, options);
+    }
+    
+    // Block size and compression of history files; used from the next save
+    void setHistoryOptions(const HistoryWriteOptions& options) {
+        historyOptions = options;
+    }
+    
+    // Batching and durability of the text writer; takes effect on the next save
+    void setWriterOptions(const WriterOptions& options) {
+        writerOptions = options;
+        closeWriter();
+    }
+    
+    // Save budget to file
+    bool saveBudget(const Budget& budget, CommitTicket* ticket = nullptr) {
+        return saveBudgets(&budget, 1, ticket);
+    }
+    
+    // Save many budgets through one group commit. A batching writer may
+    // return before the records are written; ticket->wait() blocks until
+    // they are. Other formats are written before this returns.
+    bool saveBudgets(const Budget* budgets, size_t count, CommitTicket* ticket = nullptr) {
+        BUDGET_STAT_TIMER(TIMER_SAVE);
+        BUDGET_STAT_ADD(STAT_BUDGETS_SAVED, count);
+        for (size_t i = 0; i < count; i++) {
+            if (!budgets[i].hasValidNames()) {
+                cerr << "Error: User name or month contains control characters!" << endl;
+                return false;
+            }
+        }
+        if (format == COLUMNAR_FORMAT) return saveColumnar(budgets, count);
+        if (format == HISTORY_FORMAT) return saveHistory(budgets, count);
         
-        file << "USER:" << budget.Income::getUserName() << endl;
-        file << "MONTH:" << budget.Income::getMonth() << endl;
-        file << "SALARY:" << budget.getSalary() << endl;
-        file << "FREELANCE:" << budget.getFreelance() << endl;
-        file << "INVESTMENTS:" << budget.getInvestments() << endl;
-        file << "OTHER_INCOME:" << budget.getOtherIncome() << endl;
-        file << "RENT:" << budget.getRent() << endl;
-        file << "GROCERIES:" << budget.getGroceries() << endl;
-        file << "UTILITIES:" << budget.getUtilities() << endl;
-        file << "TRANSPORTATION:" << budget.getTransportation() << endl;
-        file << "ENTERTAINMENT:" << budget.getEntertainment() << endl;
-        file << "HEALTHCARE:" << budget.getHealthcare() << endl;
-        file << "EDUCATION:" << budget.getEducation() << endl;
-        file << "SHOPPING:" << budget.getShopping() << endl;
-        file << "OTHER_EXPENSES:" << budget.getOtherExpenses() << endl;
-        file << "SAVINGS_GOAL:" << budget.getSavingsGoal() << endl;
-        file << "---" << endl;
+        BudgetWriter* out = getWriter();
+        if (!out) return false;
+        if (autoCompact) getIndex();
+        if (ticket) ticket->writer = writer;
+        if (!index) {
+            if (!out->append(budgets, count)) return false;
+            if (ticket) ticket->end = out->endOffset();
+            return true;
+        }
         
-        file.close();
+        vector<uint64_t> offsets(count);
+        if (!out->append(budgets, count, offsets.data())) return false;
+        if (ticket) ticket->end = out->endOffset();
+        for (size_t i = 0; i < count; i++) {
+            uint64_t end = i + 1 < count ? offsets[i + 1] : out->endOffset();
+            index->add(budgets[i].getUserName(), budgets[i].getMonth(), offsets[i], end);
+        }
+        if (!index->flush()) return false;
+        if (autoCompact) checkCompaction();
+        return true;
+    }
+    
+    bool saveBudgets(const vector<Budget>& budgets) {
+        return saveBudgets(budgets.data(), budgets.size());
+    }
+    
+    // Commit any batched records
+    bool flush() {
+        return writer ? writer->flush() : true;
+    }
+    
+    // Look up the latest budget saved for a user and month
+    bool findBudget(const string& user, const string& month, Budget& result) {
+        BUDGET_STAT_TIMER(TIMER_FIND);
+        BUDGET_STAT_ADD(STAT_INDEX_LOOKUPS, 1);
+        if (format != TEXT_FORMAT) {
+            bool found = false;
+            forEachBudget([&](const Budget& b) {
+                if (b.getUserName() == user && b.getMonth() == month) {
+                    result = b;
+                    found = true;
+                }
+            });
+            return found;
+        }
+        
+        BudgetIndex* idx = getIndex();
+        const IndexEntry* entry = idx ? idx->find(user, month) : nullptr;
+        if (!entry) return false;
+        
+        flush();
+        if (readIndexed(entry->offset, user, month, result)) return true;
+        
+        // The sidecar index points elsewhere (stale or edited), so rescan the log once
+        cerr << "Warning: Index for " << filename << " is out of date, rebuilding." << endl;
+        entry = idx->rebuild() ? idx->find(user, month) : nullptr;
+        return entry && readIndexed(entry->offset, user, month, result);
+    }
+    
+    // Months with a saved budget for a user
+    vector<string> listMonths(const string& user) {
+        if (format != TEXT_FORMAT) {
+            vector<string> months;
+            forEachBudget([&](const Budget& b) {
+                if (b.getUserName() == user && find(months.begin(), months.end(), b.getMonth()) == months.end()) {
+                    months.push_back(b.getMonth());
+                }
+            });
+            return months;
+        }
+        
+        BudgetIndex* idx = getIndex();
+        return idx ? idx->months(user) : vector<string>();
+    }
+    
+    // Compact the text log in the background whenever policy.due() holds;
+    // checked after every save
+    void setCompactionPolicy(const CompactionPolicy& policy) {
+        compactionPolicy = policy;
+        autoCompact = format == TEXT_FORMAT;
+    }
+    
+    // Begin rewriting the log without superseded records. Saves carry on
+    // meanwhile; finishCompaction() installs the result.
+    bool startCompaction() {
+        if (format != TEXT_FORMAT || compactor) return false;
+        if (!lockForWriting() || !flush()) return false;
+        FILE* file = fopen(filename.c_str(), "rb");
+        if (!file) return false;
+        uint64_t end = streamSize(file);
+        fclose(file);
+        compactor.reset(new LogCompactor());
+        return compactor->start(filename, end);
+    }
+    
+    // Wait for a started compaction and swap the new log in. The writer
+    // is reopened on the next save and the index rebuilt for the new file.
+    bool finishCompaction(CompactionReport& report) {
+        if (!compactor) return false;
+        closeWriter();
+        bool ok = compactor->finish(report);
+        compactor.reset();
+        if (ok) Checkpoint::removeAll(filename);
+        if (index) {
+            ok = index->rebuild() && ok;
+        } else {
+            remove(BudgetIndex::sidecarPathFor(filename).c_str());
+        }
+        return ok;
+    }
+    
+    // Compact the log now and wait for it
+    bool compact(CompactionReport& report) {
+        return startCompaction() && finishCompaction(report);
+    }
+    
+    bool isCompacting() const { return compactor != nullptr; }
+    
+    // Result of the last automatic compaction
+    const CompactionReport& getLastCompaction() const { return lastCompaction; }
+    
+    // Snapshot the text log every time a load had to replay at least
+    // bytes past the newest checkpoint; 0 turns writing checkpoints off.
+    // Existing checkpoints are used either way.
+    void setCheckpointInterval(uint64_t bytes) {
+        checkpointInterval = format == TEXT_FORMAT ? bytes : 0;
+    }
+    
+    // Checkpoint the whole text log now; reports the records and log bytes covered
+    bool writeCheckpoint(size_t& records, uint64_t& coveredBytes) {
+        if (format != TEXT_FORMAT) return false;
+        BUDGET_STAT_TIMER(TIMER_LOAD);
+        flush();
+        Checkpoint checkpoint;
+        checkpoint.open(filename);
+        vector<Budget> budgets;
+        if (!loadTextBudgets(budgets, checkpoint, true) || !checkpoint.open(filename)) return false;
+        records = budgets.size();
+        coveredBytes = checkpoint.logOffset();
         return true;
     }
     
+    // Rescan the log and rewrite the (user, month) index
+    bool rebuildIndex() {
+        if (format != TEXT_FORMAT) return true;
+        BudgetIndex* idx = getIndex();
+        return idx && idx->rebuild();
+    }
+    
     // Load budgets from file
     vector<Budget> loadBudgets() {
+        BUDGET_STAT_TIMER(TIMER_LOAD);
         vector<Budget> budgets;
-        ifstream file(filename);
-        
-        if (!file.is_open()) {
-            cerr << "Info: No existing budget file found." << endl;
-            return budgets;
+        if (format == COLUMNAR_FORMAT) {
+            if (!loadColumnar(budgets)) cerr << "Error: Could not read " << filename << "!" << endl;
+        } else if (format == HISTORY_FORMAT) {
+            loadHistory(budgets);
+        } else {
+            flush();
+            Checkpoint checkpoint;
+            checkpoint.open(filename);
+            if (!loadTextBudgets(budgets, checkpoint)) {
+                cerr << "Info: No existing budget file found." << endl;
+            }
+        }
+        BUDGET_STAT_ADD(STAT_BUDGETS_LOADED, budgets.size());
+        return budgets;
+    }
+    
+    // Load every stored budget as flat records with interned names
+    bool loadRecords(BudgetRecordSet& result) {
+        BUDGET_STAT_TIMER(TIMER_LOAD);
+        result.clear();
+        flush();
+        if (format == COLUMNAR_FORMAT) {
+            ColumnarReader reader;
+            if (!reader.open(filename)) return false;
+            appendRecords(reader, result);
+            BUDGET_STAT_ADD(STAT_BUDGETS_LOADED, result.records.size());
+            return true;
+        }
+        if (format == HISTORY_FORMAT) {
+            HistoryReader reader;
+            RecordSetSink sink(result);
+            bool ok = reader.open(filename) && reader.decode(sink);
+            BUDGET_STAT_ADD(STAT_BUDGETS_LOADED, result.records.size());
+            return ok;
         }
         
-        string line;
-        Budget currentBudget;
+        Checkpoint checkpoint;
+        if (checkpoint.open(filename)) appendRecords(checkpoint.records(), result);
+        RecordSetSink sink(result);
+        bool ok = parseText(sink, checkpoint.logOffset());
+        BUDGET_STAT_ADD(STAT_BUDGETS_LOADED, result.records.size());
+        return ok;
+    }
+    
+    // Stream every stored budget to a callback without building a vector
+    template<typename Visitor>
+    bool forEachBudget(Visitor visit) {
+        BUDGET_STAT_TIMER(TIMER_LOAD);
+        flush();
+        if (format == COLUMNAR_FORMAT) {
+            ColumnarReader reader;
+            if (!reader.open(filename)) return false;
+            for (size_t i = 0; i < reader.size(); i++) visit(static_cast<const Budget&>(reader.toBudget(i)));
+            BUDGET_STAT_ADD(STAT_BUDGETS_LOADED, reader.size());
+            return true;
+        }
+        if (format == HISTORY_FORMAT) {
+            HistoryReader reader;
+            if (!reader.open(filename)) return false;
+            VisitorBudgetSink<Visitor> sink(visit);
+            bool ok = reader.decode(sink);
+            BUDGET_STAT_ADD(STAT_BUDGETS_LOADED, reader.size());
+            return ok;
+        }
         
-        while (getline(file, line)) {
-            if (line == "---") {
-                budgets.push_back(currentBudget);
-                currentBudget = Budget();
-                continue;
-            }
-            
-            size_t pos = line.find(':');
-            if (pos != string::npos) {
-                string key = line.substr(0, pos);
-                string value = line.substr(pos + 1);
-                
-                if (key == "USER") currentBudget.Income::setUserName(value);
-                else if (key == "MONTH") currentBudget.Income::setMonth(value);
-                else if (key == "SALARY") currentBudget.setSalary(stod(value));
-                else if (key == "FREELANCE") currentBudget.setFreelance(stod(value));
-                else if (key == "INVESTMENTS") currentBudget.setInvestments(stod(value));
-                else if (key == "OTHER_INCOME") currentBudget.setOtherIncome(stod(value));
-                else if (key == "RENT") currentBudget.setRent(stod(value));
-                else if (key == "GROCERIES") currentBudget.setGroceries(stod(value));
-                else if (key == "UTILITIES") currentBudget.setUtilities(stod(value));
-                else if (key == "TRANSPORTATION") currentBudget.setTransportation(stod(value));
-                else if (key == "ENTERTAINMENT") currentBudget.setEntertainment(stod(value));
-                else if (key == "HEALTHCARE") currentBudget.setHealthcare(stod(value));
-                else if (key == "EDUCATION") currentBudget.setEducation(stod(value));
-                else if (key == "SHOPPING") currentBudget.setShopping(stod(value));
-                else if (key == "OTHER_EXPENSES") currentBudget.setOtherExpenses(stod(value));
-                else if (key == "SAVINGS_GOAL") currentBudget.setSavingsGoal(stod(value));
-            }
+        Checkpoint checkpoint;
+        checkpoint.open(filename);
+        if (checkpointDue(checkpoint)) {
+            // Materialize once so the snapshot can be written
+            vector<Budget> budgets;
+            bool ok = loadTextBudgets(budgets, checkpoint);
+            for (const Budget& b : budgets) visit(b);
+            BUDGET_STAT_ADD(STAT_BUDGETS_LOADED, budgets.size());
+            return ok;
         }
         
-        file.close();
-        return budgets;
+        size_t visited = 0;
+        auto counted = [&visit, &visited](const Budget& b) {
+            visited++;
+            visit(b);
+        };
+        const ColumnarReader& snapshot = checkpoint.records();
+        for (size_t i = 0; i < snapshot.size(); i++) counted(static_cast<const Budget&>(snapshot.toBudget(i)));
+        VisitorBudgetSink<decltype(counted)> sink(counted);
+        bool ok = parseText(sink, checkpoint.logOffset());
+        BUDGET_STAT_ADD(STAT_BUDGETS_LOADED, visited);
+        return ok;
+    }
+    
+    // Stream every stored budget into one JSON Lines / JSON array file,
+    // returns the number exported or -1 on error
+    long long exportAllToJSON(const string& jsonFile, const JsonExportOptions& options) {
+        BUDGET_STAT_TIMER(TIMER_EXPORT);
+        JsonExporter exporter;
+        if (!exporter.open(jsonFile, options)) return -1;
+        bool ok = forEachBudget([&exporter](const Budget& b) { exporter.write(b); });
+        if (!ok) cerr << "Error: Could not read budgets from " << filename << "!" << endl;
+        if (!exporter.close() || !ok) return -1;
+        BUDGET_STAT_ADD(STAT_BUDGETS_EXPORTED, exporter.getRecordCount());
+        return static_cast<long long>(exporter.getRecordCount());
     }
     
+    // Malformed lines found by the last text load
+    const vector<ParseError>& getParseErrors() const { return parseErrors; }
+    
     // Export to JSON format
     bool exportToJSON(const Budget& budget, const string& jsonFile) {
+        BUDGET_STAT_TIMER(TIMER_EXPORT);
+        BUDGET_STAT_ADD(STAT_BUDGETS_EXPORTED, 1);
         ofstream file(jsonFile);
         if (!file.is_open()) return false;
         
@@ -107,15 +560,9 @@ public:
         file << "    \"total\": " << budget.getTotalIncome() << "\n";
         file << "  },\n";
         file << "  \"expenses\": {\n";
-        file << "    \"rent\": " << budget.getRent() << ",\n";
-        file << "    \"groceries\": " << budget.getGroceries() << ",\n";
-        file << "    \"utilities\": " << budget.getUtilities() << ",\n";
-        file << "    \"transportation\": " << budget.getTransportation() << ",\n";
-        file << "    \"entertainment\": " << budget.getEntertainment() << ",\n";
-        file << "    \"healthcare\": " << budget.getHealthcare() << ",\n";
-        file << "    \"education\": " << budget.getEducation() << ",\n";
-        file << "    \"shopping\": " << budget.getShopping() << ",\n";
-        file << "    \"other\": " << budget.getOtherExpenses() << ",\n";
+        forEachExpense<&CategoryDescriptor::jsonKey>(budget.getAmounts(), [&file](string_view key, Money amount) {
+            file << "    \"" << key << "\": " << amount << ",\n";
+        });
         file << "    \"total\": " << budget.getTotalExpenses() << "\n";
         file << "  },\n";
         file << "  \"summary\": {\n";
@@ -0,0 +1,207 @@
+#ifndef GROCERYLEDGER_H
+#define GROCERYLEDGER_H
+
+#include "Arena.h"
+#include "Expense.h"
+#include "StringInterner.h"
+#include <map>
+
+// One grocery purchase. Item and store are ids into the ledger's
+// dictionaries, the date is packed as YYYYMMDD and quantities are kept in
+// thousandths so "1.5 kg" stays exact.
+struct GroceryLine {
+    uint32_t itemId;
+    uint32_t storeId;
+    uint32_t date;
+    uint32_t quantity;      // units * QUANTITY_SCALE
+    Money unitPrice;
+    Money amount;           // unitPrice * quantity, rounded to the cent
+};
+
+static_assert(is_trivially_copyable<GroceryLine>::value, "GroceryLine must stay memcpy-able");
+
+// Itemized grocery store. Lines live in fixed-size blocks carved from an
+// arena, so inserting never moves existing lines and costs no allocation
+// per line. Totals per month and per item are updated on every insert,
+// and bound Expense objects get their groceries amount kept in sync.
+class GroceryLedger {
+public:
+    static constexpr uint32_t QUANTITY_SCALE = 1000;
+    static constexpr size_t LINES_PER_BLOCK = 16384;
+
+private:
+    struct Binding {
+        Expense* expense;
+        uint32_t yearMonth;
+    };
+
+    Arena arena;
+    vector<GroceryLine*> blocks;
+    size_t count;
+    StringInterner items;
+    StringInterner stores;
+    vector<Money> itemTotals;           // by item id
+    map<uint32_t, Money> monthTotals;   // by YYYYMM
+    Money total;
+    vector<Binding> bindings;
+
+    // False if unitPrice * quantity (plus rounding) would overflow the cents
+    static bool amountFits(Money unitPrice, uint32_t quantity) {
+        int64_t limit = numeric_limits<int64_t>::max() - QUANTITY_SCALE / 2;
+        return quantity == 0 || unitPrice.getCents() <= limit / quantity;
+    }
+
+    static Money lineAmount(Money unitPrice, uint32_t quantity) {
+        int64_t product = (unitPrice * quantity).getCents();
+        int64_t half = QUANTITY_SCALE / 2;
+        return Money::fromCents((product >= 0 ? product + half : product - half) / QUANTITY_SCALE);
+    }
+
+public:
+    GroceryLedger() : arena(LINES_PER_BLOCK * sizeof(GroceryLine)), count(0) {}
+
+    GroceryLedger(const GroceryLedger&) = delete;
+    GroceryLedger& operator=(const GroceryLedger&) = delete;
+
+    // Parse "YYYY-MM-DD" into YYYYMMDD
+    static bool parseDate(string_view text, uint32_t& date) {
+        if (text.size() != 10 || text[4] != '-' || text[7] != '-') return false;
+        uint32_t year = 0, month = 0, day = 0;
+        for (int i = 0; i < 10; i++) {
+            if (i == 4 || i == 7) continue;
+            if (text[i] < '0' || text[i] > '9') return false;
+        }
+        for (int i = 0; i < 4; i++) year = year * 10 + (text[i] - '0');
+        month = (text[5] - '0') * 10 + (text[6] - '0');
+        day = (text[8] - '0') * 10 + (text[9] - '0');
+        if (month < 1 || month > 12 || day < 1 || day > daysInMonth(year * 100 + month)) return false;
+        date = year * 10000 + month * 100 + day;
+        return true;
+    }
+
+    static uint32_t yearMonthOf(uint32_t date) { return date / 100; }
+
+    // Length of YYYYMM, 0 for a month outside 1..12
+    static uint32_t daysInMonth(uint32_t yearMonth) {
+        static const uint32_t DAYS[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+        uint32_t year = yearMonth / 100, month = yearMonth % 100;
+        if (month < 1 || month > 12) return 0;
+        bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+        return DAYS[month - 1] + (month == 2 && leap ? 1 : 0);
+    }
+
+    // Record a purchase; quantity is in units, e.g. 1.5 for 1.5 kg
+    bool add(string_view item, double quantity, Money unitPrice, string_view store, uint32_t date) {
+        if (item.empty()) {
+            cerr << "Error: Grocery item needs a name!" << endl;
+            return false;
+        }
+        if (!(quantity > 0) || quantity * QUANTITY_SCALE > 4.0e9 || unitPrice < Money()) {
+            cerr << "Error: Invalid quantity or price for " << item << "!" << endl;
+            return false;
+        }
+        if (date % 100 < 1 || date % 100 > daysInMonth(yearMonthOf(date))) {
+            cerr << "Error: Invalid date " << date << " for " << item << "!" << endl;
+            return false;
+        }
+        // Totals only grow, so the grand total bounds every other one
+        uint32_t scaled = static_cast<uint32_t>(llround(quantity * QUANTITY_SCALE));
+        Money amount = amountFits(unitPrice, scaled) ? lineAmount(unitPrice, scaled) : Money();
+        if (!amountFits(unitPrice, scaled) || total.getCents() > numeric_limits<int64_t>::max() - amount.getCents()) {
+            cerr << "Error: Amount too large for " << item << "!" << endl;
+            return false;
+        }
+
+        if (count % LINES_PER_BLOCK == 0) blocks.push_back(arena.allocateArray<GroceryLine>(LINES_PER_BLOCK));
+        GroceryLine& line = blocks.back()[count % LINES_PER_BLOCK];
+        line.itemId = items.intern(item);
+        line.storeId = stores.intern(store);
+        line.date = date;
+        line.quantity = scaled;
+        line.unitPrice = unitPrice;
+        line.amount = amount;
+        count++;
+
+        if (line.itemId == itemTotals.size()) itemTotals.push_back(Money());
+        itemTotals[line.itemId] += line.amount;
+        Money& monthTotal = monthTotals[yearMonthOf(date)];
+        monthTotal += line.amount;
+        total += line.amount;
+
+        for (const Binding& binding : bindings) {
+            if (binding.yearMonth == yearMonthOf(date)) binding.expense->setGroceries(monthTotal);
+        }
+        return true;
+    }
+
+    // Record a purchase on a day of YYYYMM; a day past the month's end is
+    // refused rather than rolled into the next month
+    bool addInMonth(uint32_t yearMonth, uint32_t day, string_view item, double quantity, Money unitPrice,
+                    string_view store) {
+        if (day < 1 || day > daysInMonth(yearMonth)) {
+            cerr << "Error: Invalid day " << day << " for " << item << "!" << endl;
+            return false;
+        }
+        return add(item, quantity, unitPrice, store, yearMonth * 100 + day);
+    }
+
+    // Keep expense's groceries equal to the total for YYYYMM from now on
+    void bind(Expense& expense, uint32_t yearMonth) {
+        unbind(expense);
+        bindings.push_back({&expense, yearMonth});
+        expense.setGroceries(getMonthTotal(yearMonth));
+    }
+
+    void unbind(const Expense& expense) {
+        for (size_t i = 0; i < bindings.size(); i++) {
+            if (bindings[i].expense == &expense) {
+                bindings.erase(bindings.begin() + i);
+                return;
+            }
+        }
+    }
+
+    size_t size() const { return count; }
+    const GroceryLine& line(size_t i) const { return blocks[i / LINES_PER_BLOCK][i % LINES_PER_BLOCK]; }
+    const string& itemName(const GroceryLine& l) const { return items.lookup(l.itemId); }
+    const string& storeName(const GroceryLine& l) const { return stores.lookup(l.storeId); }
+
+    Money getTotal() const { return total; }
+
+    Money getMonthTotal(uint32_t yearMonth) const {
+        auto it = monthTotals.find(yearMonth);
+        return it == monthTotals.end() ? Money() : it->second;
+    }
+
+    Money getItemTotal(string_view item) const {
+        uint32_t id = items.find(item);
+        return id < itemTotals.size() ? itemTotals[id] : Money();
+    }
+
+    const map<uint32_t, Money>& getMonthTotals() const { return monthTotals; }
+    size_t itemCount() const { return items.size(); }
+    size_t bytesReserved() const { return arena.bytesReserved(); }
+
+    // Visit every line in insertion order
+    template<typename Visitor>
+    void forEach(Visitor visit) const {
+        for (size_t b = 0; b < blocks.size(); b++) {
+            size_t end = b + 1 < blocks.size() ? LINES_PER_BLOCK : count - b * LINES_PER_BLOCK;
+            for (size_t i = 0; i < end; i++) visit(blocks[b][i]);
+        }
+    }
+
+    void clear() {
+        arena.reset();
+        blocks.clear();
+        count = 0;
+        items.clear();
+        stores.clear();
+        itemTotals.clear();
+        monthTotals.clear();
+        total = Money();
+        for (const Binding& binding : bindings) binding.expense->setGroceries(Money());
+    }
+};
+
+#endif
@@ -0,0 +1,454 @@
+#ifndef HISTORYCODEC_H
+#define HISTORYCODEC_H
+
+#include "BudgetParser.h"
+#include "ColumnarStore.h"
+#include "StringInterner.h"
+#include "SystemIO.h"
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+
+#ifdef BUDGET_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+struct HistoryWriteOptions {
+    bool compress;          // deflate each block; needs a build with BUDGET_HAVE_ZLIB
+    int level;              // 1 (fastest) .. 9 (smallest)
+    size_t blockBytes;      // encoded bytes per block before compression
+
+    HistoryWriteOptions(bool deflate = false, int compressionLevel = 1, size_t block = 64 << 10)
+        : compress(deflate), level(compressionLevel), blockBytes(block) {}
+};
+
+// On-disk layout (little-endian):
+//   header | blocks, each a HistoryBlockHeader followed by its payload
+// Records are grouped by user (in order of first appearance) and sorted
+// by month within a user; re-saves of a month keep their save order.
+// A record in a payload is
+//   varint user     0 = same user as the previous record, else length + 1
+//                   followed by the name
+//   varint month    0 = new month name (varint length + bytes), else the
+//                   index + 1 of a name already seen in this block
+//   varint mask     bit c set when column c changed
+//   zigzag varint   per set bit, the change in cents from the same user's
+//                   previous record (from zero for a user's first record)
+// Every block starts over (no previous user, no month names), so blocks
+// decode on their own.
+struct HistoryHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t recordCount;
+    uint32_t blockCount;
+    uint32_t columnCount;
+};
+
+enum HistoryBlockCodec {
+    HISTORY_BLOCK_RAW,
+    HISTORY_BLOCK_DEFLATE
+};
+
+struct HistoryBlockHeader {
+    uint32_t rawBytes;
+    uint32_t storedBytes;
+    uint32_t records;
+    uint32_t codec;
+};
+
+class HistoryStore {
+public:
+    static constexpr char MAGIC[4] = {'B', 'G', 'T', 'H'};
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t UNKNOWN_MONTH = UINT32_MAX;
+
+    // Check whether a file starts with the history magic
+    static bool isHistoryFile(const string& path) {
+        ifstream file(path, ios::binary);
+        char magic[4];
+        return file.read(magic, 4) && memcmp(magic, MAGIC, 4) == 0;
+    }
+
+    static bool compressionAvailable() {
+#ifdef BUDGET_HAVE_ZLIB
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // Sort key of "March 2024" or "2024-03": year * 12 + month - 1, or
+    // UNKNOWN_MONTH (after every known month) for other names
+    static uint32_t monthKey(string_view month) {
+        static const char* const names[] = {"January", "February", "March", "April", "May", "June",
+                                            "July", "August", "September", "October", "November", "December"};
+        const char* end = month.data() + month.size();
+        uint32_t year = 0;
+        size_t space = month.rfind(' ');
+        if (space != string_view::npos) {
+            auto parsed = from_chars(month.data() + space + 1, end, year);
+            if (parsed.ec != errc() || parsed.ptr != end) return UNKNOWN_MONTH;
+            string_view name = month.substr(0, space);
+            for (uint32_t m = 0; m < 12; m++) {
+                if (name == names[m]) return year * 12 + m;
+            }
+            return UNKNOWN_MONTH;
+        }
+        uint32_t number = 0;
+        if (month.size() != 7 || month[4] != '-' || from_chars(month.data(), month.data() + 4, year).ptr != month.data() + 4 ||
+            from_chars(month.data() + 5, end, number).ptr != end || number < 1 || number > 12) {
+            return UNKNOWN_MONTH;
+        }
+        return year * 12 + number - 1;
+    }
+
+    // Encode all budgets as a fresh history file, replacing any old one
+    static bool write(const string& path, const vector<Budget>& budgets,
+                      const HistoryWriteOptions& options = HistoryWriteOptions()) {
+        if (options.compress && !compressionAvailable()) {
+            cerr << "Error: This build has no compression support (compile with BUDGET_HAVE_ZLIB)!" << endl;
+            return false;
+        }
+
+        // Group by user, then month order; stable so re-saves stay in order
+        StringInterner users, months;
+        vector<uint32_t> userIds(budgets.size()), monthIds(budgets.size());
+        vector<uint32_t> monthKeys;
+        for (size_t i = 0; i < budgets.size(); i++) {
+            userIds[i] = users.intern(budgets[i].getUserName());
+            monthIds[i] = months.intern(budgets[i].getMonth());
+            if (monthIds[i] == monthKeys.size()) monthKeys.push_back(monthKey(budgets[i].getMonth()));
+        }
+        vector<uint32_t> order(budgets.size());
+        for (size_t i = 0; i < order.size(); i++) order[i] = static_cast<uint32_t>(i);
+        stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            if (userIds[a] != userIds[b]) return userIds[a] < userIds[b];
+            return monthKeys[monthIds[a]] < monthKeys[monthIds[b]];
+        });
+
+        HistoryHeader header = {};
+        memcpy(header.magic, MAGIC, 4);
+        header.version = VERSION;
+        header.recordCount = budgets.size();
+        header.columnCount = NUM_BUDGET_COLUMNS;
+
+        string out(sizeof(HistoryHeader), '\0');
+        string raw;
+        raw.reserve(options.blockBytes + 1024);
+        const uint32_t NONE = UINT32_MAX;
+        vector<uint32_t> blockMonth(months.size(), NONE);   // month id -> index in this block
+        vector<uint32_t> touchedMonths;
+        uint32_t previousUser = NONE;
+        int64_t previous[NUM_BUDGET_COLUMNS] = {};
+        uint32_t blockRecords = 0;
+
+        auto finishBlock = [&]() {
+            if (blockRecords == 0) return true;
+            if (!appendBlock(out, raw, blockRecords, options)) return false;
+            header.blockCount++;
+            raw.clear();
+            blockRecords = 0;
+            previousUser = NONE;
+            for (uint32_t m : touchedMonths) blockMonth[m] = NONE;
+            touchedMonths.clear();
+            return true;
+        };
+
+        for (uint32_t i : order) {
+            const Budget& b = budgets[i];
+            if (userIds[i] != previousUser) {
+                putVarint(raw, b.getUserName().size() + 1);
+                raw += b.getUserName();
+                previousUser = userIds[i];
+                fill(previous, previous + NUM_BUDGET_COLUMNS, 0);
+            } else {
+                putVarint(raw, 0);
+            }
+
+            uint32_t& slot = blockMonth[monthIds[i]];
+            if (slot == NONE) {
+                putVarint(raw, 0);
+                putVarint(raw, b.getMonth().size());
+                raw += b.getMonth();
+                slot = static_cast<uint32_t>(touchedMonths.size());
+                touchedMonths.push_back(monthIds[i]);
+            } else {
+                putVarint(raw, slot + 1);
+            }
+
+            uint32_t mask = 0;
+            uint64_t changes[NUM_BUDGET_COLUMNS];
+            int changed = 0;
+            for (int c = 0; c < NUM_BUDGET_COLUMNS; c++) {
+                int64_t cents = BudgetColumns::get(b, c).getCents();
+                if (cents == previous[c]) continue;
+                mask |= 1u << c;
+                // Wrapping difference, so any pair of int64 amounts round-trips
+                changes[changed++] = zigzag(static_cast<int64_t>(static_cast<uint64_t>(cents) -
+                                                                 static_cast<uint64_t>(previous[c])));
+                previous[c] = cents;
+            }
+            putVarint(raw, mask);
+            for (int k = 0; k < changed; k++) putVarint(raw, changes[k]);
+
+            blockRecords++;
+            if (raw.size() >= options.blockBytes && !finishBlock()) return false;
+        }
+        if (!finishBlock()) return false;
+        memcpy(&out[0], &header, sizeof(header));
+
+        // Written aside and renamed over, so a failed rewrite keeps the old history
+        string temp = path + ".tmp";
+        AppendFile file;
+        if (!file.open(temp, true) || !file.write(out.data(), out.size()) || !file.sync()) {
+            cerr << "Error: Could not write history file " << path << "!" << endl;
+            file.close();
+            remove(temp.c_str());
+            return false;
+        }
+        file.close();
+        if (!replaceFile(temp, path)) {
+            cerr << "Error: Could not replace " << path << "!" << endl;
+            remove(temp.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    static void putVarint(string& out, uint64_t value) {
+        while (value >= 0x80) {
+            out += static_cast<char>(value | 0x80);
+            value >>= 7;
+        }
+        out += static_cast<char>(value);
+    }
+
+    // False on a truncated or overlong varint
+    static bool getVarint(const uint8_t*& p, const uint8_t* end, uint64_t& value) {
+        uint64_t result = 0;
+        for (int shift = 0; shift < 64 && p < end; shift += 7) {
+            uint8_t byte = *p++;
+            result |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                value = result;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static uint64_t zigzag(int64_t value) {
+        return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    }
+
+    static int64_t unzigzag(uint64_t value) {
+        return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    }
+
+private:
+    static bool appendBlock(string& out, const string& raw, uint32_t records, const HistoryWriteOptions& options) {
+        HistoryBlockHeader block = {static_cast<uint32_t>(raw.size()), static_cast<uint32_t>(raw.size()), records,
+                                    HISTORY_BLOCK_RAW};
+        string packed;
+#ifdef BUDGET_HAVE_ZLIB
+        if (options.compress) {
+            uLongf packedSize = compressBound(static_cast<uLong>(raw.size()));
+            packed.resize(packedSize);
+            if (compress2(reinterpret_cast<Bytef*>(&packed[0]), &packedSize, reinterpret_cast<const Bytef*>(raw.data()),
+                          static_cast<uLong>(raw.size()), options.level) != Z_OK) {
+                cerr << "Error: Could not compress history block!" << endl;
+                return false;
+            }
+            // Blocks that don't shrink are stored as they are
+            if (packedSize < raw.size()) {
+                packed.resize(packedSize);
+                block.storedBytes = static_cast<uint32_t>(packedSize);
+                block.codec = HISTORY_BLOCK_DEFLATE;
+            }
+        }
+#else
+        (void)options;
+#endif
+        out.append(reinterpret_cast<const char*>(&block), sizeof(block));
+        out += block.codec == HISTORY_BLOCK_RAW ? raw : packed;
+        return true;
+    }
+};
+
+// Streaming decoder for history files. The file is mapped and decoded a
+// block at a time into a parser sink (see BudgetParser.h), so the same
+// sinks fill a vector, visit budgets or build a BudgetRecordSet. commit()
+// receives the record's ordinal instead of a byte range.
+class HistoryReader {
+private:
+    MappedFile mapped;
+    HistoryHeader header;
+    string path;
+    string inflated;                // deflated blocks are expanded here
+    vector<string_view> months;     // month names seen in the current block
+    bool valid;
+
+    bool damaged(uint32_t block) const {
+        cerr << "Error: " << path << " is damaged (block " << block << ")!" << endl;
+        return false;
+    }
+
+    template<typename Sink>
+    bool decodeBlock(const uint8_t* p, const uint8_t* end, uint32_t records, uint64_t& ordinal, Sink& sink) {
+        months.clear();
+        string_view user;
+        bool haveUser = false;
+        int64_t values[NUM_BUDGET_COLUMNS] = {};
+        for (uint32_t r = 0; r < records; r++) {
+            uint64_t tag, length, mask;
+            if (!HistoryStore::getVarint(p, end, tag)) return false;
+            if (tag != 0) {
+                length = tag - 1;
+                if (static_cast<uint64_t>(end - p) < length) return false;
+                user = string_view(reinterpret_cast<const char*>(p), length);
+                p += length;
+                haveUser = true;
+                fill(values, values + NUM_BUDGET_COLUMNS, 0);
+            } else if (!haveUser) {
+                return false;
+            }
+
+            string_view month;
+            if (!HistoryStore::getVarint(p, end, tag)) return false;
+            if (tag == 0) {
+                if (!HistoryStore::getVarint(p, end, length) || static_cast<uint64_t>(end - p) < length) return false;
+                month = string_view(reinterpret_cast<const char*>(p), length);
+                p += length;
+                months.push_back(month);
+            } else {
+                if (tag > months.size()) return false;
+                month = months[tag - 1];
+            }
+
+            if (!HistoryStore::getVarint(p, end, mask) || mask >> NUM_BUDGET_COLUMNS) return false;
+            for (uint32_t bits = static_cast<uint32_t>(mask); bits != 0; bits &= bits - 1) {
+                int c = __builtin_ctz(bits);
+                uint64_t change;
+                if (!HistoryStore::getVarint(p, end, change)) return false;
+                values[c] = static_cast<int64_t>(static_cast<uint64_t>(values[c]) +
+                                                 static_cast<uint64_t>(HistoryStore::unzigzag(change)));
+            }
+
+            // Sinks start every record at zero, like a text record without the key
+            sink.begin();
+            sink.setText(KEY_USER, user);
+            sink.setText(KEY_MONTH, month);
+            for (int c = 0; c < NUM_BUDGET_COLUMNS; c++) {
+                if (values[c] != 0) sink.setValue(c, Money::fromCents(values[c]));
+            }
+            sink.commit(ordinal, ordinal + 1);
+            ordinal++;
+        }
+        return p == end;
+    }
+
+    // Walk the block headers before anything is sized from them: the blocks
+    // must tile the file, hold at least MIN_RECORD_BYTES per record and
+    // inflate no further than deflate can, and their records must add up
+    // to the header's count
+    bool checkBlocks() const {
+        const char* p = mapped.begin() + sizeof(HistoryHeader);
+        const char* end = mapped.begin() + mapped.size();
+        uint64_t records = 0;
+        for (uint32_t b = 0; b < header.blockCount; b++) {
+            HistoryBlockHeader block;
+            if (static_cast<size_t>(end - p) < sizeof(block)) return false;
+            memcpy(&block, p, sizeof(block));
+            p += sizeof(block);
+            if (static_cast<size_t>(end - p) < block.storedBytes) return false;
+            p += block.storedBytes;
+            if (block.records > block.rawBytes / MIN_RECORD_BYTES) return false;
+            if (block.rawBytes > static_cast<uint64_t>(block.storedBytes) * MAX_INFLATE_RATIO + 64) return false;
+            records += block.records;
+        }
+        return p == end && records == header.recordCount;
+    }
+
+public:
+    // A tag, a month reference and a change mask at the very least
+    static constexpr uint32_t MIN_RECORD_BYTES = 3;
+    // zlib's worst case is about 1032:1
+    static constexpr uint64_t MAX_INFLATE_RATIO = 1032;
+
+    HistoryReader() : header(), valid(false) {}
+
+    HistoryReader(const HistoryReader&) = delete;
+    HistoryReader& operator=(const HistoryReader&) = delete;
+
+    // Map the file and validate its header
+    bool open(const string& file) {
+        valid = false;
+        path = file;
+        if (!mapped.open(path) || mapped.size() < sizeof(HistoryHeader)) return false;
+        memcpy(&header, mapped.begin(), sizeof(header));
+        if (memcmp(header.magic, HistoryStore::MAGIC, 4) != 0) {
+            cerr << "Error: " << path << " is not a budget history file!" << endl;
+            return false;
+        }
+        if (header.version != HistoryStore::VERSION || header.columnCount != NUM_BUDGET_COLUMNS) {
+            cerr << "Error: Unsupported history file version " << header.version << "!" << endl;
+            return false;
+        }
+        if (!checkBlocks()) {
+            cerr << "Error: " << path << " is damaged (block table)!" << endl;
+            return false;
+        }
+        valid = true;
+        return true;
+    }
+
+    bool isValid() const { return valid; }
+    size_t size() const { return valid ? static_cast<size_t>(header.recordCount) : 0; }
+    size_t blockCount() const { return valid ? header.blockCount : 0; }
+    size_t fileBytes() const { return mapped.size(); }
+
+    // Decode every record into sink, block by block; false if the file is damaged
+    template<typename Sink>
+    bool decode(Sink& sink) {
+        if (!valid) return false;
+        // Only a hint; a record costs far more than a byte of file in practice
+        sink.reserve(min<size_t>(size(), mapped.size()));
+        const char* p = mapped.begin() + sizeof(HistoryHeader);
+        const char* end = mapped.begin() + mapped.size();
+        uint64_t ordinal = 0;
+        for (uint32_t b = 0; b < header.blockCount; b++) {
+            HistoryBlockHeader block;
+            if (static_cast<size_t>(end - p) < sizeof(block)) return damaged(b);
+            memcpy(&block, p, sizeof(block));
+            p += sizeof(block);
+            if (static_cast<size_t>(end - p) < block.storedBytes) return damaged(b);
+
+            const char* payload = p;
+            p += block.storedBytes;
+            if (block.codec == HISTORY_BLOCK_DEFLATE) {
+#ifdef BUDGET_HAVE_ZLIB
+                inflated.resize(block.rawBytes);
+                uLongf rawSize = block.rawBytes;
+                if (uncompress(reinterpret_cast<Bytef*>(&inflated[0]), &rawSize, reinterpret_cast<const Bytef*>(payload),
+                               block.storedBytes) != Z_OK || rawSize != block.rawBytes) {
+                    return damaged(b);
+                }
+                payload = inflated.data();
+#else
+                cerr << "Error: " << path << " is compressed; this build has no compression support "
+                     << "(compile with BUDGET_HAVE_ZLIB)!" << endl;
+                return false;
+#endif
+            } else if (block.codec != HISTORY_BLOCK_RAW || block.rawBytes != block.storedBytes) {
+                return damaged(b);
+            }
+
+            const uint8_t* data = reinterpret_cast<const uint8_t*>(payload);
+            if (!decodeBlock(data, data + block.rawBytes, block.records, ordinal, sink)) return damaged(b);
+        }
+        if (ordinal != header.recordCount || p != end) return damaged(header.blockCount);
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,526 @@
+#ifndef HTTPSERVER_H
+#define HTTPSERVER_H
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#define BUDGET_HAVE_EPOLL
+#include <arpa/inet.h>
+#include <cerrno>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// One parsed request; every view points into the connection's input buffer
+// and is only valid while the handler runs
+struct HttpRequest {
+    string_view method;
+    string_view path;       // without the query string
+    string_view query;
+    string_view body;
+    bool keepAlive;
+};
+
+// Response filled in by a handler. The body string belongs to the
+// connection and keeps its capacity between requests.
+struct HttpResponse {
+    int status;
+    const char* contentType;
+    string& body;
+
+    explicit HttpResponse(string& buffer) : status(200), contentType("application/json"), body(buffer) {}
+};
+
+using HttpHandler = function<void(const HttpRequest&, HttpResponse&)>;
+
+struct HttpServerOptions {
+    uint16_t port;
+    size_t threads;             // event loop workers, 0 = one per core
+    size_t maxConnections;      // per worker
+    size_t bufferSize;          // request bytes per connection, larger requests get 413
+    bool allowAnyOrigin;        // CORS headers so the browser frontend can call the API
+
+    HttpServerOptions(uint16_t p = 8080, size_t t = 0)
+        : port(p), threads(t), maxConnections(1024), bufferSize(16 << 10), allowAnyOrigin(true) {}
+};
+
+// HTTP/1.1 server for localhost APIs. A fixed set of workers each run an
+// edge-triggered epoll loop over their own connections; the listening
+// socket is shared with EPOLLEXCLUSIVE so one worker wakes per accept.
+// Connections come from a table allocated up front, with fixed input
+// buffers and reused output buffers, so serving a request allocates only
+// if a response outgrows every earlier one on that connection.
+// Keep-alive and pipelining are supported; chunked uploads are not.
+class HttpServer {
+public:
+    static const char* statusText(int status) {
+        switch (status) {
+            case 200: return "OK";
+            case 201: return "Created";
+            case 204: return "No Content";
+            case 400: return "Bad Request";
+            case 404: return "Not Found";
+            case 405: return "Method Not Allowed";
+            case 411: return "Length Required";
+            case 413: return "Payload Too Large";
+            case 500: return "Internal Server Error";
+            case 501: return "Not Implemented";
+            default: return "Unknown";
+        }
+    }
+
+    // Decode %XX escapes and '+' in a path segment
+    static string urlDecode(string_view text) {
+        string out;
+        out.reserve(text.size());
+        for (size_t i = 0; i < text.size(); i++) {
+            char c = text[i];
+            if (c == '%' && i + 2 < text.size()) {
+                int hi = hexDigit(text[i + 1]);
+                int lo = hexDigit(text[i + 2]);
+                if (hi >= 0 && lo >= 0) {
+                    out += static_cast<char>(hi * 16 + lo);
+                    i += 2;
+                    continue;
+                }
+            }
+            out += c == '+' ? ' ' : c;
+        }
+        return out;
+    }
+
+    // Result of scanning the front of an input buffer
+    enum ParseResult {
+        PARSE_INCOMPLETE,
+        PARSE_OK,
+        PARSE_BAD,              // 400
+        PARSE_NO_LENGTH,        // 411, chunked bodies are not supported
+        PARSE_TOO_LARGE         // 413
+    };
+
+    // Parse one request from data[0..size); consumed is its length in bytes
+    static ParseResult parseRequest(const char* data, size_t size, size_t capacity, HttpRequest& request, size_t& consumed) {
+        string_view input(data, size);
+        size_t headerEnd = input.find("\r\n\r\n");
+        if (headerEnd == string_view::npos) return size >= capacity ? PARSE_TOO_LARGE : PARSE_INCOMPLETE;
+
+        size_t lineEnd = input.find("\r\n");
+        string_view line = input.substr(0, lineEnd);
+        size_t space1 = line.find(' ');
+        size_t space2 = line.rfind(' ');
+        if (space1 == string_view::npos || space2 == space1) return PARSE_BAD;
+        request.method = line.substr(0, space1);
+        string_view target = line.substr(space1 + 1, space2 - space1 - 1);
+        string_view version = line.substr(space2 + 1);
+        if (version.substr(0, 5) != "HTTP/" || target.empty()) return PARSE_BAD;
+        size_t question = target.find('?');
+        request.path = target.substr(0, question);
+        request.query = question == string_view::npos ? string_view() : target.substr(question + 1);
+        request.keepAlive = version != "HTTP/1.0";
+
+        size_t contentLength = 0;
+        size_t pos = lineEnd + 2;
+        while (pos < headerEnd) {
+            size_t next = input.find("\r\n", pos);
+            string_view header = input.substr(pos, next - pos);
+            pos = next + 2;
+            size_t colon = header.find(':');
+            if (colon == string_view::npos) return PARSE_BAD;
+            string_view name = header.substr(0, colon);
+            string_view value = header.substr(colon + 1);
+            while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) value.remove_prefix(1);
+            while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) value.remove_suffix(1);
+            if (equalsIgnoreCase(name, "Content-Length")) {
+                auto result = from_chars(value.data(), value.data() + value.size(), contentLength);
+                if (result.ec != errc() || result.ptr != value.data() + value.size()) return PARSE_BAD;
+            } else if (equalsIgnoreCase(name, "Connection")) {
+                if (equalsIgnoreCase(value, "close")) request.keepAlive = false;
+                else if (equalsIgnoreCase(value, "keep-alive")) request.keepAlive = true;
+            } else if (equalsIgnoreCase(name, "Transfer-Encoding")) {
+                return PARSE_NO_LENGTH;
+            }
+        }
+
+        size_t bodyStart = headerEnd + 4;
+        if (contentLength > capacity || bodyStart + contentLength > capacity) return PARSE_TOO_LARGE;
+        if (bodyStart + contentLength > size) return PARSE_INCOMPLETE;
+        request.body = input.substr(bodyStart, contentLength);
+        consumed = bodyStart + contentLength;
+        return PARSE_OK;
+    }
+
+private:
+    static int hexDigit(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    static bool equalsIgnoreCase(string_view a, string_view b) {
+        if (a.size() != b.size()) return false;
+        for (size_t i = 0; i < a.size(); i++) {
+            char x = a[i] >= 'A' && a[i] <= 'Z' ? a[i] + 32 : a[i];
+            char y = b[i] >= 'A' && b[i] <= 'Z' ? b[i] + 32 : b[i];
+            if (x != y) return false;
+        }
+        return true;
+    }
+
+    static void appendNumber(string& out, size_t value) {
+        char digits[24];
+        out.append(digits, to_chars(digits, digits + sizeof(digits), value).ptr);
+    }
+
+    // Status line, headers and body of one response
+    void appendResponse(string& out, int status, const char* contentType, string_view body, bool keepAlive) const {
+        out += "HTTP/1.1 ";
+        appendNumber(out, static_cast<size_t>(status));
+        out += ' ';
+        out += statusText(status);
+        out += "\r\nContent-Type: ";
+        out += contentType;
+        out += "\r\nContent-Length: ";
+        appendNumber(out, body.size());
+        out += keepAlive ? "\r\nConnection: keep-alive" : "\r\nConnection: close";
+        if (options.allowAnyOrigin) out += "\r\nAccess-Control-Allow-Origin: *";
+        out += "\r\n\r\n";
+        out.append(body.data(), body.size());
+    }
+
+    HttpHandler handler;
+    HttpServerOptions options;
+    atomic<bool> stopping;
+
+#ifdef BUDGET_HAVE_EPOLL
+    static constexpr uint64_t LISTEN_ID = ~uint64_t(0);
+    static constexpr uint64_t WAKE_ID = ~uint64_t(0) - 1;
+    static constexpr size_t MAX_PENDING_OUTPUT = 4 << 20;   // stop reading until the client drains this
+
+    struct Connection {
+        int fd;
+        unique_ptr<char[]> input;
+        size_t inputSize;
+        string output;
+        size_t outputSent;
+        string body;
+        bool closeAfterWrite;
+        bool waitingForWrite;
+    };
+
+    struct Worker {
+        int epollFd;
+        vector<Connection> connections;
+        vector<uint32_t> freeSlots;
+        thread loop;
+    };
+
+    int listenFd;
+    int wakeFd;
+    vector<unique_ptr<Worker>> workers;
+
+    void closeConnection(Worker& worker, uint32_t slot) {
+        Connection& conn = worker.connections[slot];
+        if (conn.fd < 0) return;
+        epoll_ctl(worker.epollFd, EPOLL_CTL_DEL, conn.fd, nullptr);
+        close(conn.fd);
+        conn.fd = -1;
+        worker.freeSlots.push_back(slot);
+    }
+
+    void acceptAll(Worker& worker) {
+        while (true) {
+            int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) return;     // EAGAIN: another worker took it, or the backlog is empty
+            if (worker.freeSlots.empty()) {
+                close(fd);
+                continue;
+            }
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            uint32_t slot = worker.freeSlots.back();
+            worker.freeSlots.pop_back();
+            Connection& conn = worker.connections[slot];
+            conn.fd = fd;
+            conn.inputSize = 0;
+            conn.output.clear();
+            conn.outputSent = 0;
+            conn.closeAfterWrite = false;
+            conn.waitingForWrite = false;
+            epoll_event event = {};
+            event.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+            event.data.u64 = slot;
+            if (epoll_ctl(worker.epollFd, EPOLL_CTL_ADD, fd, &event) != 0) closeConnection(worker, slot);
+        }
+    }
+
+    // Answer every complete request at the front of the input buffer
+    void processInput(Connection& conn) {
+        size_t offset = 0;
+        while (!conn.closeAfterWrite && offset < conn.inputSize) {
+            HttpRequest request;
+            size_t consumed = 0;
+            ParseResult result = parseRequest(conn.input.get() + offset, conn.inputSize - offset,
+                                              options.bufferSize, request, consumed);
+            if (result == PARSE_INCOMPLETE) break;
+            if (result != PARSE_OK) {
+                int status = result == PARSE_TOO_LARGE ? 413 : result == PARSE_NO_LENGTH ? 411 : 400;
+                appendResponse(conn.output, status, "application/json", "{\"error\":\"malformed request\"}", false);
+                conn.closeAfterWrite = true;
+                break;
+            }
+            offset += consumed;
+            if (!request.keepAlive) conn.closeAfterWrite = true;
+
+            if (options.allowAnyOrigin && request.method == "OPTIONS") {
+                conn.output += "HTTP/1.1 204 No Content\r\nAccess-Control-Allow-Origin: *\r\n"
+                               "Access-Control-Allow-Methods: GET, POST, PUT, OPTIONS\r\n"
+                               "Access-Control-Allow-Headers: Content-Type\r\nContent-Length: 0\r\n";
+                conn.output += request.keepAlive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+                continue;
+            }
+            conn.body.clear();
+            HttpResponse response(conn.body);
+            handler(request, response);
+            appendResponse(conn.output, response.status, response.contentType, conn.body, request.keepAlive);
+        }
+        if (offset > 0) {
+            memmove(conn.input.get(), conn.input.get() + offset, conn.inputSize - offset);
+            conn.inputSize -= offset;
+        }
+    }
+
+    // Send pending output; false if the connection is finished
+    bool flushOutput(Worker& worker, uint32_t slot) {
+        Connection& conn = worker.connections[slot];
+        while (conn.outputSent < conn.output.size()) {
+            ssize_t sent = send(conn.fd, conn.output.data() + conn.outputSent, conn.output.size() - conn.outputSent,
+                                MSG_NOSIGNAL);
+            if (sent > 0) {
+                conn.outputSent += static_cast<size_t>(sent);
+                continue;
+            }
+            if (sent < 0 && errno == EINTR) continue;
+            if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                if (!conn.waitingForWrite) {
+                    epoll_event event = {};
+                    event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+                    event.data.u64 = slot;
+                    epoll_ctl(worker.epollFd, EPOLL_CTL_MOD, conn.fd, &event);
+                    conn.waitingForWrite = true;
+                }
+                return true;
+            }
+            return false;
+        }
+        conn.output.clear();
+        conn.outputSent = 0;
+        if (conn.waitingForWrite) {
+            epoll_event event = {};
+            event.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+            event.data.u64 = slot;
+            epoll_ctl(worker.epollFd, EPOLL_CTL_MOD, conn.fd, &event);
+            conn.waitingForWrite = false;
+        }
+        return !conn.closeAfterWrite;
+    }
+
+    // Read until the socket is drained (edge-triggered), answering as we go
+    void serviceConnection(Worker& worker, uint32_t slot) {
+        Connection& conn = worker.connections[slot];
+        bool peerClosed = false;
+        bool drained = false;
+        while (true) {
+            while (!conn.closeAfterWrite && conn.output.size() - conn.outputSent < MAX_PENDING_OUTPUT) {
+                ssize_t received = recv(conn.fd, conn.input.get() + conn.inputSize, options.bufferSize - conn.inputSize, 0);
+                if (received > 0) {
+                    conn.inputSize += static_cast<size_t>(received);
+                    processInput(conn);
+                    continue;
+                }
+                if (received < 0 && errno == EINTR) continue;
+                drained = true;
+                if (!(received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))) peerClosed = true;
+                break;
+            }
+            if (!flushOutput(worker, slot) || (peerClosed && conn.output.empty())) {
+                closeConnection(worker, slot);
+                return;
+            }
+            // Reading stopped at the output cap; once the flush catches up, go back
+            // for the rest, since the edge-triggered socket won't report it again
+            if (drained || !conn.output.empty()) return;
+        }
+    }
+
+    void run(Worker& worker) {
+        epoll_event events[256];
+        while (!stopping.load(memory_order_relaxed)) {
+            int count = epoll_wait(worker.epollFd, events, 256, -1);
+            if (count < 0) {
+                if (errno == EINTR) continue;
+                cerr << "Error: epoll_wait failed: " << strerror(errno) << endl;
+                return;
+            }
+            for (int i = 0; i < count; i++) {
+                uint64_t id = events[i].data.u64;
+                if (id == LISTEN_ID) {
+                    acceptAll(worker);
+                } else if (id == WAKE_ID) {
+                    return;
+                } else if (worker.connections[id].fd >= 0) {
+                    if (events[i].events & EPOLLERR) closeConnection(worker, static_cast<uint32_t>(id));
+                    else serviceConnection(worker, static_cast<uint32_t>(id));
+                }
+            }
+        }
+    }
+#endif
+
+public:
+    HttpServer(HttpHandler h, const HttpServerOptions& opts = HttpServerOptions())
+        : handler(move(h)), options(opts), stopping(false)
+#ifdef BUDGET_HAVE_EPOLL
+        , listenFd(-1), wakeFd(-1)
+#endif
+    {}
+
+    ~HttpServer() { stop(); }
+
+    HttpServer(const HttpServer&) = delete;
+    HttpServer& operator=(const HttpServer&) = delete;
+
+    static bool available() {
+#ifdef BUDGET_HAVE_EPOLL
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // Bind to 127.0.0.1:port and start the workers; port 0 picks a free port
+    bool start() {
+#ifdef BUDGET_HAVE_EPOLL
+        listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listenFd < 0) {
+            cerr << "Error: Could not create socket: " << strerror(errno) << endl;
+            return false;
+        }
+        int one = 1;
+        setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(options.port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listenFd, 1024) != 0) {
+            cerr << "Error: Could not listen on port " << options.port << ": " << strerror(errno) << endl;
+            stop();
+            return false;
+        }
+        socklen_t length = sizeof(address);
+        getsockname(listenFd, reinterpret_cast<sockaddr*>(&address), &length);
+        options.port = ntohs(address.sin_port);
+        wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+        size_t count = options.threads == 0 ? max<size_t>(1, thread::hardware_concurrency()) : options.threads;
+        for (size_t w = 0; w < count; w++) {
+            unique_ptr<Worker> worker(new Worker());
+            worker->epollFd = epoll_create1(EPOLL_CLOEXEC);
+            worker->connections.resize(options.maxConnections);
+            worker->freeSlots.reserve(options.maxConnections);
+            for (size_t slot = options.maxConnections; slot-- > 0;) {
+                Connection& conn = worker->connections[slot];
+                conn.fd = -1;
+                conn.input.reset(new char[options.bufferSize]);
+                conn.output.reserve(options.bufferSize);
+                conn.body.reserve(options.bufferSize);
+                worker->freeSlots.push_back(static_cast<uint32_t>(slot));
+            }
+            epoll_event event = {};
+#ifdef EPOLLEXCLUSIVE
+            event.events = EPOLLIN | EPOLLEXCLUSIVE;
+#else
+            event.events = EPOLLIN;
+#endif
+            event.data.u64 = LISTEN_ID;
+            epoll_ctl(worker->epollFd, EPOLL_CTL_ADD, listenFd, &event);
+            event.events = EPOLLIN;
+            event.data.u64 = WAKE_ID;
+            epoll_ctl(worker->epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+            workers.push_back(move(worker));
+        }
+        for (auto& worker : workers) {
+            Worker* w = worker.get();
+            w->loop = thread([this, w] { run(*w); });
+        }
+        return true;
+#else
+        cerr << "Error: The HTTP server needs epoll (Linux); it is not available on this platform." << endl;
+        return false;
+#endif
+    }
+
+    // Stop the workers and close every connection. Only writes to an
+    // eventfd, so it may be called from a signal handler through requestStop().
+    void requestStop() {
+        stopping = true;
+#ifdef BUDGET_HAVE_EPOLL
+        if (wakeFd >= 0) {
+            uint64_t one = 1;
+            ssize_t ignored = write(wakeFd, &one, sizeof(one));
+            (void)ignored;
+        }
+#endif
+    }
+
+    // Wait for the workers to finish after requestStop()
+    void join() {
+#ifdef BUDGET_HAVE_EPOLL
+        for (auto& worker : workers) {
+            if (worker->loop.joinable()) worker->loop.join();
+        }
+#endif
+    }
+
+    void stop() {
+        requestStop();
+        join();
+#ifdef BUDGET_HAVE_EPOLL
+        for (auto& worker : workers) {
+            for (uint32_t slot = 0; slot < worker->connections.size(); slot++) closeConnection(*worker, slot);
+            close(worker->epollFd);
+        }
+        workers.clear();
+        if (listenFd >= 0) close(listenFd);
+        if (wakeFd >= 0) close(wakeFd);
+        listenFd = wakeFd = -1;
+#endif
+    }
+
+    uint16_t getPort() const { return options.port; }
+    size_t getThreadCount() const {
+#ifdef BUDGET_HAVE_EPOLL
+        return workers.size();
+#else
+        return 0;
+#endif
+    }
+};
+
+#endif
@@ -2,36 +2,37 @@
 #define INCOME_H
 
 #include "User.h"
+#include "Money.h"
 
 // Derived class demonstrating Inheritance
 class Income : public User {
 protected:
-    double salary;
-    double freelance;
-    double investments;
-    double otherIncome;
+    Money salary;
+    Money freelance;
+    Money investments;
+    Money otherIncome;
     
 public:
-    Income() : User(), salary(0), freelance(0), investments(0), otherIncome(0) {}
+    Income() : User(), salary(), freelance(), investments(), otherIncome() {}
     
     Income(string name, string mon) : User(name, mon), 
-                                      salary(0), freelance(0), 
-                                      investments(0), otherIncome(0) {}
+                                      salary(), freelance(), 
+                                      investments(), otherIncome() {}
     
     // Setters
-    void setSalary(double sal) { salary = sal; }
-    void setFreelance(double free) { freelance = free; }
-    void setInvestments(double inv) { investments = inv; }
-    void setOtherIncome(double other) { otherIncome = other; }
+    void setSalary(Money sal) { salary = sal; }
+    void setFreelance(Money free) { freelance = free; }
+    void setInvestments(Money inv) { investments = inv; }
+    void setOtherIncome(Money other) { otherIncome = other; }
     
     // Getters
-    double getSalary() const { return salary; }
-    double getFreelance() const { return freelance; }
-    double getInvestments() const { return investments; }
-    double getOtherIncome() const { return otherIncome; }
+    Money getSalary() const { return salary; }
+    Money getFreelance() const { return freelance; }
+    Money getInvestments() const { return investments; }
+    Money getOtherIncome() const { return otherIncome; }
     
     // Calculate total income
-    double getTotalIncome() const {
+    Money getTotalIncome() const {
         return salary + freelance + investments + otherIncome;
     }
     
@@ -0,0 +1,259 @@
+#ifndef JSONEXPORTER_H
+#define JSONEXPORTER_H
+
+#include "Budget.h"
+#include "SystemIO.h"
+#include <charconv>
+
+#ifdef BUDGET_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+enum JsonLayout {
+    JSON_LINES,     // one object per line
+    JSON_ARRAY      // a single array of objects
+};
+
+struct JsonExportOptions {
+    JsonLayout layout;
+    bool gzip;              // needs a build with BUDGET_HAVE_ZLIB
+    int gzipLevel;          // 1 (fastest) .. 9 (smallest)
+    size_t bufferSize;      // bytes collected before each write
+
+    JsonExportOptions(JsonLayout l = JSON_LINES, bool gz = false, int level = 1, size_t buffer = 4 << 20)
+        : layout(l), gzip(gz), gzipLevel(level), bufferSize(buffer) {}
+
+    // ".json" -> array, anything else -> lines; a trailing ".gz" -> gzip
+    static JsonExportOptions forPath(string_view path) {
+        JsonExportOptions options;
+        if (path.size() > 3 && path.substr(path.size() - 3) == ".gz") {
+            options.gzip = true;
+            path.remove_suffix(3);
+        }
+        if (path.size() > 5 && path.substr(path.size() - 5) == ".json") options.layout = JSON_ARRAY;
+        return options;
+    }
+};
+
+// Streaming JSON exporter for many budgets. Objects use the same fields as
+// FileHandler::exportToJSON, compacted to one line. Everything is
+// formatted with to_chars into one reusable buffer that goes out in large
+// writes, optionally through gzip.
+class JsonExporter {
+private:
+    AppendFile file;
+    JsonExportOptions options;
+    string buffer;
+    size_t recordCount;
+    uint64_t rawBytes;
+    uint64_t outputBytes;
+    bool failed;
+#ifdef BUDGET_HAVE_ZLIB
+    z_stream zip;
+    bool zipOpen;
+    vector<char> compressed;
+#endif
+
+    static void appendMoney(string& out, Money value) {
+        char digits[Money::MAX_CHARS];
+        out.append(digits, value.toChars(digits, digits + sizeof(digits)));
+    }
+
+    // Same digits as an ostream with default precision
+    static void appendDouble(string& out, double value) {
+        char digits[32];
+        out.append(digits, to_chars(digits, digits + sizeof(digits), value, chars_format::general, 6).ptr);
+    }
+
+    static void appendField(string& out, const char* key, Money value) {
+        out += '"';
+        out += key;
+        out += "\":";
+        appendMoney(out, value);
+    }
+
+    bool writeOut(const char* data, size_t size) {
+        if (!file.write(data, size)) {
+            cerr << "Error: Could not write JSON export!" << endl;
+            failed = true;
+            return false;
+        }
+        outputBytes += size;
+        return true;
+    }
+
+    // Hand the buffer to the file (or the compressor) and clear it
+    bool drain(bool finish) {
+        rawBytes += buffer.size();
+#ifdef BUDGET_HAVE_ZLIB
+        if (zipOpen) {
+            zip.next_in = reinterpret_cast<Bytef*>(&buffer[0]);
+            zip.avail_in = static_cast<uInt>(buffer.size());
+            int result;
+            do {
+                zip.next_out = reinterpret_cast<Bytef*>(compressed.data());
+                zip.avail_out = static_cast<uInt>(compressed.size());
+                result = deflate(&zip, finish ? Z_FINISH : Z_NO_FLUSH);
+                size_t produced = compressed.size() - zip.avail_out;
+                if (produced > 0 && !writeOut(compressed.data(), produced)) return false;
+            } while (zip.avail_out == 0 || (finish && result != Z_STREAM_END));
+            buffer.clear();
+            return true;
+        }
+#endif
+        (void)finish;
+        bool ok = buffer.empty() || writeOut(buffer.data(), buffer.size());
+        buffer.clear();
+        return ok;
+    }
+
+public:
+    JsonExporter() : recordCount(0), rawBytes(0), outputBytes(0), failed(false) {
+#ifdef BUDGET_HAVE_ZLIB
+        zipOpen = false;
+#endif
+    }
+    ~JsonExporter() { close(); }
+
+    JsonExporter(const JsonExporter&) = delete;
+    JsonExporter& operator=(const JsonExporter&) = delete;
+
+    static bool gzipAvailable() {
+#ifdef BUDGET_HAVE_ZLIB
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // Quoted JSON string; quotes, backslashes and control characters are
+    // escaped, other bytes (UTF-8) pass through
+    static void appendString(string& out, string_view value) {
+        static const char hex[] = "0123456789abcdef";
+        out += '"';
+        size_t plain = 0;
+        for (size_t i = 0; i < value.size(); i++) {
+            unsigned char c = static_cast<unsigned char>(value[i]);
+            if (c >= 0x20 && c != '"' && c != '\\') continue;
+            out.append(value.data() + plain, i - plain);
+            plain = i + 1;
+            switch (c) {
+                case '"': out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\n': out += "\\n"; break;
+                case '\r': out += "\\r"; break;
+                case '\t': out += "\\t"; break;
+                case '\b': out += "\\b"; break;
+                case '\f': out += "\\f"; break;
+                default:
+                    out += "\\u00";
+                    out += hex[c >> 4];
+                    out += hex[c & 15];
+            }
+        }
+        out.append(value.data() + plain, value.size() - plain);
+        out += '"';
+    }
+
+    // One budget as a single-line JSON object
+    static void appendBudget(string& out, const Budget& budget) {
+        out += "{\"user\":";
+        appendString(out, budget.getUserName());
+        out += ",\"month\":";
+        appendString(out, budget.getMonth());
+        out += ",\"income\":{";
+        appendField(out, "salary", budget.getSalary());
+        out += ',';
+        appendField(out, "freelance", budget.getFreelance());
+        out += ',';
+        appendField(out, "investments", budget.getInvestments());
+        out += ',';
+        appendField(out, "other", budget.getOtherIncome());
+        out += ',';
+        appendField(out, "total", budget.getTotalIncome());
+        out += "},\"expenses\":{";
+        forEachExpense<&CategoryDescriptor::jsonKey>(budget.getAmounts(), [&out](string_view key, Money amount) {
+            out += '"';
+            out += key;
+            out += "\":";
+            appendMoney(out, amount);
+            out += ',';
+        });
+        appendField(out, "total", budget.getTotalExpenses());
+        out += "},\"summary\":{";
+        appendField(out, "balance", budget.getBalance());
+        out += ',';
+        appendField(out, "savings", budget.getSavings());
+        out += ',';
+        appendField(out, "savingsGoal", budget.getSavingsGoal());
+        out += ",\"savingsPercentage\":";
+        appendDouble(out, budget.getSavingsPercentage());
+        out += "}}";
+    }
+
+    bool open(const string& path, const JsonExportOptions& opts = JsonExportOptions()) {
+        close();
+        options = opts;
+        recordCount = 0;
+        rawBytes = 0;
+        outputBytes = 0;
+        failed = false;
+        if (options.gzip && !gzipAvailable()) {
+            cerr << "Error: This build has no gzip support (compile with BUDGET_HAVE_ZLIB)!" << endl;
+            return false;
+        }
+        if (!file.open(path, true)) {
+            cerr << "Error: Could not open " << path << " for export!" << endl;
+            return false;
+        }
+#ifdef BUDGET_HAVE_ZLIB
+        if (options.gzip) {
+            zip = z_stream();
+            // 15 + 16: default window with a gzip header
+            if (deflateInit2(&zip, options.gzipLevel, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+                cerr << "Error: Could not start gzip stream!" << endl;
+                file.close();
+                return false;
+            }
+            zipOpen = true;
+            compressed.resize(options.bufferSize);
+        }
+#endif
+        buffer.clear();
+        buffer.reserve(options.bufferSize + 4096);
+        if (options.layout == JSON_ARRAY) buffer += '[';
+        return true;
+    }
+
+    bool isOpen() const { return file.isOpen(); }
+
+    bool write(const Budget& budget) {
+        if (failed) return false;
+        if (options.layout == JSON_ARRAY) buffer += recordCount == 0 ? "\n" : ",\n";
+        appendBudget(buffer, budget);
+        if (options.layout == JSON_LINES) buffer += '\n';
+        recordCount++;
+        return buffer.size() < options.bufferSize || drain(false);
+    }
+
+    // Finish the document and close the file; false if anything failed
+    bool close() {
+        if (!file.isOpen()) return !failed;
+        if (options.layout == JSON_ARRAY) buffer += recordCount == 0 ? "]\n" : "\n]\n";
+        bool ok = drain(true) && !failed;
+#ifdef BUDGET_HAVE_ZLIB
+        if (zipOpen) {
+            deflateEnd(&zip);
+            zipOpen = false;
+        }
+#endif
+        file.close();
+        return ok;
+    }
+
+    size_t getRecordCount() const { return recordCount; }
+    uint64_t getRawBytes() const { return rawBytes + buffer.size(); }    // JSON text produced
+    uint64_t getOutputBytes() const { return outputBytes; }              // bytes written to disk
+};
+
+#endif
@@ -0,0 +1,452 @@
+#ifndef JSONIMPORTER_H
+#define JSONIMPORTER_H
+
+#include "Budget.h"
+#include "SystemIO.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <filesystem>
+#include <vector>
+
+// A problem found while importing one JSON file
+struct JsonImportError {
+    string file;
+    size_t line;        // 1-based, 0 when the file could not be read at all
+    size_t column;
+    string message;
+};
+
+// Single-pass reader for budget JSON. Accepts both schemas:
+//   frontend: {"user": {"name", "month"}, "income": {...}, "expenses": {...}, "savingsGoal"}
+//   backend:  {"user", "month", "income": {...}, "expenses": {...}, "summary": {"savingsGoal", ...}}
+// A document may be one object, an array of objects or JSON Lines.
+// Strings are views into the input unless they contain escapes, so the
+// only allocations are the user and month strings of each Budget.
+class JsonBudgetParser {
+private:
+    static constexpr int MAX_DEPTH = 64;
+
+    const char* begin;
+    const char* p;
+    const char* end;
+    const char* errorAt;
+    string errorMessage;
+    string keyStorage;
+    string valueStorage;
+
+    bool fail(const string& message) {
+        if (errorMessage.empty()) {
+            errorMessage = message;
+            errorAt = p;
+        }
+        return false;
+    }
+
+    void skipSpace() {
+        while (p < end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')) p++;
+    }
+
+    bool consume(char c) {
+        skipSpace();
+        if (p < end && *p == c) {
+            p++;
+            return true;
+        }
+        return false;
+    }
+
+    bool expect(char c) {
+        if (consume(c)) return true;
+        return fail(string("expected '") + c + "'");
+    }
+
+    static int hexValue(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    bool readHex4(uint32_t& code) {
+        if (end - p < 4) return fail("truncated \\u escape");
+        code = 0;
+        for (int i = 0; i < 4; i++) {
+            int digit = hexValue(p[i]);
+            if (digit < 0) return fail("invalid \\u escape");
+            code = code * 16 + static_cast<uint32_t>(digit);
+        }
+        p += 4;
+        return true;
+    }
+
+    static void appendUtf8(string& out, uint32_t code) {
+        if (code < 0x80) {
+            out += static_cast<char>(code);
+        } else if (code < 0x800) {
+            out += static_cast<char>(0xC0 | (code >> 6));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else if (code < 0x10000) {
+            out += static_cast<char>(0xE0 | (code >> 12));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (code >> 18));
+            out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+
+    // Parse a string; value views the input, or storage if it had escapes
+    bool readString(string_view& value, string& storage) {
+        if (!expect('"')) return false;
+        const char* start = p;
+        while (p < end && *p != '"' && *p != '\\') {
+            if (static_cast<unsigned char>(*p) < 0x20) return fail("control character in string");
+            p++;
+        }
+        if (p == end) return fail("unterminated string");
+        if (*p == '"') {
+            value = string_view(start, p - start);
+            p++;
+            return true;
+        }
+
+        storage.assign(start, p - start);
+        while (p < end && *p != '"') {
+            char c = *p++;
+            if (static_cast<unsigned char>(c) < 0x20) return fail("control character in string");
+            if (c != '\\') {
+                storage += c;
+                continue;
+            }
+            if (p == end) break;
+            switch (*p++) {
+                case '"': storage += '"'; break;
+                case '\\': storage += '\\'; break;
+                case '/': storage += '/'; break;
+                case 'b': storage += '\b'; break;
+                case 'f': storage += '\f'; break;
+                case 'n': storage += '\n'; break;
+                case 'r': storage += '\r'; break;
+                case 't': storage += '\t'; break;
+                case 'u': {
+                    uint32_t code;
+                    if (!readHex4(code)) return false;
+                    if (code >= 0xD800 && code < 0xDC00) {
+                        uint32_t low;
+                        if (end - p < 2 || p[0] != '\\' || p[1] != 'u') return fail("unpaired surrogate");
+                        p += 2;
+                        if (!readHex4(low)) return false;
+                        if (low < 0xDC00 || low >= 0xE000) return fail("unpaired surrogate");
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    } else if (code >= 0xDC00 && code < 0xE000) {
+                        return fail("unpaired surrogate");
+                    }
+                    appendUtf8(storage, code);
+                    break;
+                }
+                default:
+                    p--;
+                    return fail("invalid escape");
+            }
+        }
+        if (p == end) return fail("unterminated string");
+        p++;
+        value = storage;
+        return true;
+    }
+
+    // Amount as a JSON number; null counts as zero
+    bool readMoney(Money& value) {
+        skipSpace();
+        if (end - p >= 4 && memcmp(p, "null", 4) == 0) {
+            p += 4;
+            value = Money();
+            return true;
+        }
+        const char* start = p;
+        while (p < end && ((*p >= '0' && *p <= '9') || *p == '-' || *p == '+' || *p == '.' || *p == 'e' || *p == 'E')) p++;
+        if (!Money::fromChars(string_view(start, p - start), value)) {
+            p = start;
+            return fail("expected an amount");
+        }
+        return true;
+    }
+
+    bool skipValue(int depth) {
+        if (depth > MAX_DEPTH) return fail("nesting too deep");
+        skipSpace();
+        if (p == end) return fail("unexpected end of input");
+        string_view ignored;
+        switch (*p) {
+            case '"':
+                return readString(ignored, valueStorage);
+            case '{':
+                p++;
+                if (consume('}')) return true;
+                do {
+                    if (!readString(ignored, keyStorage) || !expect(':') || !skipValue(depth + 1)) return false;
+                } while (consume(','));
+                return expect('}');
+            case '[':
+                p++;
+                if (consume(']')) return true;
+                do {
+                    if (!skipValue(depth + 1)) return false;
+                } while (consume(','));
+                return expect(']');
+            default: {
+                const char* start = p;
+                while (p < end && *p != ',' && *p != '}' && *p != ']' && *p != ' ' && *p != '\n' && *p != '\r' && *p != '\t') p++;
+                string_view token(start, p - start);
+                Money unused;
+                if (token == "true" || token == "false" || token == "null" || Money::fromChars(token, unused)) return true;
+                p = start;
+                return fail("invalid value");
+            }
+        }
+    }
+
+    // Walk an object, calling field(key) with p at each value; field
+    // returns false on error and must consume the value
+    template<typename Field>
+    bool readObject(Field field) {
+        if (!expect('{')) return false;
+        if (consume('}')) return true;
+        do {
+            string_view key;
+            if (!readString(key, keyStorage) || !expect(':')) return false;
+            if (!field(key)) return false;
+        } while (consume(','));
+        return expect('}');
+    }
+
+    bool readIncome(Budget& budget) {
+        return readObject([&](string_view key) {
+            Money value;
+            if (key == "salary") { if (!readMoney(value)) return false; budget.setSalary(value); }
+            else if (key == "freelance") { if (!readMoney(value)) return false; budget.setFreelance(value); }
+            else if (key == "investments") { if (!readMoney(value)) return false; budget.setInvestments(value); }
+            else if (key == "other") { if (!readMoney(value)) return false; budget.setOtherIncome(value); }
+            else return skipValue(1);
+            return true;
+        });
+    }
+
+    bool readExpenses(Budget& budget) {
+        return readObject([&](string_view key) {
+            int category = findExpenseCategory<&CategoryDescriptor::jsonKey>(key);
+            if (category < 0) return skipValue(1);
+            Money value;
+            if (!readMoney(value)) return false;
+            budget.setExpense(static_cast<ExpenseCategory>(category), value);
+            return true;
+        });
+    }
+
+    bool readText(string& out) {
+        string_view value;
+        if (!readString(value, valueStorage)) return false;
+        out.assign(value.data(), value.size());
+        return true;
+    }
+
+    bool readBudget(Budget& budget) {
+        string user, month;
+        bool ok = readObject([&](string_view key) {
+            if (key == "user") {
+                skipSpace();
+                if (p < end && *p == '{') {
+                    return readObject([&](string_view field) {
+                        if (field == "name") return readText(user);
+                        if (field == "month") return readText(month);
+                        return skipValue(1);
+                    });
+                }
+                return readText(user);
+            }
+            if (key == "month") return readText(month);
+            if (key == "income") return readIncome(budget);
+            if (key == "expenses") return readExpenses(budget);
+            if (key == "savingsGoal") {
+                Money goal;
+                if (!readMoney(goal)) return false;
+                budget.setSavingsGoal(goal);
+                return true;
+            }
+            if (key == "summary") {
+                return readObject([&](string_view field) {
+                    if (field != "savingsGoal") return skipValue(1);
+                    Money goal;
+                    if (!readMoney(goal)) return false;
+                    budget.setSavingsGoal(goal);
+                    return true;
+                });
+            }
+            return skipValue(1);
+        });
+        budget.setUserName(user);
+        budget.setMonth(month);
+        return ok;
+    }
+
+    void position(const char* at, size_t& line, size_t& column) const {
+        line = 1;
+        const char* lineStart = begin;
+        for (const char* c = begin; c < at; c++) {
+            if (*c == '\n') {
+                line++;
+                lineStart = c + 1;
+            }
+        }
+        column = static_cast<size_t>(at - lineStart) + 1;
+    }
+
+public:
+    JsonBudgetParser() : begin(nullptr), p(nullptr), end(nullptr), errorAt(nullptr) {}
+
+    // Parse a document holding exactly one budget object; user and month
+    // may be missing. On failure error says where and why.
+    bool parseOne(string_view text, Budget& budget, JsonImportError& error) {
+        begin = p = text.data();
+        end = begin + text.size();
+        errorMessage.clear();
+        bool ok = readBudget(budget);
+        skipSpace();
+        if (ok && p != end) ok = fail("unexpected data after object");
+        if (!ok) {
+            error = {"", 0, 0, errorMessage};
+            position(errorAt, error.line, error.column);
+        }
+        return ok;
+    }
+
+    // Parse a whole document, calling visit(const Budget&) for every budget
+    // that has a user and month. Problems are appended to errors; a syntax
+    // error stops the document, a missing name only skips that budget.
+    template<typename Visitor>
+    bool parse(string_view text, const string& name, Visitor visit, vector<JsonImportError>& errors) {
+        begin = p = text.data();
+        end = begin + text.size();
+        errorMessage.clear();
+        bool clean = true;
+
+        auto report = [&](const char* at, const string& message) {
+            JsonImportError error = {name, 0, 0, message};
+            position(at, error.line, error.column);
+            errors.push_back(error);
+            clean = false;
+        };
+
+        auto readOne = [&]() {
+            skipSpace();
+            const char* start = p;
+            Budget budget;
+            if (!readBudget(budget)) return false;
+            if (budget.getUserName().empty() || budget.getMonth().empty()) {
+                report(start, "budget without user name or month skipped");
+            } else if (!budget.hasValidNames()) {
+                report(start, "budget with control characters in user name or month skipped");
+            } else {
+                visit(static_cast<const Budget&>(budget));
+            }
+            return true;
+        };
+
+        skipSpace();
+        bool ok = true;
+        if (p < end && *p == '[') {
+            p++;
+            if (!consume(']')) {
+                do {
+                    ok = readOne();
+                } while (ok && consume(','));
+                ok = ok && expect(']');
+            }
+            skipSpace();
+            if (ok && p != end) ok = fail("unexpected data after array");
+        } else {
+            while (ok && p < end) {
+                ok = readOne();
+                skipSpace();
+            }
+        }
+        if (!ok) report(errorAt, errorMessage);
+        return clean;
+    }
+};
+
+// Totals of a directory import
+struct JsonImportSummary {
+    size_t files;
+    size_t failedFiles;     // files with at least one error
+    size_t budgets;
+};
+
+class JsonImporter {
+public:
+    // Map and parse one file
+    template<typename Visitor>
+    static bool importFile(const string& path, Visitor visit, vector<JsonImportError>& errors) {
+        MappedFile file;
+        if (!file.open(path)) {
+            errors.push_back({path, 0, 0, "could not open file"});
+            return false;
+        }
+        JsonBudgetParser parser;
+        return parser.parse(string_view(file.begin(), file.size()), path, visit, errors);
+    }
+
+    static bool importFile(const string& path, vector<Budget>& budgets, vector<JsonImportError>& errors) {
+        return importFile(path, [&budgets](const Budget& b) { budgets.push_back(b); }, errors);
+    }
+
+    // Every *.json / *.jsonl file directly inside dir, sorted by name
+    static vector<string> listFiles(const string& dir) {
+        vector<string> files;
+        error_code ec;
+        for (const auto& entry : filesystem::directory_iterator(dir, ec)) {
+            string extension = entry.path().extension().string();
+            if (entry.is_regular_file(ec) && (extension == ".json" || extension == ".jsonl")) {
+                files.push_back(entry.path().string());
+            }
+        }
+        sort(files.begin(), files.end());
+        return files;
+    }
+
+    // Parse many files in parallel (threads 0 = all cores); budgets and
+    // errors come back in file order whatever the thread count
+    static JsonImportSummary importFiles(const vector<string>& paths, vector<Budget>& budgets,
+                                         vector<JsonImportError>& errors, size_t threads = 0) {
+        struct FileResult {
+            vector<Budget> budgets;
+            vector<JsonImportError> errors;
+        };
+        vector<FileResult> results(paths.size());
+        {
+            ThreadPool pool(min(threads == 0 ? ThreadPool::defaultThreadCount() : threads, max<size_t>(paths.size(), 1)));
+            pool.parallelFor(paths.size(), [&](size_t i) { importFile(paths[i], results[i].budgets, results[i].errors); });
+        }
+
+        JsonImportSummary summary = {paths.size(), 0, 0};
+        for (FileResult& result : results) {
+            if (!result.errors.empty()) summary.failedFiles++;
+            summary.budgets += result.budgets.size();
+            move(result.budgets.begin(), result.budgets.end(), back_inserter(budgets));
+            move(result.errors.begin(), result.errors.end(), back_inserter(errors));
+        }
+        return summary;
+    }
+
+    // A single file, or every JSON file in a directory
+    static JsonImportSummary importPath(const string& path, vector<Budget>& budgets, vector<JsonImportError>& errors,
+                                        size_t threads = 0) {
+        error_code ec;
+        if (filesystem::is_directory(path, ec)) return importFiles(listFiles(path), budgets, errors, threads);
+        return importFiles(vector<string>{path}, budgets, errors, 1);
+    }
+};
+
+#endif
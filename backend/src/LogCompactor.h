@@ -0,0 +1,198 @@
+#ifndef LOGCOMPACTOR_H
+#define LOGCOMPACTOR_H
+
+#include "BudgetIndex.h"
+#include "SystemIO.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <unordered_map>
+
+// When a budget log is worth compacting
+struct CompactionPolicy {
+    double garbageRatio;    // superseded records / all records
+    uint64_t minBytes;      // never compact a log smaller than this
+    uint64_t maxBytes;      // compact any log larger than this; 0 = no size trigger
+
+    CompactionPolicy(double ratio = 0.5, uint64_t minimum = 1 << 20, uint64_t maximum = 0)
+        : garbageRatio(ratio), minBytes(minimum), maxBytes(maximum) {}
+
+    bool due(uint64_t logBytes, size_t totalRecords, size_t liveRecords) const {
+        if (logBytes < minBytes || totalRecords == 0) return false;
+        if (maxBytes > 0 && logBytes >= maxBytes) return true;
+        return static_cast<double>(totalRecords - liveRecords) / static_cast<double>(totalRecords) >= garbageRatio;
+    }
+};
+
+struct CompactionReport {
+    uint64_t bytesBefore;
+    uint64_t bytesAfter;
+    size_t recordsBefore;
+    size_t recordsKept;
+    size_t malformedLines;  // flagged by the parser; lines outside any record are not copied
+    double seconds;
+
+    CompactionReport() : bytesBefore(0), bytesAfter(0), recordsBefore(0), recordsKept(0), malformedLines(0), seconds(0) {}
+
+    uint64_t bytesReclaimed() const { return bytesBefore > bytesAfter ? bytesBefore - bytesAfter : 0; }
+};
+
+// Rewrites a text budget log so only the newest record per (user, month)
+// survives. start() scans and copies the log up to a committed offset on
+// a background thread into "<log>.compact" while the log keeps taking
+// appends. finish() then copies the records appended meanwhile, syncs
+// the new file and renames it over the log; it must run while nothing
+// appends. Records are copied byte for byte in their original order, so
+// the newest version of each budget still comes last.
+class LogCompactor {
+private:
+    // Keeps the byte range of the newest record per key below a limit
+    class LatestSink {
+    private:
+        unordered_map<string, IndexEntry> latest;
+        string key;
+        uint64_t limit;
+        size_t records;
+
+    public:
+        explicit LatestSink(uint64_t end) : limit(end), records(0) {}
+        void begin() { key.clear(); }
+        void setText(int field, string_view value) {
+            // "user\nmonth"; savers reject names with a newline (validateName)
+            if (field == KEY_USER) key.insert(0, string(value) + '\n');
+            else key.append(value.data(), value.size());
+        }
+        void setValue(int, Money) {}
+        void commit(uint64_t start, uint64_t end) {
+            if (end > limit) return;
+            latest[key] = IndexEntry{start, end};
+            records++;
+        }
+        void discard() {}
+        void reserve(size_t) {}
+
+        size_t getRecords() const { return records; }
+
+        vector<IndexEntry> inFileOrder() const {
+            vector<IndexEntry> ranges;
+            ranges.reserve(latest.size());
+            for (const auto& entry : latest) ranges.push_back(entry.second);
+            sort(ranges.begin(), ranges.end(), [](const IndexEntry& a, const IndexEntry& b) { return a.offset < b.offset; });
+            return ranges;
+        }
+    };
+
+    static constexpr size_t COPY_CHUNK = 1 << 20;
+
+    string logPath;
+    string tempPath;
+    uint64_t stableEnd;         // log bytes the background pass covers
+    thread worker;
+    atomic<bool> done;
+    bool copied;                // background pass succeeded
+    bool installed;
+    CompactionReport report;
+    chrono::steady_clock::time_point started;
+
+    // Copy [from, to) of the log, which must already be committed
+    static bool copyRange(const MappedFile& source, uint64_t from, uint64_t to, AppendFile& out) {
+        while (from < to) {
+            size_t chunk = static_cast<size_t>(min<uint64_t>(to - from, COPY_CHUNK));
+            if (!out.write(source.begin() + from, chunk)) return false;
+            from += chunk;
+        }
+        return true;
+    }
+
+    void copyLive() {
+        copied = false;
+        LatestSink sink(stableEnd);
+        BudgetTextParser parser;
+        MappedFile source;
+        AppendFile out;
+        if (parser.parseFile(logPath, sink) && source.open(logPath) && source.size() >= stableEnd &&
+            out.open(tempPath, true)) {
+            vector<IndexEntry> ranges = sink.inFileOrder();
+            // Adjacent survivors are copied as one run
+            bool ok = true;
+            size_t i = 0;
+            while (ok && i < ranges.size()) {
+                uint64_t runStart = ranges[i].offset;
+                uint64_t runEnd = ranges[i].end;
+                for (i++; i < ranges.size() && ranges[i].offset == runEnd; i++) runEnd = ranges[i].end;
+                ok = copyRange(source, runStart, runEnd, out);
+                report.bytesAfter += runEnd - runStart;
+            }
+            report.recordsBefore = sink.getRecords();
+            report.recordsKept = ranges.size();
+            report.malformedLines = parser.errors().size();
+            copied = ok;
+        }
+        done = true;
+    }
+
+    void join() {
+        if (worker.joinable()) worker.join();
+    }
+
+public:
+    LogCompactor() : stableEnd(0), done(false), copied(false), installed(false) {}
+
+    // An unfinished compaction is abandoned and its temporary file removed
+    ~LogCompactor() {
+        join();
+        if (!installed && !tempPath.empty()) remove(tempPath.c_str());
+    }
+
+    LogCompactor(const LogCompactor&) = delete;
+    LogCompactor& operator=(const LogCompactor&) = delete;
+
+    static string tempPathFor(const string& log) { return log + ".compact"; }
+
+    // Begin compacting log up to committedEnd on a background thread
+    bool start(const string& log, uint64_t committedEnd) {
+        if (worker.joinable()) return false;
+        logPath = log;
+        tempPath = tempPathFor(log);
+        stableEnd = committedEnd;
+        report = CompactionReport();
+        done = false;
+        installed = false;
+        started = chrono::steady_clock::now();
+        worker = thread(&LogCompactor::copyLive, this);
+        return true;
+    }
+
+    // The background pass has finished and finish() won't block
+    bool ready() const { return done; }
+
+    // Wait for the background pass, append what was written after it
+    // started, then swap the new file in. Appends must be stopped and
+    // committed, and the log's writer closed (Windows can't rename over
+    // an open file).
+    bool finish(CompactionReport& result) {
+        join();
+        bool ok = copied;
+        if (ok) {
+            MappedFile source;
+            AppendFile out;
+            ok = source.open(logPath) && out.open(tempPath) && source.size() >= stableEnd &&
+                 copyRange(source, stableEnd, source.size(), out) && out.sync();
+            report.bytesBefore = source.size();
+            report.bytesAfter += source.size() - min<uint64_t>(stableEnd, source.size());
+            out.close();
+            source.close();
+            ok = ok && replaceFile(tempPath, logPath);
+        }
+        if (!ok) {
+            cerr << "Error: Could not compact " << logPath << "!" << endl;
+            remove(tempPath.c_str());
+        }
+        installed = true;
+        report.seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+        result = report;
+        return ok;
+    }
+};
+
+#endif
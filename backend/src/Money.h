@@ -0,0 +1,174 @@
+#ifndef MONEY_H
+#define MONEY_H
+
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+// Fixed-point amount stored as int64 cents.
+// Sums are exact and independent of evaluation order; overflow is checked
+// in debug builds (NDEBUG not defined).
+class Money {
+private:
+    int64_t cents;
+
+    constexpr explicit Money(int64_t c) : cents(c) {}
+
+    [[noreturn]] static void overflow(const char* operation) {
+        cerr << "Fatal: Money overflow in " << operation << endl;
+        abort();
+    }
+
+    static constexpr int64_t add(int64_t a, int64_t b) {
+#ifndef NDEBUG
+        if ((b > 0 && a > numeric_limits<int64_t>::max() - b) ||
+            (b < 0 && a < numeric_limits<int64_t>::min() - b)) overflow("addition");
+#endif
+        return a + b;
+    }
+
+    static constexpr int64_t subtract(int64_t a, int64_t b) {
+#ifndef NDEBUG
+        if ((b < 0 && a > numeric_limits<int64_t>::max() + b) ||
+            (b > 0 && a < numeric_limits<int64_t>::min() + b)) overflow("subtraction");
+#endif
+        return a - b;
+    }
+
+    static constexpr int64_t multiply(int64_t a, int64_t b) {
+#ifndef NDEBUG
+        if (a != 0 && b != 0) {
+            int64_t result = static_cast<int64_t>(static_cast<uint64_t>(a) * static_cast<uint64_t>(b));
+            if (result / b != a || (a == -1 && b == numeric_limits<int64_t>::min()) ||
+                (b == -1 && a == numeric_limits<int64_t>::min())) overflow("multiplication");
+        }
+#endif
+        return a * b;
+    }
+
+public:
+    // Longest text produced by toChars: sign, 17 digits, point, 2 decimals
+    static constexpr size_t MAX_CHARS = 24;
+
+    constexpr Money() : cents(0) {}
+
+    static constexpr Money fromCents(int64_t c) { return Money(c); }
+
+    // Nearest cent to a floating point amount
+    static Money fromDouble(double amount) { return Money(llround(amount * 100.0)); }
+
+    constexpr int64_t getCents() const { return cents; }
+    constexpr double toDouble() const { return static_cast<double>(cents) / 100.0; }
+
+    constexpr Money operator+(Money other) const { return Money(add(cents, other.cents)); }
+    constexpr Money operator-(Money other) const { return Money(subtract(cents, other.cents)); }
+    constexpr Money operator-() const { return Money(subtract(0, cents)); }
+    constexpr Money operator*(int64_t factor) const { return Money(multiply(cents, factor)); }
+    constexpr Money& operator+=(Money other) { cents = add(cents, other.cents); return *this; }
+    constexpr Money& operator-=(Money other) { cents = subtract(cents, other.cents); return *this; }
+
+    constexpr bool operator==(Money other) const { return cents == other.cents; }
+    constexpr bool operator!=(Money other) const { return cents != other.cents; }
+    constexpr bool operator<(Money other) const { return cents < other.cents; }
+    constexpr bool operator<=(Money other) const { return cents <= other.cents; }
+    constexpr bool operator>(Money other) const { return cents > other.cents; }
+    constexpr bool operator>=(Money other) const { return cents >= other.cents; }
+
+    // Write "-1234.56" style text, returns one past the last character
+    char* toChars(char* first, char* last) const {
+        if (last - first < static_cast<ptrdiff_t>(MAX_CHARS)) return first;
+        uint64_t magnitude = cents < 0 ? 0 - static_cast<uint64_t>(cents) : static_cast<uint64_t>(cents);
+        if (cents < 0) *first++ = '-';
+        first = to_chars(first, last, magnitude / 100).ptr;
+        unsigned fraction = static_cast<unsigned>(magnitude % 100);
+        *first++ = '.';
+        *first++ = static_cast<char>('0' + fraction / 10);
+        *first++ = static_cast<char>('0' + fraction % 10);
+        return first;
+    }
+
+    string toString() const {
+        char buffer[MAX_CHARS];
+        return string(buffer, toChars(buffer, buffer + sizeof(buffer)));
+    }
+
+    // Parse "123", "-12.5", "0.075" (rounded half away from zero) and,
+    // for files written by older versions, exponent forms like "1e+06".
+    // Returns false on malformed or out-of-range input.
+    static bool fromChars(string_view text, Money& value) {
+        while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) text.remove_prefix(1);
+        while (!text.empty() && (text.back() == ' ' || text.back() == '\t' || text.back() == '\r')) text.remove_suffix(1);
+        if (text.empty()) return false;
+
+        const char* p = text.data();
+        const char* end = p + text.size();
+        bool negative = *p == '-';
+        if (*p == '-' || *p == '+') p++;
+        if (p == end) return false;
+
+        const uint64_t MAX_WHOLE = static_cast<uint64_t>(numeric_limits<int64_t>::max()) / 100;
+        uint64_t whole = 0;
+        int fraction = 0;
+        int fractionDigits = 0;
+        bool roundUp = false;
+        bool sawDigit = false;
+        bool sawPoint = false;
+
+        for (; p != end; p++) {
+            char c = *p;
+            if (c >= '0' && c <= '9') {
+                sawDigit = true;
+                if (!sawPoint) {
+                    // Bounded so whole * 100 below can't wrap
+                    uint64_t digit = c - '0';
+                    if (whole > (MAX_WHOLE - digit) / 10) return false;
+                    whole = whole * 10 + digit;
+                } else if (fractionDigits < 2) {
+                    fraction = fraction * 10 + (c - '0');
+                    fractionDigits++;
+                } else if (fractionDigits == 2) {
+                    roundUp = c >= '5';
+                    fractionDigits++;
+                }
+            } else if (c == '.' && !sawPoint) {
+                sawPoint = true;
+            } else if (c == 'e' || c == 'E') {
+                double amount;
+                auto result = from_chars(text.data() + (text.front() == '+'), end, amount);
+                if (result.ec != errc() || result.ptr != end || !(fabs(amount) < 9.0e16)) return false;
+                value = fromDouble(amount);
+                return true;
+            } else {
+                return false;
+            }
+        }
+        if (!sawDigit) return false;
+
+        if (fractionDigits == 1) fraction *= 10;
+        uint64_t magnitude = whole * 100 + fraction + (roundUp ? 1 : 0);
+        if (magnitude > static_cast<uint64_t>(numeric_limits<int64_t>::max())) return false;
+        value = Money(negative ? -static_cast<int64_t>(magnitude) : static_cast<int64_t>(magnitude));
+        return true;
+    }
+};
+
+inline ostream& operator<<(ostream& out, Money amount) {
+    char buffer[Money::MAX_CHARS + 1];
+    *amount.toChars(buffer, buffer + Money::MAX_CHARS) = '\0';
+    return out << buffer;
+}
+
+inline istream& operator>>(istream& in, Money& amount) {
+    string token;
+    if (in >> token && !Money::fromChars(token, amount)) in.setstate(ios::failbit);
+    return in;
+}
+
+#endif
@@ -0,0 +1,298 @@
+#ifndef PRICEHISTORY_H
+#define PRICEHISTORY_H
+
+#include "GroceryLedger.h"
+#include <algorithm>
+
+// Calendar helpers for day numbers (days since 1970-01-01)
+struct DayNumber {
+    // YYYYMMDD -> day number
+    static uint32_t fromDate(uint32_t date) {
+        int y = static_cast<int>(date / 10000);
+        unsigned m = (date / 100) % 100;
+        unsigned d = date % 100;
+        y -= m <= 2;
+        int era = (y >= 0 ? y : y - 399) / 400;
+        unsigned yoe = static_cast<unsigned>(y - era * 400);
+        unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+        unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return static_cast<uint32_t>(era * 146097 + static_cast<int>(doe) - 719468);
+    }
+
+    // Day number -> YYYYMMDD
+    static uint32_t toDate(uint32_t day) {
+        int z = static_cast<int>(day) + 719468;
+        int era = (z >= 0 ? z : z - 146096) / 146097;
+        unsigned doe = static_cast<unsigned>(z - era * 146097);
+        unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        int y = static_cast<int>(yoe) + era * 400;
+        unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        unsigned mp = (5 * doy + 2) / 153;
+        unsigned d = doy - (153 * mp + 2) / 5 + 1;
+        unsigned m = mp < 10 ? mp + 3 : mp - 9;
+        y += m <= 2;
+        return static_cast<uint32_t>(y) * 10000 + m * 100 + d;
+    }
+};
+
+// Summary of one block of a series: scans skip blocks whose day or price
+// range cannot match
+struct PriceBlock {
+    uint32_t firstDay;
+    uint32_t lastDay;
+    int64_t minCents;
+    int64_t maxCents;
+    uint32_t count;
+    uint32_t byteOffset;    // start of this block's day deltas
+};
+
+// Price points of one item in day order. Days are delta encoded as
+// LEB128 varints (one byte for gaps under 128 days); prices are plain
+// int64 cents so a block's prices are a contiguous slice.
+class PriceSeries {
+public:
+    static constexpr uint32_t BLOCK_POINTS = 128;
+
+private:
+    vector<PriceBlock> blocks;
+    vector<uint8_t> dayDeltas;
+    vector<int64_t> prices;
+    uint32_t lastDay;
+
+    static void putVarint(vector<uint8_t>& out, uint32_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    static const uint8_t* getVarint(const uint8_t* p, uint32_t& value) {
+        uint32_t result = 0;
+        int shift = 0;
+        while (*p & 0x80) {
+            result |= static_cast<uint32_t>(*p++ & 0x7F) << shift;
+            shift += 7;
+        }
+        value = result | (static_cast<uint32_t>(*p++) << shift);
+        return p;
+    }
+
+    // First block whose last day is >= day
+    size_t firstBlockFrom(uint32_t day) const {
+        return lower_bound(blocks.begin(), blocks.end(), day,
+                           [](const PriceBlock& b, uint32_t d) { return b.lastDay < d; }) - blocks.begin();
+    }
+
+public:
+    PriceSeries() : lastDay(0) {}
+
+    // Points must arrive in non-decreasing day order
+    bool append(uint32_t day, Money price) {
+        if (!prices.empty() && day < lastDay) return false;
+        int64_t cents = price.getCents();
+        if (prices.size() % BLOCK_POINTS == 0) {
+            blocks.push_back({day, day, cents, cents, 0, static_cast<uint32_t>(dayDeltas.size())});
+        } else {
+            putVarint(dayDeltas, day - lastDay);
+        }
+        PriceBlock& block = blocks.back();
+        block.lastDay = day;
+        block.minCents = min(block.minCents, cents);
+        block.maxCents = max(block.maxCents, cents);
+        block.count++;
+        prices.push_back(cents);
+        lastDay = day;
+        return true;
+    }
+
+    size_t size() const { return prices.size(); }
+    size_t blockCount() const { return blocks.size(); }
+    size_t encodedBytes() const { return dayDeltas.size() + blocks.size() * sizeof(PriceBlock); }
+
+    // Days of block b into days[0..count)
+    void decodeDays(size_t b, uint32_t* days) const {
+        const PriceBlock& block = blocks[b];
+        const uint8_t* p = dayDeltas.data() + block.byteOffset;
+        days[0] = block.firstDay;
+        for (uint32_t i = 1; i < block.count; i++) {
+            uint32_t delta;
+            p = getVarint(p, delta);
+            days[i] = days[i - 1] + delta;
+        }
+    }
+
+    // visit(day, price) for every point with from <= day <= to
+    template<typename Visitor>
+    void scan(uint32_t from, uint32_t to, Visitor visit) const {
+        uint32_t days[BLOCK_POINTS];
+        for (size_t b = firstBlockFrom(from); b < blocks.size() && blocks[b].firstDay <= to; b++) {
+            decodeDays(b, days);
+            const int64_t* blockPrices = prices.data() + b * BLOCK_POINTS;
+            for (uint32_t i = 0; i < blocks[b].count; i++) {
+                if (days[i] >= from && days[i] <= to) visit(days[i], Money::fromCents(blockPrices[i]));
+            }
+        }
+    }
+
+    // Like scan, but only points priced above threshold; blocks whose
+    // maximum is not above it are skipped without decoding
+    template<typename Visitor>
+    void scanAbove(uint32_t from, uint32_t to, Money threshold, Visitor visit) const {
+        uint32_t days[BLOCK_POINTS];
+        for (size_t b = firstBlockFrom(from); b < blocks.size() && blocks[b].firstDay <= to; b++) {
+            if (blocks[b].maxCents <= threshold.getCents()) continue;
+            decodeDays(b, days);
+            const int64_t* blockPrices = prices.data() + b * BLOCK_POINTS;
+            for (uint32_t i = 0; i < blocks[b].count; i++) {
+                if (days[i] >= from && days[i] <= to && blockPrices[i] > threshold.getCents()) {
+                    visit(days[i], Money::fromCents(blockPrices[i]));
+                }
+            }
+        }
+    }
+
+    // Lowest and highest price within [from, to]; blocks fully inside the
+    // range answer from their summary. False if there is no point.
+    bool minMax(uint32_t from, uint32_t to, Money& low, Money& high) const {
+        int64_t lo = numeric_limits<int64_t>::max();
+        int64_t hi = numeric_limits<int64_t>::min();
+        uint32_t days[BLOCK_POINTS];
+        for (size_t b = firstBlockFrom(from); b < blocks.size() && blocks[b].firstDay <= to; b++) {
+            const PriceBlock& block = blocks[b];
+            if (block.firstDay >= from && block.lastDay <= to) {
+                lo = min(lo, block.minCents);
+                hi = max(hi, block.maxCents);
+                continue;
+            }
+            decodeDays(b, days);
+            const int64_t* blockPrices = prices.data() + b * BLOCK_POINTS;
+            for (uint32_t i = 0; i < block.count; i++) {
+                if (days[i] >= from && days[i] <= to) {
+                    lo = min(lo, blockPrices[i]);
+                    hi = max(hi, blockPrices[i]);
+                }
+            }
+        }
+        if (lo > hi) return false;
+        low = Money::fromCents(lo);
+        high = Money::fromCents(hi);
+        return true;
+    }
+
+    // Latest price on or before day, false if the series starts later
+    bool priceAt(uint32_t day, Money& price) const {
+        if (blocks.empty() || blocks[0].firstDay > day) return false;
+        // Last block starting on or before day
+        size_t b = upper_bound(blocks.begin(), blocks.end(), day,
+                               [](uint32_t d, const PriceBlock& blk) { return d < blk.firstDay; }) - blocks.begin() - 1;
+        uint32_t days[BLOCK_POINTS];
+        decodeDays(b, days);
+        uint32_t i = static_cast<uint32_t>(upper_bound(days, days + blocks[b].count, day) - days) - 1;
+        price = Money::fromCents(prices[b * BLOCK_POINTS + i]);
+        return true;
+    }
+
+    // First price on or after day, false if there is none
+    bool firstPriceFrom(uint32_t day, Money& price) const {
+        size_t b = firstBlockFrom(day);
+        if (b == blocks.size()) return false;
+        uint32_t days[BLOCK_POINTS];
+        decodeDays(b, days);
+        uint32_t i = static_cast<uint32_t>(lower_bound(days, days + blocks[b].count, day) - days);
+        price = Money::fromCents(prices[b * BLOCK_POINTS + i]);
+        return true;
+    }
+};
+
+// An item whose price moved over a period
+struct PriceChange {
+    uint32_t itemId;
+    Money startPrice;
+    Money endPrice;
+};
+
+// Per-item price time series for a grocery catalog
+class PriceHistory {
+private:
+    StringInterner items;
+    vector<PriceSeries> series;
+    size_t pointCount;
+
+public:
+    PriceHistory() : pointCount(0) {}
+
+    // Record item's price on a YYYYMMDD date; dates per item must not go back
+    bool add(string_view item, uint32_t date, Money price) {
+        uint32_t id = items.intern(item);
+        if (id == series.size()) series.emplace_back();
+        if (!series[id].append(DayNumber::fromDate(date), price)) {
+            cerr << "Error: Price for " << item << " on " << date << " is older than its history!" << endl;
+            return false;
+        }
+        pointCount++;
+        return true;
+    }
+
+    // Import every unit price of a grocery ledger, in date order per item
+    void add(const GroceryLedger& ledger) {
+        vector<const GroceryLine*> lines;
+        lines.reserve(ledger.size());
+        ledger.forEach([&lines](const GroceryLine& line) { lines.push_back(&line); });
+        stable_sort(lines.begin(), lines.end(), [](const GroceryLine* a, const GroceryLine* b) { return a->date < b->date; });
+        for (const GroceryLine* line : lines) add(ledger.itemName(*line), line->date, line->unitPrice);
+    }
+
+    size_t size() const { return pointCount; }
+    size_t itemCount() const { return items.size(); }
+    const string& itemName(uint32_t id) const { return items.lookup(id); }
+
+    // Series of one item, nullptr if it has no prices
+    const PriceSeries* find(string_view item) const {
+        uint32_t id = items.find(item);
+        return id < series.size() ? &series[id] : nullptr;
+    }
+
+    // visit(date, price) for item's prices between two YYYYMMDD dates
+    template<typename Visitor>
+    void range(string_view item, uint32_t fromDate, uint32_t toDate, Visitor visit) const {
+        const PriceSeries* s = find(item);
+        if (!s) return;
+        s->scan(DayNumber::fromDate(fromDate), DayNumber::fromDate(toDate),
+                [&visit](uint32_t day, Money price) { visit(DayNumber::toDate(day), price); });
+    }
+
+    bool minMax(string_view item, uint32_t fromDate, uint32_t toDate, Money& low, Money& high) const {
+        const PriceSeries* s = find(item);
+        return s && s->minMax(DayNumber::fromDate(fromDate), DayNumber::fromDate(toDate), low, high);
+    }
+
+    bool priceAt(string_view item, uint32_t date, Money& price) const {
+        const PriceSeries* s = find(item);
+        return s && s->priceAt(DayNumber::fromDate(date), price);
+    }
+
+    // Items whose price at toDate is more than percent above their price at
+    // fromDate (or their first price after it, for items introduced later)
+    vector<PriceChange> risers(uint32_t fromDate, uint32_t toDate, int percent) const {
+        uint32_t from = DayNumber::fromDate(fromDate);
+        uint32_t to = DayNumber::fromDate(toDate);
+        vector<PriceChange> result;
+        for (uint32_t id = 0; id < series.size(); id++) {
+            Money start, end;
+            if (!series[id].priceAt(from, start) && !series[id].firstPriceFrom(from, start)) continue;
+            if (!series[id].priceAt(to, end) || start <= Money()) continue;
+            if (end.getCents() * 100 > start.getCents() * (100 + percent)) result.push_back({id, start, end});
+        }
+        return result;
+    }
+
+    // Bytes used for timestamps and block summaries
+    size_t encodedBytes() const {
+        size_t bytes = 0;
+        for (const PriceSeries& s : series) bytes += s.encodedBytes();
+        return bytes;
+    }
+};
+
+#endif
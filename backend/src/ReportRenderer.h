@@ -0,0 +1,180 @@
+#ifndef REPORTRENDERER_H
+#define REPORTRENDERER_H
+
+#include "Budget.h"
+#include "BudgetWriter.h"
+#include "Stats.h"
+#include <charconv>
+#include <cstdio>
+#include <string_view>
+
+enum ReportFormat {
+    REPORT_TEXT,        // the "Quick Summary" blocks of the interactive menu
+    REPORT_CSV,         // USER, MONTH, the 14 file keys, then totals
+    REPORT_MARKDOWN     // one table row per budget
+};
+
+// Renders many budgets into one reusable buffer and writes it out in
+// large chunks, instead of a flushing cout line per field. Numbers are
+// formatted with to_chars, and the text format matches
+// displayBudgetSummary byte for byte. The interactive single-budget views
+// keep using iostreams.
+class ReportRenderer {
+private:
+    static constexpr size_t FLUSH_BYTES = 1 << 20;
+
+    FILE* out;
+    ReportFormat format;
+    string buffer;
+    size_t count;
+    bool headerWritten;
+    bool failed;
+
+    void put(string_view text) { buffer.append(text.data(), text.size()); }
+
+    void putMoney(Money amount) {
+        char digits[Money::MAX_CHARS];
+        buffer.append(digits, amount.toChars(digits, digits + sizeof(digits)));
+    }
+
+    void putCount(uint64_t value) {
+        char digits[24];
+        buffer.append(digits, to_chars(digits, digits + sizeof(digits), value).ptr);
+    }
+
+    void putCsvField(string_view field) {
+        if (field.find_first_of(",\"\r\n") == string_view::npos) {
+            put(field);
+            return;
+        }
+        buffer += '"';
+        for (char c : field) {
+            if (c == '"') buffer += '"';
+            buffer += c;
+        }
+        buffer += '"';
+    }
+
+    void putMarkdownCell(string_view cell) {
+        for (char c : cell) {
+            if (c == '|' || c == '\\') buffer += '\\';
+            buffer += (c == '\n' || c == '\r') ? ' ' : c;
+        }
+    }
+
+    void writeHeader() {
+        headerWritten = true;
+        if (format == REPORT_TEXT) {
+            put("\n--- Previous Budgets ---\n");
+        } else if (format == REPORT_CSV) {
+            put("USER,MONTH");
+            for (int c = 0; c < NUM_BUDGET_COLUMNS; c++) {
+                buffer += ',';
+                put(BudgetWriter::key(c));
+            }
+            put(",TOTAL_INCOME,TOTAL_EXPENSES,BALANCE\n");
+        } else {
+            put("| # | User | Month | Income | Expenses | Balance | Savings % | Goal met |\n");
+            put("|---:|---|---|---:|---:|---:|---:|:---:|\n");
+        }
+    }
+
+    bool writeBuffer() {
+        if (!buffer.empty() && !failed && fwrite(buffer.data(), 1, buffer.size(), out) != buffer.size()) {
+            failed = true;
+        }
+        buffer.clear();
+        return !failed;
+    }
+
+public:
+    explicit ReportRenderer(FILE* output = stdout, ReportFormat fmt = REPORT_TEXT)
+        : out(output), format(fmt), count(0), headerWritten(false), failed(false) {
+        buffer.reserve(FLUSH_BYTES + 4096);
+    }
+
+    ~ReportRenderer() { writeBuffer(); }
+
+    ReportRenderer(const ReportRenderer&) = delete;
+    ReportRenderer& operator=(const ReportRenderer&) = delete;
+
+    // "text", "csv", "md" or "markdown"
+    static bool parseFormat(string_view name, ReportFormat& result) {
+        if (name == "text") result = REPORT_TEXT;
+        else if (name == "csv") result = REPORT_CSV;
+        else if (name == "md" || name == "markdown") result = REPORT_MARKDOWN;
+        else return false;
+        return true;
+    }
+
+    void add(const Budget& budget) {
+        if (!headerWritten) writeHeader();
+        count++;
+        Money income = budget.getTotalIncome();
+        Money expenses = budget.getTotalExpenses();
+        if (format == REPORT_TEXT) {
+            put("\n[Budget #");
+            putCount(count);
+            put("]\n\n--- Quick Summary ---\nUser: ");
+            put(budget.getUserName());
+            put("\nMonth: ");
+            put(budget.getMonth());
+            put("\nIncome: $");
+            putMoney(income);
+            put("\nExpenses: $");
+            putMoney(expenses);
+            put("\nBalance: $");
+            putMoney(income - expenses);
+            buffer += '\n';
+        } else if (format == REPORT_CSV) {
+            putCsvField(budget.getUserName());
+            buffer += ',';
+            putCsvField(budget.getMonth());
+            for (int c = 0; c < NUM_BUDGET_COLUMNS; c++) {
+                buffer += ',';
+                putMoney(BudgetColumns::get(budget, c));
+            }
+            buffer += ',';
+            putMoney(income);
+            buffer += ',';
+            putMoney(expenses);
+            buffer += ',';
+            putMoney(income - expenses);
+            buffer += '\n';
+        } else {
+            put("| ");
+            putCount(count);
+            put(" | ");
+            putMarkdownCell(budget.getUserName());
+            put(" | ");
+            putMarkdownCell(budget.getMonth());
+            put(" | ");
+            putMoney(income);
+            put(" | ");
+            putMoney(expenses);
+            put(" | ");
+            putMoney(income - expenses);
+            put(" | ");
+            char digits[32];
+            buffer.append(digits, to_chars(digits, digits + sizeof(digits), budget.getSavingsPercentage(),
+                                           chars_format::fixed, 1).ptr);
+            put(budget.isSavingsGoalMet() ? " | yes |\n" : " | no |\n");
+        }
+        if (buffer.size() >= FLUSH_BYTES) writeBuffer();
+    }
+
+    // Write what is left; returns the number of budgets rendered. An empty
+    // text report writes nothing, so the caller can print its own message.
+    size_t finish() {
+        if (!headerWritten && format != REPORT_TEXT) writeHeader();
+        writeBuffer();
+        if (fflush(out) != 0) failed = true;
+        BUDGET_STAT_ADD(STAT_REPORTS_RENDERED, count);
+        return count;
+    }
+
+    size_t size() const { return count; }
+    bool ok() const { return !failed; }
+};
+
+#endif
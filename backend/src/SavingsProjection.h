@@ -0,0 +1,350 @@
+#ifndef SAVINGSPROJECTION_H
+#define SAVINGSPROJECTION_H
+
+#include "Budget.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BUDGET_HAVE_AVX2_PROJECTION 1
+#include <immintrin.h>
+#endif
+
+// Monthly amounts a projection samples from, one table per source: total
+// income, then each expense category negated, so a simulated month's net
+// savings is the sum of one draw per source. Sources are drawn
+// independently, which keeps each category's own spread but not how
+// categories move together.
+class SavingsModel {
+public:
+    static constexpr int SOURCES = NUM_EXPENSE_CATEGORIES + 1;
+    static constexpr size_t MAX_HISTORY = 65536;    // draws scale a 16-bit fraction
+
+private:
+    vector<int64_t> values;     // source-major, history months per source
+    size_t months;
+
+public:
+    SavingsModel() : months(0) {}
+
+    // Tables from one user's budgets, one per month; only the most recent
+    // MAX_HISTORY are used. False if there are none.
+    bool build(const vector<const Budget*>& budgets) {
+        size_t first = budgets.size() > MAX_HISTORY ? budgets.size() - MAX_HISTORY : 0;
+        months = budgets.size() - first;
+        values.assign(SOURCES * months, 0);
+        for (size_t m = 0; m < months; m++) {
+            const Budget& budget = *budgets[first + m];
+            values[m] = budget.getTotalIncome().getCents();
+            for (int c = 0; c < NUM_EXPENSE_CATEGORIES; c++) {
+                values[(c + 1) * months + m] = -budget.getExpense(static_cast<ExpenseCategory>(c)).getCents();
+            }
+        }
+        return months > 0;
+    }
+
+    size_t size() const { return months; }
+    const int64_t* source(int s) const { return values.data() + s * months; }
+
+    // Mean and variance of one simulated month's net savings, in cents
+    double mean() const {
+        double total = 0;
+        for (int64_t v : values) total += static_cast<double>(v);
+        return months > 0 ? total / months : 0;
+    }
+
+    double variance() const {
+        double total = 0;
+        for (int s = 0; s < SOURCES; s++) {
+            const int64_t* table = source(s);
+            double sum = 0, squares = 0;
+            for (size_t m = 0; m < months; m++) {
+                sum += table[m];
+                squares += static_cast<double>(table[m]) * table[m];
+            }
+            if (months > 0) total += max(0.0, squares / months - (sum / months) * (sum / months));
+        }
+        return total;
+    }
+};
+
+// Counter-based random draws. Draw c of path p is mix(key(p) + counter(c)):
+// no state is carried between draws, so a path comes out the same on any
+// thread and in any block. Keys are distinct for the first 2^32 paths.
+struct ProjectionRng {
+    static uint32_t mix(uint32_t x) {
+        x ^= x >> 16;
+        x *= 0x7FEB352Du;
+        x ^= x >> 15;
+        x *= 0x846CA68Bu;
+        return x ^ (x >> 16);
+    }
+
+    static uint32_t pathKey(uint64_t seed, uint64_t path) {
+        return mix((static_cast<uint32_t>(path) * 0x9E3779B9u) ^ static_cast<uint32_t>(seed >> 32));
+    }
+
+    static uint32_t counterKey(uint64_t seed, uint32_t counter) {
+        return mix(counter * 0x85EBCA6Bu + static_cast<uint32_t>(seed));
+    }
+
+    // Index in [0, n) from the top 16 bits of a draw, n <= 65536
+    static uint32_t pick(uint32_t draw, uint32_t n) { return ((draw >> 16) * n) >> 16; }
+};
+
+// One implementation of the path simulation kernel. simulate runs LANES
+// paths with keys over months, counters[m * SOURCES + s] keying source s
+// of month m, and writes each month's closing balances to
+// balances[m * LANES + lane].
+struct ProjectionKernels {
+    static constexpr size_t LANES = 8;
+
+    const char* name;
+    void (*simulate)(const SavingsModel& model, const uint32_t* keys, const uint32_t* counters, size_t months,
+                     int64_t start, int64_t* balances);
+
+    static const ProjectionKernels& scalar();
+    static const ProjectionKernels* avx2();     // nullptr if not compiled in or not supported by this CPU
+    static const ProjectionKernels& best();
+};
+
+// Portable kernel, lane by lane
+struct ScalarProjectionKernels {
+    static void simulate(const SavingsModel& model, const uint32_t* keys, const uint32_t* counters, size_t months,
+                         int64_t start, int64_t* balances) {
+        constexpr size_t LANES = ProjectionKernels::LANES;
+        uint32_t n = static_cast<uint32_t>(model.size());
+        int64_t balance[LANES];
+        for (size_t lane = 0; lane < LANES; lane++) balance[lane] = start;
+        for (size_t m = 0; m < months; m++) {
+            for (int s = 0; s < SavingsModel::SOURCES; s++) {
+                const int64_t* table = model.source(s);
+                uint32_t counter = counters[m * SavingsModel::SOURCES + s];
+                for (size_t lane = 0; lane < LANES; lane++) {
+                    balance[lane] += table[ProjectionRng::pick(ProjectionRng::mix(keys[lane] + counter), n)];
+                }
+            }
+            for (size_t lane = 0; lane < LANES; lane++) balances[m * LANES + lane] = balance[lane];
+        }
+    }
+};
+
+#ifdef BUDGET_HAVE_AVX2_PROJECTION
+// AVX2 kernel: eight 32-bit draws per step, two four-lane gathers of cents
+struct Avx2ProjectionKernels {
+    __attribute__((target("avx2"))) static __m256i mix(__m256i x) {
+        x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+        x = _mm256_mullo_epi32(x, _mm256_set1_epi32(0x7FEB352D));
+        x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 15));
+        x = _mm256_mullo_epi32(x, _mm256_set1_epi32(static_cast<int>(0x846CA68Bu)));
+        return _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+    }
+
+    __attribute__((target("avx2"))) static void simulate(const SavingsModel& model, const uint32_t* keys,
+                                                         const uint32_t* counters, size_t months, int64_t start,
+                                                         int64_t* balances) {
+        const __m256i n = _mm256_set1_epi32(static_cast<int>(model.size()));
+        const __m256i pathKeys = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys));
+        __m256i low = _mm256_set1_epi64x(start);
+        __m256i high = low;
+        for (size_t m = 0; m < months; m++) {
+            for (int s = 0; s < SavingsModel::SOURCES; s++) {
+                const long long* table = reinterpret_cast<const long long*>(model.source(s));
+                __m256i counter = _mm256_set1_epi32(static_cast<int>(counters[m * SavingsModel::SOURCES + s]));
+                __m256i draw = mix(_mm256_add_epi32(pathKeys, counter));
+                __m256i index = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_srli_epi32(draw, 16), n), 16);
+                low = _mm256_add_epi64(low, _mm256_i32gather_epi64(table, _mm256_castsi256_si128(index), 8));
+                high = _mm256_add_epi64(high, _mm256_i32gather_epi64(table, _mm256_extracti128_si256(index, 1), 8));
+            }
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(balances + m * ProjectionKernels::LANES), low);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(balances + m * ProjectionKernels::LANES + 4), high);
+        }
+    }
+};
+#endif
+
+inline const ProjectionKernels& ProjectionKernels::scalar() {
+    static const ProjectionKernels kernels = {"scalar", ScalarProjectionKernels::simulate};
+    return kernels;
+}
+
+inline const ProjectionKernels* ProjectionKernels::avx2() {
+#ifdef BUDGET_HAVE_AVX2_PROJECTION
+    static const ProjectionKernels kernels = {"avx2", Avx2ProjectionKernels::simulate};
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported ? &kernels : nullptr;
+#else
+    return nullptr;
+#endif
+}
+
+inline const ProjectionKernels& ProjectionKernels::best() {
+    const ProjectionKernels* vectorized = avx2();
+    return vectorized ? *vectorized : scalar();
+}
+
+struct ProjectionOptions {
+    Money goal;             // balance to reach
+    size_t months;          // horizon, at most SavingsProjector::MAX_MONTHS
+    size_t paths;
+    uint64_t seed;
+    Money start;            // balance before the first month
+
+    ProjectionOptions(Money g = Money(), size_t m = 12, size_t p = 1000000, uint64_t s = 42, Money b = Money())
+        : goal(g), months(m), paths(p), seed(s), start(b) {}
+};
+
+// Simulated balances after one month
+struct ProjectionBand {
+    Money p10, p25, p50, p75, p90;
+    double reached;         // share of paths that hit the goal by this month
+};
+
+struct ProjectionResult {
+    size_t paths;
+    size_t historyMonths;
+    Money monthlyMean;      // of one month's net savings, exact
+    Money monthlyStddev;
+    double probability;     // goal reached within the horizon
+    size_t medianMonths;    // first month by which half the paths hit the goal, 0 if none within the horizon
+    vector<ProjectionBand> bands;   // bands[m] after month m + 1
+};
+
+// Monte Carlo projection of a savings balance: every path draws each
+// month's income and category spending from the user's history. Paths
+// run LANES at a time through the best kernel, in chunks across a thread
+// pool; each chunk counts first hits of the goal and a fixed-range
+// histogram of balances per month, and the counts are summed. Every path
+// has its own counter-based stream, so results are bit-identical for any
+// thread count. Percentiles are read off the histograms, to within
+// 1/BINS of a 12 standard deviation range around the expected balance.
+class SavingsProjector {
+public:
+    static constexpr size_t MAX_MONTHS = 600;
+    static constexpr size_t BINS = 512;
+
+private:
+    static constexpr size_t LANES = ProjectionKernels::LANES;
+    static constexpr size_t TASKS_PER_THREAD = 2;
+    static constexpr size_t MIN_CHUNK_PATHS = 16384;
+    static constexpr double RANGE_DEVIATIONS = 6;
+
+    ThreadPool pool;
+    const ProjectionKernels* kernels;
+
+    struct Tally {
+        vector<uint32_t> bins;      // months x BINS
+        vector<uint64_t> hits;      // paths first at the goal in each month
+    };
+
+    // Percentile of a month's histogram, interpolated within its bin
+    static Money percentile(const uint32_t* bins, size_t paths, double low, double width, double pct) {
+        double target = pct * paths;
+        double below = 0;
+        for (size_t b = 0; b < BINS; b++) {
+            if (below + bins[b] >= target && bins[b] > 0) {
+                return Money::fromCents(llround(low + (b + (target - below) / bins[b]) * width));
+            }
+            below += bins[b];
+        }
+        return Money::fromCents(llround(low + BINS * width));
+    }
+
+public:
+    // threads 0 means one per hardware thread
+    explicit SavingsProjector(size_t threads = 0) : pool(threads), kernels(&ProjectionKernels::best()) {}
+
+    size_t getThreadCount() const { return pool.size(); }
+    const ProjectionKernels& getKernels() const { return *kernels; }
+    void setKernels(const ProjectionKernels& k) { kernels = &k; }
+
+    // Simulate options.paths paths over options.months; false if the
+    // model is empty or the horizon or path count is out of range
+    bool project(const SavingsModel& model, const ProjectionOptions& options, ProjectionResult& result) {
+        size_t months = options.months;
+        size_t paths = options.paths;
+        if (model.size() == 0 || months == 0 || months > MAX_MONTHS || paths == 0 || paths > UINT32_MAX) {
+            return false;
+        }
+
+        vector<uint32_t> counters(months * SavingsModel::SOURCES);
+        for (size_t c = 0; c < counters.size(); c++) {
+            counters[c] = ProjectionRng::counterKey(options.seed, static_cast<uint32_t>(c));
+        }
+
+        // Histogram range per month around the expected balance
+        double mean = model.mean();
+        double deviation = sqrt(model.variance());
+        vector<double> lows(months), widths(months), scales(months);
+        for (size_t m = 0; m < months; m++) {
+            double center = options.start.getCents() + mean * (m + 1);
+            double half = max(RANGE_DEVIATIONS * deviation * sqrt(m + 1.0), 100.0);
+            lows[m] = center - half;
+            widths[m] = 2 * half / BINS;
+            scales[m] = 1 / widths[m];
+        }
+
+        size_t blocks = (paths + LANES - 1) / LANES;
+        size_t chunks = max<size_t>(1, min(pool.size() * TASKS_PER_THREAD, paths / MIN_CHUNK_PATHS));
+        vector<Tally> tallies(chunks);
+        int64_t goal = options.goal.getCents();
+        const ProjectionKernels& kernel = *kernels;
+
+        pool.parallelFor(chunks, [&](size_t chunk) {
+            Tally& tally = tallies[chunk];
+            tally.bins.assign(months * BINS, 0);
+            tally.hits.assign(months, 0);
+            vector<int64_t> balances(months * LANES);
+            uint32_t keys[LANES];
+            for (size_t block = blocks * chunk / chunks; block < blocks * (chunk + 1) / chunks; block++) {
+                size_t first = block * LANES;
+                size_t lanes = min(LANES, paths - first);
+                for (size_t lane = 0; lane < LANES; lane++) keys[lane] = ProjectionRng::pathKey(options.seed, first + lane);
+                kernel.simulate(model, keys, counters.data(), months, options.start.getCents(), balances.data());
+
+                bool reached[LANES] = {};
+                for (size_t m = 0; m < months; m++) {
+                    const int64_t* row = balances.data() + m * LANES;
+                    uint32_t* bins = tally.bins.data() + m * BINS;
+                    for (size_t lane = 0; lane < lanes; lane++) {
+                        double position = (row[lane] - lows[m]) * scales[m];
+                        bins[static_cast<size_t>(min(max(position, 0.0), BINS - 1.0))]++;
+                        bool hit = !reached[lane] && row[lane] >= goal;
+                        tally.hits[m] += hit;
+                        reached[lane] |= hit;
+                    }
+                }
+            }
+        });
+
+        result.paths = paths;
+        result.historyMonths = model.size();
+        result.monthlyMean = Money::fromCents(llround(mean));
+        result.monthlyStddev = Money::fromCents(llround(deviation));
+        result.medianMonths = 0;
+        result.bands.assign(months, ProjectionBand());
+        vector<uint32_t> bins(BINS);
+        uint64_t reached = 0;
+        for (size_t m = 0; m < months; m++) {
+            fill(bins.begin(), bins.end(), 0);
+            for (const Tally& tally : tallies) {
+                reached += tally.hits[m];
+                for (size_t b = 0; b < BINS; b++) bins[b] += tally.bins[m * BINS + b];
+            }
+            ProjectionBand& band = result.bands[m];
+            band.p10 = percentile(bins.data(), paths, lows[m], widths[m], 0.10);
+            band.p25 = percentile(bins.data(), paths, lows[m], widths[m], 0.25);
+            band.p50 = percentile(bins.data(), paths, lows[m], widths[m], 0.50);
+            band.p75 = percentile(bins.data(), paths, lows[m], widths[m], 0.75);
+            band.p90 = percentile(bins.data(), paths, lows[m], widths[m], 0.90);
+            band.reached = static_cast<double>(reached) / paths;
+            if (result.medianMonths == 0 && reached * 2 >= paths) result.medianMonths = m + 1;
+        }
+        result.probability = result.bands.back().reached;
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Bounded single-producer/single-consumer ring. Head and tail live on
+// separate cache lines and each side caches the other's index, so a
+// push or pop touches shared memory only when the ring looks full or
+// empty. push() blocks while the ring is full, which is how a slow
+// consumer holds back its producer.
+template<typename T>
+class SpscQueue {
+private:
+    vector<T> slots;
+    size_t mask;
+
+    alignas(64) atomic<size_t> head;    // next slot to pop, written by the consumer
+    size_t cachedTail;                  // consumer's copy of tail
+    alignas(64) atomic<size_t> tail;    // next slot to push, written by the producer
+    size_t cachedHead;                  // producer's copy of head
+    alignas(64) atomic<bool> closed;
+    size_t fullWaits;                   // pushes that found the ring full (producer side)
+
+    // Spin briefly, then yield, then sleep, so idle stages don't burn a core
+    static void backoff(unsigned& round) {
+        if (round < 64) {
+            round++;
+        } else if (round < 128) {
+            round++;
+            this_thread::yield();
+        } else {
+            this_thread::sleep_for(chrono::microseconds(50));
+        }
+    }
+
+public:
+    // Capacity is rounded up to a power of two
+    explicit SpscQueue(size_t capacity)
+        : head(0), cachedTail(0), tail(0), cachedHead(0), closed(false), fullWaits(0) {
+        size_t size = 2;
+        while (size < capacity) size <<= 1;
+        slots.resize(size);
+        mask = size - 1;
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    bool tryPush(T& value) {
+        size_t t = tail.load(memory_order_relaxed);
+        if (t - cachedHead > mask) {
+            cachedHead = head.load(memory_order_acquire);
+            if (t - cachedHead > mask) return false;
+        }
+        slots[t & mask] = move(value);
+        tail.store(t + 1, memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& value) {
+        size_t h = head.load(memory_order_relaxed);
+        if (h == cachedTail) {
+            cachedTail = tail.load(memory_order_acquire);
+            if (h == cachedTail) return false;
+        }
+        value = move(slots[h & mask]);
+        head.store(h + 1, memory_order_release);
+        return true;
+    }
+
+    // Blocks while full
+    void push(T value) {
+        unsigned round = 0;
+        if (tryPush(value)) return;
+        fullWaits++;
+        while (!tryPush(value)) backoff(round);
+    }
+
+    // Blocks while empty; false once the queue is closed and drained
+    bool pop(T& value) {
+        unsigned round = 0;
+        while (!tryPop(value)) {
+            if (closed.load(memory_order_acquire)) return tryPop(value);
+            backoff(round);
+        }
+        return true;
+    }
+
+    // Producer is done; pop() returns false after the last item
+    void close() { closed.store(true, memory_order_release); }
+
+    size_t capacity() const { return slots.size(); }
+    size_t getFullWaits() const { return fullWaits; }
+};
+
+#endif
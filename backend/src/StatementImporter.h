@@ -0,0 +1,372 @@
+#ifndef STATEMENTIMPORTER_H
+#define STATEMENTIMPORTER_H
+
+#include "CategoryRules.h"
+#include "SystemIO.h"
+#include "ThreadPool.h"
+#include <map>
+#include <unordered_map>
+
+struct StatementSummary {
+    static constexpr size_t MAX_REPORTED_REJECTS = 20;
+
+    uint64_t transactions;
+    uint64_t categorized;       // matched a rule
+    uint64_t rejected;
+    uint64_t clamped;           // monthly expense totals refunds took below zero
+    uint64_t bytes;
+    size_t chunks;
+    double seconds;
+    vector<ParseError> rejects; // the first MAX_REPORTED_REJECTS, in file order
+
+    StatementSummary() : transactions(0), categorized(0), rejected(0), clamped(0), bytes(0), chunks(0), seconds(0) {}
+};
+
+// Turns bank or card statement CSVs into monthly Budget totals.
+// The file is memory mapped and split into newline-aligned chunks that
+// are parsed in parallel; a first parallel pass counts quotes per chunk
+// so a chunk never starts inside a quoted field. Each transaction's
+// description goes through CategoryRules; debits add to the matched
+// expense (other expenses if none), credits add to the matched income
+// (other income if none) or reduce a matched expense as a refund. Totals
+// are kept per chunk by (user, month) and merged at the end; an expense
+// the month's refunds outweigh (bought the month before) is saved as zero.
+//
+// The header names the columns: date, description (or memo, payee,
+// merchant, details, name), amount (negative = debit) or separate
+// debit/credit (or withdrawal/deposit), and optionally user or account.
+// Dates may be YYYY-MM-DD, MM/DD/YYYY or DD.MM.YYYY; amounts may carry
+// $, thousands commas or (parentheses) for negatives.
+class StatementImporter {
+private:
+    enum Field {
+        FIELD_IGNORED,
+        FIELD_DATE,
+        FIELD_DESCRIPTION,
+        FIELD_AMOUNT,
+        FIELD_DEBIT,
+        FIELD_CREDIT,
+        FIELD_USER
+    };
+
+    struct Totals {
+        uint32_t user;          // chunk-local user id
+        uint32_t yearMonth;     // YYYYMM
+        Money values[NUM_BUDGET_COLUMNS];
+    };
+
+    // Everything one chunk produced
+    struct ChunkResult {
+        vector<string_view> users;                  // local id -> name
+        deque<string> names;                        // names that don't view the file
+        unordered_map<string_view, uint32_t> userIds;
+        unordered_map<uint64_t, uint32_t> groups;   // (user, YYYYMM) -> index into totals
+        vector<Totals> totals;
+        uint64_t transactions = 0;
+        uint64_t categorized = 0;
+        uint64_t rejected = 0;
+        vector<ParseError> rejects;
+    };
+
+    const CategoryRules& rules;
+    vector<Field> layout;
+    bool hasUser;
+
+    static bool digits(string_view s, size_t from, size_t count, uint32_t& value) {
+        value = 0;
+        for (size_t i = from; i < from + count; i++) {
+            if (i >= s.size() || s[i] < '0' || s[i] > '9') return false;
+            value = value * 10 + static_cast<uint32_t>(s[i] - '0');
+        }
+        return true;
+    }
+
+    // YYYYMM of a statement date
+    static bool parseYearMonth(string_view s, uint32_t& yearMonth) {
+        uint32_t year, month;
+        if (s.size() >= 10 && s[4] == '-') {
+            if (!digits(s, 0, 4, year) || !digits(s, 5, 2, month)) return false;
+        } else if (s.size() >= 10 && s[2] == '/') {
+            if (!digits(s, 0, 2, month) || !digits(s, 6, 4, year)) return false;
+        } else if (s.size() >= 10 && s[2] == '.') {
+            if (!digits(s, 3, 2, month) || !digits(s, 6, 4, year)) return false;
+        } else {
+            return false;
+        }
+        if (month < 1 || month > 12) return false;
+        yearMonth = year * 100 + month;
+        return true;
+    }
+
+    // Amount with optional $, thousands separators and (negative) form
+    static bool parseAmount(string_view s, Money& value) {
+        char clean[Money::MAX_CHARS + 8];
+        size_t n = 0;
+        bool negative = false;
+        for (char c : s) {
+            if (c == '$' || c == ',' || c == ' ') continue;
+            if (c == '(' || c == ')') {
+                negative = true;
+                continue;
+            }
+            if (n == sizeof(clean)) return false;
+            clean[n++] = c;
+        }
+        if (n == 0) {
+            value = Money();
+            return true;
+        }
+        if (!Money::fromChars(string_view(clean, n), value)) return false;
+        if (negative) value = -value;
+        return true;
+    }
+
+    static string monthName(uint32_t yearMonth) {
+        static const char* const names[] = {"January", "February", "March", "April", "May", "June",
+                                            "July", "August", "September", "October", "November", "December"};
+        return string(names[yearMonth % 100 - 1]) + " " + to_string(yearMonth / 100);
+    }
+
+    static Field fieldOf(string_view header) {
+        string name(CsvFields::trim(header));
+        for (char& c : name) c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+        if (name == "date" || name == "transaction date" || name == "posted date" || name == "posting date") return FIELD_DATE;
+        if (name == "description" || name == "memo" || name == "payee" || name == "merchant" || name == "details" ||
+            name == "name") return FIELD_DESCRIPTION;
+        if (name == "amount") return FIELD_AMOUNT;
+        if (name == "debit" || name == "withdrawal") return FIELD_DEBIT;
+        if (name == "credit" || name == "deposit") return FIELD_CREDIT;
+        if (name == "user" || name == "account") return FIELD_USER;
+        return FIELD_IGNORED;
+    }
+
+    bool readHeader(string_view line) {
+        vector<string_view> fields;
+        deque<string> unquoted;
+        CsvFields::split(line, ',', fields, unquoted);
+        layout.clear();
+        hasUser = false;
+        bool date = false, description = false, amount = false;
+        for (string_view f : fields) {
+            Field field = fieldOf(f);
+            layout.push_back(field);
+            date |= field == FIELD_DATE;
+            description |= field == FIELD_DESCRIPTION;
+            amount |= field == FIELD_AMOUNT || field == FIELD_DEBIT || field == FIELD_CREDIT;
+            hasUser |= field == FIELD_USER;
+        }
+        return date && description && amount;
+    }
+
+    void record(ChunkResult& result, uint64_t line, const char* message) const {
+        result.rejected++;
+        if (result.rejects.size() < StatementSummary::MAX_REPORTED_REJECTS) result.rejects.push_back({line, message});
+    }
+
+    // Parse the records in [begin, end), the first one on line firstLine
+    void parseChunk(const char* begin, const char* end, uint64_t firstLine, string_view defaultUser,
+                    ChunkResult& result) const {
+        vector<string_view> fields;
+        deque<string> unquoted;
+        uint64_t line = firstLine;
+        const char* p = begin;
+        while (p < end) {
+            // A record ends at the first newline outside quotes
+            const char* q = p;
+            bool quoted = false;
+            uint64_t lines = 1;
+            while (q < end && (quoted || *q != '\n')) {
+                if (*q == '"') quoted = !quoted;
+                else if (*q == '\n') lines++;
+                q++;
+            }
+            string_view raw(p, q - p);
+            uint64_t number = line;
+            line += lines;
+            p = q + 1;
+            if (CsvFields::trim(raw).empty()) continue;
+
+            unquoted.clear();
+            if (!CsvFields::split(raw, ',', fields, unquoted) || fields.size() != layout.size()) {
+                record(result, number, "wrong number of fields");
+                continue;
+            }
+            uint32_t yearMonth = 0;
+            string_view description, user = defaultUser;
+            Money amount, part;
+            bool ok = true;
+            for (size_t f = 0; f < fields.size() && ok; f++) {
+                switch (layout[f]) {
+                    case FIELD_DATE: ok = parseYearMonth(fields[f], yearMonth); break;
+                    case FIELD_DESCRIPTION: description = fields[f]; break;
+                    case FIELD_AMOUNT: ok = parseAmount(fields[f], amount); break;
+                    case FIELD_DEBIT:
+                        ok = parseAmount(fields[f], part);
+                        amount -= part < Money() ? -part : part;
+                        break;
+                    case FIELD_CREDIT:
+                        ok = parseAmount(fields[f], part);
+                        amount += part;
+                        break;
+                    case FIELD_USER: user = fields[f]; break;
+                    case FIELD_IGNORED: break;
+                }
+            }
+            if (!ok || yearMonth == 0) {
+                record(result, number, "invalid date or amount");
+                continue;
+            }
+            if (user.empty()) user = defaultUser;
+            if (user.empty()) {
+                record(result, number, "missing user");
+                continue;
+            }
+            if (!Budget::validateName(user)) {
+                record(result, number, "control characters in user");
+                continue;
+            }
+            // A name that needed unescaping views scratch space; keep a copy
+            if (!unquoted.empty() && user.data() != defaultUser.data() && (user.data() < begin || user.data() >= end)) {
+                result.names.emplace_back(user);
+                user = result.names.back();
+            }
+
+            auto inserted = result.userIds.emplace(user, static_cast<uint32_t>(result.users.size()));
+            if (inserted.second) result.users.push_back(user);
+            uint64_t key = (static_cast<uint64_t>(inserted.first->second) << 32) | yearMonth;
+            auto group = result.groups.emplace(key, static_cast<uint32_t>(result.totals.size()));
+            if (group.second) result.totals.push_back(Totals{inserted.first->second, yearMonth, {}});
+            Totals& totals = result.totals[group.first->second];
+
+            int column = rules.match(description);
+            result.transactions++;
+            if (column != CategoryRules::NO_MATCH) result.categorized++;
+            bool expense = column == CategoryRules::NO_MATCH ? amount < Money() : isExpenseColumn(column);
+            if (column == CategoryRules::NO_MATCH) column = expense ? COL_OTHER_EXPENSES : COL_OTHER_INCOME;
+            // Debits raise expenses; a credit to an expense rule is a refund
+            if (expense) totals.values[column] -= amount;
+            else totals.values[column] += amount < Money() ? -amount : amount;
+        }
+    }
+
+public:
+    explicit StatementImporter(const CategoryRules& categoryRules) : rules(categoryRules), hasUser(false) {}
+
+    // Parse a statement and append one Budget per (user, month) in name
+    // and date order. defaultUser is used when the file has no user column.
+    bool importFile(const string& path, const string& defaultUser, vector<Budget>& budgets,
+                    StatementSummary& summary, size_t threads = 0) {
+        summary = StatementSummary();
+        auto started = chrono::steady_clock::now();
+        MappedFile file;
+        if (!file.open(path)) {
+            cerr << "Error: Could not open " << path << "!" << endl;
+            return false;
+        }
+        const char* data = file.begin();
+        size_t size = file.size();
+        summary.bytes = size;
+        if (size >= 3 && memcmp(data, "\xEF\xBB\xBF", 3) == 0) {
+            data += 3;
+            size -= 3;
+        }
+        const char* headerEnd = size ? static_cast<const char*>(memchr(data, '\n', size)) : nullptr;
+        size_t bodyStart = headerEnd ? headerEnd - data + 1 : size;
+        if (!readHeader(string_view(data, headerEnd ? headerEnd - data : size))) {
+            cerr << "Error: " << path << " needs a header with date, description and amount (or debit/credit) columns!" << endl;
+            return false;
+        }
+        if (!hasUser && defaultUser.empty()) {
+            cerr << "Error: " << path << " has no user column, so a user name is required!" << endl;
+            return false;
+        }
+
+        if (threads == 0) threads = ThreadPool::defaultThreadCount();
+        size_t body = size - bodyStart;
+        size_t chunks = max<size_t>(1, min(threads * 4, body / (1 << 20) + 1));
+        summary.chunks = chunks;
+        vector<size_t> rawStart(chunks + 1);
+        for (size_t c = 0; c <= chunks; c++) rawStart[c] = bodyStart + body / chunks * c;
+        rawStart[chunks] = size;
+
+        ThreadPool pool(min(threads, chunks));
+        // Pass 1: quotes and newlines per raw chunk
+        vector<uint64_t> quotes(chunks), newlines(chunks);
+        pool.parallelFor(chunks, [&](size_t c) {
+            uint64_t q = 0, n = 0;
+            for (size_t i = rawStart[c]; i < rawStart[c + 1]; i++) {
+                q += data[i] == '"';
+                n += data[i] == '\n';
+            }
+            quotes[c] = q;
+            newlines[c] = n;
+        });
+
+        // Move every boundary past the next newline outside quotes
+        vector<size_t> start(chunks + 1);
+        vector<uint64_t> firstLine(chunks + 1);
+        start[0] = bodyStart;
+        firstLine[0] = 2;
+        uint64_t quotesBefore = 0, linesBefore = 2;
+        for (size_t c = 1; c < chunks; c++) {
+            quotesBefore += quotes[c - 1];
+            linesBefore += newlines[c - 1];
+            bool quoted = quotesBefore % 2 == 1;
+            size_t i = rawStart[c];
+            uint64_t line = linesBefore;
+            // Boundary already at a record start if the byte before is a newline outside quotes
+            if (!(data[i - 1] == '\n' && !quoted)) {
+                while (i < size && (quoted || data[i] != '\n')) {
+                    if (data[i] == '"') quoted = !quoted;
+                    else if (data[i] == '\n') line++;
+                    i++;
+                }
+                if (i < size) {
+                    i++;
+                    line++;
+                }
+            }
+            start[c] = max(i, start[c - 1]);
+            firstLine[c] = line;
+        }
+        start[chunks] = size;
+
+        // Pass 2: parse and total every chunk
+        vector<ChunkResult> results(chunks);
+        pool.parallelFor(chunks, [&](size_t c) {
+            if (start[c] < start[c + 1]) {
+                parseChunk(data + start[c], data + start[c + 1], firstLine[c], defaultUser, results[c]);
+            }
+        });
+
+        map<pair<string_view, uint32_t>, Money[NUM_BUDGET_COLUMNS]> merged;
+        for (ChunkResult& result : results) {
+            summary.transactions += result.transactions;
+            summary.categorized += result.categorized;
+            summary.rejected += result.rejected;
+            for (const ParseError& e : result.rejects) {
+                if (summary.rejects.size() < StatementSummary::MAX_REPORTED_REJECTS) summary.rejects.push_back(e);
+            }
+            for (const Totals& t : result.totals) {
+                Money* values = merged[{result.users[t.user], t.yearMonth}];
+                for (int col = 0; col < NUM_BUDGET_COLUMNS; col++) values[col] += t.values[col];
+            }
+        }
+        for (auto& entry : merged) {
+            budgets.emplace_back(string(entry.first.first), monthName(entry.first.second));
+            Budget& b = budgets.back();
+            for (int col = 0; col < NUM_BUDGET_COLUMNS; col++) {
+                Money value = entry.second[col];
+                if (!Budget::validatePositive(value)) {
+                    value = Money();
+                    summary.clamped++;
+                }
+                BudgetColumns::set(b, col, value);
+            }
+        }
+        summary.seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+        return true;
+    }
+};
+
+#endif
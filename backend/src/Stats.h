@@ -0,0 +1,328 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Runtime counters and latency timers for the storage and report paths.
+// Each thread bumps its own copy (no locks, no shared cache lines); the
+// copies are merged when a report is taken or the thread exits. Building
+// with -DBUDGET_NO_STATS turns every BUDGET_STAT_* hook into nothing.
+
+enum StatCounter {
+    STAT_BUDGETS_LOADED,
+    STAT_BUDGETS_SAVED,
+    STAT_BUDGETS_EXPORTED,
+    STAT_BYTES_READ,
+    STAT_BYTES_MAPPED,
+    STAT_BYTES_WRITTEN,
+    STAT_READ_CALLS,
+    STAT_MAP_CALLS,
+    STAT_WRITE_CALLS,
+    STAT_SYNC_CALLS,
+    STAT_PARSE_ERRORS,
+    STAT_INDEX_LOOKUPS,
+    STAT_REPORTS_RENDERED,
+    STAT_CHECKPOINTS_LOADED,
+    STAT_CHECKPOINTS_WRITTEN,
+    NUM_STAT_COUNTERS
+};
+
+enum StatTimer {
+    TIMER_LOAD,         // loadBudgets, loadRecords, forEachBudget
+    TIMER_SAVE,         // saveBudget(s), including queueing for group commit
+    TIMER_COMMIT,       // one write (+ sync) of a batch
+    TIMER_FIND,         // indexed point lookup
+    TIMER_EXPORT,       // JSON export
+    TIMER_RENDER,       // budget reports
+    NUM_STAT_TIMERS
+};
+
+inline const char* statCounterName(int counter) {
+    static const char* const names[NUM_STAT_COUNTERS] = {
+        "budgets_loaded", "budgets_saved", "budgets_exported", "bytes_read", "bytes_mapped", "bytes_written",
+        "read_calls", "map_calls", "write_calls", "sync_calls", "parse_errors", "index_lookups", "reports_rendered",
+        "checkpoints_loaded", "checkpoints_written"};
+    return names[counter];
+}
+
+inline const char* statTimerName(int timer) {
+    static const char* const names[NUM_STAT_TIMERS] = {"load", "save", "commit", "find", "export", "render"};
+    return names[timer];
+}
+
+// Log-linear latency buckets: exact below 16 ns, then 8 per power of two
+// (within 12.5%), up to 2^64 ns
+struct LatencyBuckets {
+    static constexpr int SUB_BITS = 3;
+    static constexpr int LINEAR = 16;
+    static constexpr int NUM_BUCKETS = LINEAR + (64 - 4) * (1 << SUB_BITS);
+
+    static int bucketOf(uint64_t ns) {
+        if (ns < LINEAR) return static_cast<int>(ns);
+        int exponent = 63 - __builtin_clzll(ns);
+        int sub = static_cast<int>((ns >> (exponent - SUB_BITS)) & ((1 << SUB_BITS) - 1));
+        return LINEAR + (exponent - 4) * (1 << SUB_BITS) + sub;
+    }
+
+    // Largest value that lands in a bucket
+    static uint64_t upperBound(int bucket) {
+        if (bucket < LINEAR) return static_cast<uint64_t>(bucket);
+        int exponent = (bucket - LINEAR) / (1 << SUB_BITS) + 4;
+        uint64_t sub = static_cast<uint64_t>((bucket - LINEAR) % (1 << SUB_BITS));
+        uint64_t low = (1ULL << exponent) + (sub << (exponent - SUB_BITS));
+        return low + (1ULL << (exponent - SUB_BITS)) - 1;
+    }
+};
+
+// Merged view of one timer
+struct LatencySummary {
+    uint64_t count = 0;
+    uint64_t totalNs = 0;
+    uint64_t maxNs = 0;
+    uint64_t buckets[LatencyBuckets::NUM_BUCKETS] = {};
+
+    // Upper bound of the bucket holding quantile q, capped at the maximum
+    uint64_t quantile(double q) const {
+        if (count == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(count - 1)) + 1;
+        uint64_t seen = 0;
+        for (int b = 0; b < LatencyBuckets::NUM_BUCKETS; b++) {
+            seen += buckets[b];
+            if (seen >= rank) return min(LatencyBuckets::upperBound(b), maxNs);
+        }
+        return maxNs;
+    }
+};
+
+struct StatsSnapshot {
+    uint64_t counters[NUM_STAT_COUNTERS] = {};
+    LatencySummary timers[NUM_STAT_TIMERS];
+};
+
+class Stats {
+private:
+    // One thread's numbers. Only the owner writes, so updates are plain
+    // relaxed load + store; readers merging a live thread see a value that
+    // is at most a few updates old.
+    struct ThreadStats {
+        atomic<uint64_t> counters[NUM_STAT_COUNTERS];
+        struct Timer {
+            atomic<uint64_t> count;
+            atomic<uint64_t> totalNs;
+            atomic<uint64_t> maxNs;
+            atomic<uint64_t> buckets[LatencyBuckets::NUM_BUCKETS];
+        } timers[NUM_STAT_TIMERS];
+
+        ThreadStats() {
+            for (auto& c : counters) c.store(0, memory_order_relaxed);
+            for (Timer& t : timers) {
+                t.count.store(0, memory_order_relaxed);
+                t.totalNs.store(0, memory_order_relaxed);
+                t.maxNs.store(0, memory_order_relaxed);
+                for (auto& b : t.buckets) b.store(0, memory_order_relaxed);
+            }
+        }
+
+        void mergeInto(StatsSnapshot& out) const {
+            for (int c = 0; c < NUM_STAT_COUNTERS; c++) out.counters[c] += counters[c].load(memory_order_relaxed);
+            for (int t = 0; t < NUM_STAT_TIMERS; t++) {
+                LatencySummary& summary = out.timers[t];
+                summary.count += timers[t].count.load(memory_order_relaxed);
+                summary.totalNs += timers[t].totalNs.load(memory_order_relaxed);
+                summary.maxNs = max(summary.maxNs, timers[t].maxNs.load(memory_order_relaxed));
+                for (int b = 0; b < LatencyBuckets::NUM_BUCKETS; b++) {
+                    summary.buckets[b] += timers[t].buckets[b].load(memory_order_relaxed);
+                }
+            }
+        }
+    };
+
+    struct Registry {
+        mutex lock;
+        vector<ThreadStats*> live;
+        StatsSnapshot retired;      // threads that have exited
+    };
+
+    // Never destroyed, so threads exiting during shutdown can still merge
+    static Registry& registry() {
+        static Registry* instance = new Registry();
+        return *instance;
+    }
+
+    struct Local {
+        ThreadStats* stats;
+
+        Local() : stats(new ThreadStats()) {
+            Registry& r = registry();
+            lock_guard<mutex> guard(r.lock);
+            r.live.push_back(stats);
+        }
+
+        ~Local() {
+            Registry& r = registry();
+            {
+                lock_guard<mutex> guard(r.lock);
+                stats->mergeInto(r.retired);
+                r.live.erase(find(r.live.begin(), r.live.end(), stats));
+            }
+            delete stats;
+        }
+    };
+
+    static ThreadStats& local() {
+        thread_local Local mine;
+        return *mine.stats;
+    }
+
+    static void bump(atomic<uint64_t>& value, uint64_t n) {
+        value.store(value.load(memory_order_relaxed) + n, memory_order_relaxed);
+    }
+
+public:
+    static constexpr bool enabled() {
+#ifdef BUDGET_NO_STATS
+        return false;
+#else
+        return true;
+#endif
+    }
+
+    static void add(StatCounter counter, uint64_t n = 1) { bump(local().counters[counter], n); }
+
+    static void record(StatTimer timer, uint64_t ns) {
+        ThreadStats::Timer& t = local().timers[timer];
+        bump(t.count, 1);
+        bump(t.totalNs, ns);
+        if (ns > t.maxNs.load(memory_order_relaxed)) t.maxNs.store(ns, memory_order_relaxed);
+        bump(t.buckets[LatencyBuckets::bucketOf(ns)], 1);
+    }
+
+    // Everything recorded so far, by live and finished threads
+    static StatsSnapshot snapshot() {
+        StatsSnapshot result;
+        Registry& r = registry();
+        lock_guard<mutex> guard(r.lock);
+        result = r.retired;
+        for (const ThreadStats* stats : r.live) stats->mergeInto(result);
+        return result;
+    }
+
+    // Counters and a latency summary per timer that fired
+    static void printReport(ostream& out) {
+        out << "\n--- Runtime Stats ---" << endl;
+        if (!enabled()) {
+            out << "Stats were compiled out (BUDGET_NO_STATS)." << endl;
+            return;
+        }
+        StatsSnapshot s = snapshot();
+        for (int c = 0; c < NUM_STAT_COUNTERS; c++) {
+            if (s.counters[c]) out << "  " << left << setw(20) << statCounterName(c) << right << s.counters[c] << endl;
+        }
+        out << left << setw(10) << "  timer" << right << setw(10) << "count" << setw(12) << "total ms"
+            << setw(11) << "mean us" << setw(10) << "p50 us" << setw(10) << "p90 us" << setw(10) << "p99 us"
+            << setw(11) << "max us" << endl;
+        out << fixed;
+        for (int t = 0; t < NUM_STAT_TIMERS; t++) {
+            const LatencySummary& timer = s.timers[t];
+            if (timer.count == 0) continue;
+            out << "  " << left << setw(8) << statTimerName(t) << right << setw(10) << timer.count
+                << setprecision(2) << setw(12) << timer.totalNs / 1e6
+                << setprecision(1) << setw(11) << timer.totalNs / 1e3 / timer.count
+                << setw(10) << timer.quantile(0.5) / 1e3 << setw(10) << timer.quantile(0.9) / 1e3
+                << setw(10) << timer.quantile(0.99) / 1e3 << setw(11) << timer.maxNs / 1e3 << endl;
+        }
+        out << left;
+    }
+
+    // {"counters": {...}, "timers": {"load": {"count", ..., "buckets": [[upper_ns, count], ...]}}}
+    static string toJson() {
+        StatsSnapshot s = snapshot();
+        string out = "{\"enabled\": ";
+        out += enabled() ? "true" : "false";
+        out += ", \"counters\": {";
+        for (int c = 0; c < NUM_STAT_COUNTERS; c++) {
+            out += c ? ", \"" : "\"";
+            out += statCounterName(c);
+            out += "\": " + to_string(s.counters[c]);
+        }
+        out += "}, \"timers\": {";
+        for (int t = 0; t < NUM_STAT_TIMERS; t++) {
+            const LatencySummary& timer = s.timers[t];
+            out += t ? ", \"" : "\"";
+            out += statTimerName(t);
+            out += "\": {\"count\": " + to_string(timer.count) + ", \"total_ns\": " + to_string(timer.totalNs) +
+                   ", \"p50_ns\": " + to_string(timer.quantile(0.5)) + ", \"p90_ns\": " + to_string(timer.quantile(0.9)) +
+                   ", \"p99_ns\": " + to_string(timer.quantile(0.99)) + ", \"max_ns\": " + to_string(timer.maxNs) +
+                   ", \"buckets\": [";
+            bool first = true;
+            for (int b = 0; b < LatencyBuckets::NUM_BUCKETS; b++) {
+                if (timer.buckets[b] == 0) continue;
+                out += first ? "[" : ", [";
+                out += to_string(LatencyBuckets::upperBound(b)) + ", " + to_string(timer.buckets[b]) + "]";
+                first = false;
+            }
+            out += "]}";
+        }
+        out += "}}\n";
+        return out;
+    }
+
+    // Write toJson() to the file named by BUDGET_STATS_JSON ("-" for stderr);
+    // false if the variable is unset or the file cannot be written
+    static bool dumpFromEnvironment() {
+        const char* path = getenv("BUDGET_STATS_JSON");
+        if (!path || !*path) return false;
+        if (string(path) == "-") {
+            cerr << toJson();
+            return true;
+        }
+        ofstream file(path, ios::binary | ios::trunc);
+        if (!file.is_open()) {
+            cerr << "Warning: Could not write stats to " << path << endl;
+            return false;
+        }
+        file << toJson();
+        return static_cast<bool>(file);
+    }
+};
+
+// Records the lifetime of a scope under one timer
+class ScopedTimer {
+private:
+    StatTimer timer;
+    chrono::steady_clock::time_point start;
+
+public:
+    explicit ScopedTimer(StatTimer t) : timer(t), start(chrono::steady_clock::now()) {}
+    ~ScopedTimer() {
+        auto elapsed = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+        Stats::record(timer, static_cast<uint64_t>(elapsed));
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+};
+
+#ifndef BUDGET_NO_STATS
+#define BUDGET_STAT_JOIN2(a, b) a##b
+#define BUDGET_STAT_JOIN(a, b) BUDGET_STAT_JOIN2(a, b)
+#define BUDGET_STAT_ADD(counter, n) Stats::add(counter, n)
+#define BUDGET_STAT_TIMER(timer) ScopedTimer BUDGET_STAT_JOIN(statTimer, __LINE__)(timer)
+#else
+#define BUDGET_STAT_ADD(counter, n) ((void)0)
+#define BUDGET_STAT_TIMER(timer) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef STRINGINTERNER_H
+#define STRINGINTERNER_H
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+using namespace std;
+
+// Assigns dense uint32 ids to strings; each distinct string is stored once.
+// A deque keeps stored strings at stable addresses so the lookup table can
+// key on string_views into them.
+class StringInterner {
+private:
+    deque<string> strings;
+    unordered_map<string_view, uint32_t> ids;
+
+public:
+    StringInterner() {}
+
+    // Copying would leave the views pointing into the other interner
+    StringInterner(const StringInterner& other) { *this = other; }
+    StringInterner& operator=(const StringInterner& other) {
+        if (this == &other) return *this;
+        clear();
+        for (const string& s : other.strings) intern(s);
+        return *this;
+    }
+
+    uint32_t intern(string_view value) {
+        auto it = ids.find(value);
+        if (it != ids.end()) return it->second;
+        uint32_t id = static_cast<uint32_t>(strings.size());
+        strings.emplace_back(value);
+        ids.emplace(string_view(strings.back()), id);
+        return id;
+    }
+
+    // Id of an already interned string, or size() if unknown
+    uint32_t find(string_view value) const {
+        auto it = ids.find(value);
+        return it == ids.end() ? static_cast<uint32_t>(strings.size()) : it->second;
+    }
+
+    const string& lookup(uint32_t id) const { return strings[id]; }
+    size_t size() const { return strings.size(); }
+
+    void clear() {
+        ids.clear();
+        strings.clear();
+    }
+};
+
+#endif
@@ -0,0 +1,279 @@
+#ifndef SYSTEMIO_H
+#define SYSTEMIO_H
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include "Stats.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+#define BUDGET_O_APPEND (_O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY)
+#define BUDGET_O_TRUNC _O_TRUNC
+#else
+#define BUDGET_O_APPEND (O_WRONLY | O_CREAT | O_APPEND)
+#define BUDGET_O_TRUNC O_TRUNC
+#endif
+
+// 64-bit seek/tell for stdio streams (long is 32-bit on Windows)
+inline bool seekFile(FILE* file, uint64_t offset) {
+#ifdef _WIN32
+    return _fseeki64(file, static_cast<__int64>(offset), SEEK_SET) == 0;
+#else
+    return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+}
+
+inline uint64_t streamSize(FILE* file) {
+#ifdef _WIN32
+    __int64 here = _ftelli64(file);
+    _fseeki64(file, 0, SEEK_END);
+    __int64 size = _ftelli64(file);
+    _fseeki64(file, here, SEEK_SET);
+#else
+    off_t here = ftello(file);
+    fseeko(file, 0, SEEK_END);
+    off_t size = ftello(file);
+    fseeko(file, here, SEEK_SET);
+#endif
+    return size < 0 ? 0 : static_cast<uint64_t>(size);
+}
+
+// Atomically replace to with from (rename over the target)
+inline bool replaceFile(const std::string& from, const std::string& to) {
+#ifdef _WIN32
+    return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+// Read-only memory mapped file (mmap on POSIX, file mapping on Windows)
+class MappedFile {
+private:
+    const char* data;
+    size_t length;
+#ifdef _WIN32
+    HANDLE fileHandle;
+    HANDLE mappingHandle;
+#endif
+
+public:
+    MappedFile() : data(nullptr), length(0)
+#ifdef _WIN32
+        , fileHandle(INVALID_HANDLE_VALUE), mappingHandle(nullptr)
+#endif
+    {}
+
+    explicit MappedFile(const std::string& path) : MappedFile() { open(path); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() { close(); }
+
+    // Map the whole file, returns false if it cannot be opened
+    bool open(const std::string& path) {
+        close();
+#ifdef _WIN32
+        fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                 nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (fileHandle == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(fileHandle, &size)) { close(); return false; }
+        length = static_cast<size_t>(size.QuadPart);
+        if (length == 0) return true;
+        mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mappingHandle) { close(); return false; }
+        data = static_cast<const char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+        if (!data) { close(); return false; }
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0) { ::close(fd); return false; }
+        length = static_cast<size_t>(st.st_size);
+        if (length > 0) {
+            void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED) { ::close(fd); length = 0; return false; }
+            data = static_cast<const char*>(mapped);
+        }
+        ::close(fd);
+#endif
+        BUDGET_STAT_ADD(STAT_MAP_CALLS, 1);
+        BUDGET_STAT_ADD(STAT_BYTES_MAPPED, length);
+        return true;
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (data) UnmapViewOfFile(data);
+        if (mappingHandle) CloseHandle(mappingHandle);
+        if (fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+        mappingHandle = nullptr;
+        fileHandle = INVALID_HANDLE_VALUE;
+#else
+        if (data) munmap(const_cast<char*>(data), length);
+#endif
+        data = nullptr;
+        length = 0;
+    }
+
+    const char* begin() const { return data; }
+    size_t size() const { return length; }
+    bool empty() const { return length == 0; }
+};
+
+// Append-only file descriptor with explicit data sync
+class AppendFile {
+private:
+    int fd;
+
+public:
+    AppendFile() : fd(-1) {}
+    ~AppendFile() { close(); }
+
+    AppendFile(const AppendFile&) = delete;
+    AppendFile& operator=(const AppendFile&) = delete;
+
+    // truncate starts the file over instead of appending to it
+    bool open(const std::string& path, bool truncate = false) {
+        close();
+        int flags = truncate ? BUDGET_O_APPEND | BUDGET_O_TRUNC : BUDGET_O_APPEND;
+#ifdef _WIN32
+        fd = _open(path.c_str(), flags, 0644);
+#else
+        fd = ::open(path.c_str(), flags, 0644);
+#endif
+        return fd >= 0;
+    }
+
+    bool isOpen() const { return fd >= 0; }
+
+    // Write the whole range, retrying on short writes
+    bool write(const char* data, size_t size) {
+        while (size > 0) {
+#ifdef _WIN32
+            int chunk = size > (1u << 30) ? (1 << 30) : static_cast<int>(size);
+            int written = _write(fd, data, chunk);
+#else
+            ssize_t written = ::write(fd, data, size);
+#endif
+            BUDGET_STAT_ADD(STAT_WRITE_CALLS, 1);
+            if (written <= 0) return false;
+            BUDGET_STAT_ADD(STAT_BYTES_WRITTEN, static_cast<uint64_t>(written));
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+        return true;
+    }
+
+    // Flush written data to stable storage
+    bool sync() {
+        BUDGET_STAT_ADD(STAT_SYNC_CALLS, 1);
+#if defined(_WIN32)
+        return _commit(fd) == 0;
+#elif defined(__APPLE__)
+        return fsync(fd) == 0;
+#else
+        return fdatasync(fd) == 0;
+#endif
+    }
+
+    // Current end of file
+    uint64_t size() const {
+#ifdef _WIN32
+        return static_cast<uint64_t>(_filelengthi64(fd));
+#else
+        struct stat st;
+        return fstat(fd, &st) == 0 ? static_cast<uint64_t>(st.st_size) : 0;
+#endif
+    }
+
+    void close() {
+        if (fd < 0) return;
+#ifdef _WIN32
+        _close(fd);
+#else
+        ::close(fd);
+#endif
+        fd = -1;
+    }
+};
+
+// Exclusive advisory lock held through a lock file, so only one process
+// at a time owns a log (flock on POSIX, an unshared handle on Windows)
+class FileLock {
+private:
+#ifdef _WIN32
+    HANDLE handle;
+#else
+    int fd;
+#endif
+
+public:
+#ifdef _WIN32
+    FileLock() : handle(INVALID_HANDLE_VALUE) {}
+#else
+    FileLock() : fd(-1) {}
+#endif
+    ~FileLock() { unlock(); }
+
+    FileLock(const FileLock&) = delete;
+    FileLock& operator=(const FileLock&) = delete;
+
+    // False if another process holds the lock
+    bool tryLock(const std::string& path) {
+        unlock();
+#ifdef _WIN32
+        handle = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_ALWAYS,
+                             FILE_ATTRIBUTE_NORMAL, nullptr);
+        return handle != INVALID_HANDLE_VALUE;
+#else
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd < 0) return false;
+        if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+            unlock();
+            return false;
+        }
+        return true;
+#endif
+    }
+
+    bool isLocked() const {
+#ifdef _WIN32
+        return handle != INVALID_HANDLE_VALUE;
+#else
+        return fd >= 0;
+#endif
+    }
+
+    void unlock() {
+#ifdef _WIN32
+        if (handle != INVALID_HANDLE_VALUE) CloseHandle(handle);
+        handle = INVALID_HANDLE_VALUE;
+#else
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+#endif
+    }
+};
+
+#endif
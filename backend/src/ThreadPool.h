@@ -0,0 +1,174 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Work-stealing thread pool. Every worker owns a task deque: it pushes and
+// pops at the back, idle workers steal from the front of the others. Tasks
+// submitted from inside a task land on the submitting worker's own deque.
+// A thread calling wait() runs queued tasks instead of blocking.
+class ThreadPool {
+private:
+    struct TaskQueue {
+        mutex lock;
+        deque<function<void()>> tasks;
+    };
+
+    vector<unique_ptr<TaskQueue>> queues;
+    vector<thread> workers;
+    atomic<size_t> queued;          // submitted, not yet started
+    atomic<size_t> unfinished;      // submitted, not yet completed
+    atomic<size_t> nextQueue;
+    atomic<bool> stopping;
+    mutex sleepLock;
+    condition_variable wake;
+
+    struct WorkerIdentity {
+        const ThreadPool* pool;
+        size_t index;
+    };
+
+    static WorkerIdentity& identity() {
+        static thread_local WorkerIdentity id = {nullptr, 0};
+        return id;
+    }
+
+    // Index of the worker running on this thread, or the queue count for
+    // threads outside this pool
+    size_t currentWorker() const {
+        const WorkerIdentity& id = identity();
+        return id.pool == this ? id.index : queues.size();
+    }
+
+    bool popOwn(size_t self, function<void()>& task) {
+        if (self >= queues.size()) return false;
+        TaskQueue& queue = *queues[self];
+        lock_guard<mutex> guard(queue.lock);
+        if (queue.tasks.empty()) return false;
+        task = move(queue.tasks.back());
+        queue.tasks.pop_back();
+        return true;
+    }
+
+    bool steal(size_t self, function<void()>& task) {
+        size_t count = queues.size();
+        size_t start = self < count ? self + 1 : 0;
+        for (size_t k = 0; k < count; k++) {
+            TaskQueue& queue = *queues[(start + k) % count];
+            lock_guard<mutex> guard(queue.lock);
+            if (queue.tasks.empty()) continue;
+            task = move(queue.tasks.front());
+            queue.tasks.pop_front();
+            return true;
+        }
+        return false;
+    }
+
+    // Run one queued task if there is any
+    bool runOne(size_t self) {
+        function<void()> task;
+        if (!popOwn(self, task) && !steal(self, task)) return false;
+        queued--;
+        task();
+        if (--unfinished == 0) {
+            lock_guard<mutex> guard(sleepLock);
+            wake.notify_all();
+        }
+        return true;
+    }
+
+    void workerLoop(size_t index) {
+        identity() = WorkerIdentity{this, index};
+        while (true) {
+            if (runOne(index)) continue;
+            unique_lock<mutex> guard(sleepLock);
+            wake.wait(guard, [this] { return stopping || queued > 0; });
+            if (stopping && queued == 0) return;
+        }
+    }
+
+public:
+    // threadCount 0 means one thread per hardware thread
+    explicit ThreadPool(size_t threadCount = 0) : queued(0), unfinished(0), nextQueue(0), stopping(false) {
+        if (threadCount == 0) threadCount = defaultThreadCount();
+        for (size_t i = 0; i < threadCount; i++) queues.push_back(make_unique<TaskQueue>());
+        for (size_t i = 0; i < threadCount; i++) workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool() {
+        wait();
+        {
+            lock_guard<mutex> guard(sleepLock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (thread& worker : workers) worker.join();
+    }
+
+    static size_t defaultThreadCount() {
+        unsigned hardware = thread::hardware_concurrency();
+        return hardware == 0 ? 1 : hardware;
+    }
+
+    size_t size() const { return workers.size(); }
+
+    void submit(function<void()> task) {
+        size_t self = currentWorker();
+        size_t target = self < queues.size() ? self : nextQueue++ % queues.size();
+        unfinished++;
+        queued++;
+        {
+            lock_guard<mutex> guard(queues[target]->lock);
+            queues[target]->tasks.push_back(move(task));
+        }
+        lock_guard<mutex> guard(sleepLock);
+        wake.notify_one();
+    }
+
+    // Block until every submitted task has finished, helping out meanwhile.
+    // Not for use inside a task; use parallelFor there.
+    void wait() {
+        size_t self = currentWorker();
+        while (unfinished > 0) {
+            if (runOne(self)) continue;
+            unique_lock<mutex> guard(sleepLock);
+            wake.wait(guard, [this] { return unfinished == 0 || queued > 0; });
+        }
+    }
+
+    // Run body(i) for i in [0, count) and wait for just those tasks; safe
+    // to nest since the waiting thread keeps running queued work
+    template<typename Body>
+    void parallelFor(size_t count, Body body) {
+        atomic<size_t> remaining(count);
+        for (size_t i = 0; i < count; i++) {
+            submit([this, &body, &remaining, i] {
+                body(i);
+                if (--remaining == 0) {
+                    lock_guard<mutex> guard(sleepLock);
+                    wake.notify_all();
+                }
+            });
+        }
+        size_t self = currentWorker();
+        while (remaining > 0) {
+            if (runOne(self)) continue;
+            unique_lock<mutex> guard(sleepLock);
+            wake.wait(guard, [this, &remaining] { return remaining == 0 || queued > 0; });
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,400 @@
+#ifndef TRENDENGINE_H
+#define TRENDENGINE_H
+
+#include "Budget.h"
+#include "ColumnarStore.h"
+#include "HistoryCodec.h"
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+// Series tracked for every user: one per expense category (numbered like
+// ExpenseCategory), then total spending and savings (income - expenses,
+// negative in an overspent month)
+enum TrendSeries {
+    SERIES_SPENDING = NUM_EXPENSE_CATEGORIES,
+    SERIES_SAVINGS,
+    NUM_TREND_SERIES
+};
+
+inline string_view trendSeriesName(int series) {
+    if (series < NUM_EXPENSE_CATEGORIES) return EXPENSE_CATEGORIES[series].displayName;
+    return series == SERIES_SPENDING ? "Total spending" : "Savings";
+}
+
+inline string_view trendSeriesKey(int series) {
+    if (series < NUM_EXPENSE_CATEGORIES) return EXPENSE_CATEGORIES[series].jsonKey;
+    return series == SERIES_SPENDING ? "spending" : "savings";
+}
+
+// Streaming quantile estimate in constant space: the P-squared algorithm
+// (Jain and Chlamtac) keeps five markers whose heights are nudged toward
+// the quantile with a parabolic fit. Exact for the first five values.
+class P2Quantile {
+private:
+    double p;
+    double heights[5];
+    int32_t positions[5];
+    uint32_t count;
+
+    double parabolic(int i, int step) const {
+        double below = positions[i] - positions[i - 1];
+        double above = positions[i + 1] - positions[i];
+        return heights[i] + step / static_cast<double>(positions[i + 1] - positions[i - 1]) *
+                                ((below + step) * (heights[i + 1] - heights[i]) / above +
+                                 (above - step) * (heights[i] - heights[i - 1]) / below);
+    }
+
+public:
+    explicit P2Quantile(double quantile = 0.5) : p(quantile), heights(), positions(), count(0) {}
+
+    void add(double value) {
+        if (count < 5) {
+            heights[count++] = value;
+            if (count == 5) {
+                sort(heights, heights + 5);
+                for (int i = 0; i < 5; i++) positions[i] = i + 1;
+            }
+            return;
+        }
+
+        int cell;
+        if (value < heights[0]) {
+            heights[0] = value;
+            cell = 0;
+        } else if (value >= heights[4]) {
+            heights[4] = value;
+            cell = 3;
+        } else {
+            cell = 0;
+            while (value >= heights[cell + 1]) cell++;
+        }
+        for (int i = cell + 1; i < 5; i++) positions[i]++;
+        count++;
+
+        // Where markers 1..3 should be after count values
+        const double increments[4] = {0, p / 2, p, (1 + p) / 2};
+        for (int i = 1; i <= 3; i++) {
+            double drift = 1 + (count - 1) * increments[i] - positions[i];
+            if ((drift >= 1 && positions[i + 1] - positions[i] > 1) ||
+                (drift <= -1 && positions[i - 1] - positions[i] < -1)) {
+                int step = drift > 0 ? 1 : -1;
+                double candidate = parabolic(i, step);
+                if (heights[i - 1] < candidate && candidate < heights[i + 1]) {
+                    heights[i] = candidate;
+                } else {
+                    heights[i] += step * (heights[i + step] - heights[i]) / (positions[i + step] - positions[i]);
+                }
+                positions[i] += step;
+            }
+        }
+    }
+
+    double value() const {
+        if (count == 0) return 0;
+        if (count >= 5) return heights[2];
+        double sorted[5];
+        copy(heights, heights + count, sorted);
+        sort(sorted, sorted + count);
+        size_t rank = static_cast<size_t>(ceil(p * count));
+        return sorted[rank > 0 ? rank - 1 : 0];
+    }
+
+    size_t size() const { return count; }
+};
+
+// Rolling statistics over a user's most recent months
+struct WindowTrend {
+    size_t months = 0;  // fewer than the window while history is short
+    Money mean;
+    Money stddev;       // sample standard deviation
+};
+
+// Ways to predict next month, in order of the history they need
+enum ForecastMethod {
+    FORECAST_EWMA,          // the smoothed level
+    FORECAST_LINEAR,        // least squares line over the last 12 months
+    FORECAST_SEASONAL,      // same month last year plus the year-over-year change
+    NUM_FORECAST_METHODS
+};
+
+inline string_view forecastMethodName(ForecastMethod method) {
+    static constexpr string_view NAMES[NUM_FORECAST_METHODS] = {"ewma", "linear", "seasonal"};
+    return NAMES[method];
+}
+
+struct SeriesTrend {
+    Money latest;
+    WindowTrend windows[3];     // 3, 6 and 12 months
+    Money ewma;
+    Money median;               // whole history, P-squared estimates
+    Money p90;
+    Money forecasts[NUM_FORECAST_METHODS];  // seasonal is zero before 24 months
+    ForecastMethod method = FORECAST_EWMA;  // the one with the smallest recent error
+
+    Money forecast() const { return forecasts[method]; }
+};
+
+// Per-user trend state updated in O(1) per saved month. Each series keeps
+// its last 24 monthly values in a ring with running sums for the 3, 6 and
+// 12 month windows, the 12 months before those (for the seasonal
+// forecast) and the time-weighted sum the regression needs, plus an EWMA
+// and two quantile sketches. Before each month is added, every forecast
+// method is scored against it, and forecast() uses the method with the
+// smallest smoothed absolute error for that series, favouring the EWMA.
+// Months must arrive in month order per user (see HistoryStore::monthKey,
+// unknown names count as later); a re-save of the latest month replaces
+// it, except in the sketches and scores, and an older month is skipped
+// with add() returning false so the caller can rebuild that user. Windows
+// count saved months, so gaps are skipped over. About 5 KB per user.
+class TrendEngine {
+public:
+    static constexpr int WINDOWS[3] = {3, 6, 12};
+    static constexpr size_t HISTORY_MONTHS = 24;
+
+private:
+    struct SeriesState {
+        int64_t ring[HISTORY_MONTHS];   // cents, month n at n % HISTORY_MONTHS
+        int64_t sums[3];
+        double squares[3];              // exact while amounts stay under ~$900k
+        int64_t yearBefore;             // sum of the 12 months before the last 12
+        double weighted;                // sum of n * value over the last 12
+        double ewma;
+        double ewmaBefore;              // for replacing the latest month
+        double errors[NUM_FORECAST_METHODS];    // smoothed absolute error of each method
+        P2Quantile median;
+        P2Quantile p90;
+
+        SeriesState() : ring(), sums(), squares(), yearBefore(0), weighted(0), ewma(0), ewmaBefore(0), errors(),
+                        median(0.5), p90(0.9) {}
+    };
+
+    struct UserState {
+        string lastMonth;
+        uint32_t lastKey;
+        uint32_t months;
+        SeriesState series[NUM_TREND_SERIES];
+
+        UserState() : lastKey(HistoryStore::UNKNOWN_MONTH), months(0) {}
+    };
+
+    unordered_map<string, UserState> users;
+    UserState* cached;      // the last user updated; budgets tend to come grouped
+    string cachedName;
+    double alpha;
+    uint64_t updateCount;
+    uint64_t staleCount;
+
+    UserState& stateFor(string_view user) {
+        if (cached && cachedName == user) return *cached;
+        cachedName.assign(user.data(), user.size());
+        cached = &users[cachedName];
+        return *cached;
+    }
+
+    static void seriesValues(const Money* columns, int64_t* values) {
+        int64_t spending = 0;
+        for (int c = 0; c < NUM_EXPENSE_CATEGORIES; c++) {
+            values[c] = columns[expenseColumn(c)].getCents();
+            spending += values[c];
+        }
+        int64_t income = columns[COL_SALARY].getCents() + columns[COL_FREELANCE].getCents() +
+                         columns[COL_INVESTMENTS].getCents() + columns[COL_OTHER_INCOME].getCents();
+        values[SERIES_SPENDING] = spending;
+        values[SERIES_SAVINGS] = income - spending;
+    }
+
+    // Next-month forecasts after m months (m > 0); seasonal needs 24
+    static void forecastsAt(const SeriesState& s, uint32_t m, double* forecasts) {
+        forecasts[FORECAST_EWMA] = s.ewma;
+
+        // Line through the last k months, months numbered 0..k-1, read at k
+        double k = min<uint32_t>(m, 12);
+        double sumY = static_cast<double>(s.sums[2]);
+        double sumTY = s.weighted - (m - k) * sumY;
+        double sumT = k * (k - 1) / 2;
+        double sumTT = (k - 1) * k * (2 * k - 1) / 6;
+        double denominator = k * sumTT - sumT * sumT;
+        double slope = denominator > 0 ? (k * sumTY - sumT * sumY) / denominator : 0;
+        forecasts[FORECAST_LINEAR] = (sumY - slope * sumT) / k + slope * k;
+
+        forecasts[FORECAST_SEASONAL] = m >= HISTORY_MONTHS
+            ? static_cast<double>(s.ring[(m - 12) % HISTORY_MONTHS]) + static_cast<double>(s.sums[2] - s.yearBefore) / 12
+            : 0;
+    }
+
+    // Methods with at least one scored month, starting from the EWMA
+    static int scoredMethods(uint32_t m) {
+        if (m > HISTORY_MONTHS) return NUM_FORECAST_METHODS;
+        return m > 1 ? FORECAST_SEASONAL : 0;
+    }
+
+    void score(SeriesState& s, uint32_t n, double value) {
+        if (n == 0) return;
+        double forecasts[NUM_FORECAST_METHODS];
+        forecastsAt(s, n, forecasts);
+        int methods = n >= HISTORY_MONTHS ? NUM_FORECAST_METHODS : FORECAST_SEASONAL;
+        for (int f = 0; f < methods; f++) {
+            double error = fabs(forecasts[f] - value);
+            // The first score of a method starts its average
+            s.errors[f] = scoredMethods(n) > f ? s.errors[f] + ERROR_SMOOTHING * (error - s.errors[f]) : error;
+        }
+    }
+
+    void append(SeriesState& s, uint32_t n, int64_t value) {
+        score(s, n, static_cast<double>(value));
+
+        // Read everything leaving a window before the ring slot is reused
+        if (n >= HISTORY_MONTHS) s.yearBefore -= s.ring[n % HISTORY_MONTHS];
+        if (n >= 12) {
+            int64_t aged = s.ring[(n - 12) % HISTORY_MONTHS];
+            s.yearBefore += aged;
+            s.weighted -= static_cast<double>(n - 12) * static_cast<double>(aged);
+        }
+        for (int w = 0; w < 3; w++) {
+            if (n < static_cast<uint32_t>(WINDOWS[w])) continue;
+            int64_t leaving = s.ring[(n - WINDOWS[w]) % HISTORY_MONTHS];
+            s.sums[w] -= leaving;
+            s.squares[w] -= static_cast<double>(leaving) * static_cast<double>(leaving);
+        }
+
+        s.ring[n % HISTORY_MONTHS] = value;
+        double v = static_cast<double>(value);
+        for (int w = 0; w < 3; w++) {
+            s.sums[w] += value;
+            s.squares[w] += v * v;
+        }
+        s.weighted += static_cast<double>(n) * v;
+        s.ewmaBefore = s.ewma;
+        s.ewma = n == 0 ? v : s.ewma + alpha * (v - s.ewma);
+        s.median.add(v);
+        s.p90.add(v);
+    }
+
+    void replaceLatest(SeriesState& s, uint32_t months, int64_t value) {
+        uint32_t n = months - 1;
+        int64_t old = s.ring[n % HISTORY_MONTHS];
+        s.ring[n % HISTORY_MONTHS] = value;
+        double v = static_cast<double>(value);
+        double o = static_cast<double>(old);
+        for (int w = 0; w < 3; w++) {
+            s.sums[w] += value - old;
+            s.squares[w] += v * v - o * o;
+        }
+        s.weighted += static_cast<double>(n) * (v - o);
+        s.ewma = n == 0 ? v : s.ewmaBefore + alpha * (v - s.ewmaBefore);
+    }
+
+    static Money cents(double value) { return Money::fromCents(llround(value)); }
+
+public:
+    // Weight of the newest month in the forecast error averages
+    static constexpr double ERROR_SMOOTHING = 0.1;
+    // A method replaces the EWMA only with an error this much smaller;
+    // the noisier fits win on noise otherwise
+    static constexpr double SWITCH_MARGIN = 0.8;
+
+    // alpha weights the newest month in the EWMA
+    explicit TrendEngine(double smoothing = 0.3)
+        : cached(nullptr), alpha(smoothing), updateCount(0), staleCount(0) {}
+
+    TrendEngine(const TrendEngine&) = delete;
+    TrendEngine& operator=(const TrendEngine&) = delete;
+
+    // Add one month of a user's budget (column values as in BudgetRecord);
+    // false if an older month than the latest was skipped
+    bool add(string_view user, string_view month, const Money* columns) {
+        UserState& state = stateFor(user);
+        uint32_t key = HistoryStore::monthKey(month);
+        int64_t values[NUM_TREND_SERIES];
+        seriesValues(columns, values);
+
+        if (state.months > 0 && month == state.lastMonth) {
+            for (int s = 0; s < NUM_TREND_SERIES; s++) replaceLatest(state.series[s], state.months, values[s]);
+            updateCount++;
+            return true;
+        }
+        if (state.months > 0 && key < state.lastKey && state.lastKey != HistoryStore::UNKNOWN_MONTH) {
+            staleCount++;
+            return false;
+        }
+        for (int s = 0; s < NUM_TREND_SERIES; s++) append(state.series[s], state.months, values[s]);
+        state.months++;
+        state.lastKey = key;
+        state.lastMonth.assign(month.data(), month.size());
+        updateCount++;
+        return true;
+    }
+
+    bool add(const Budget& budget) {
+        Money columns[NUM_BUDGET_COLUMNS];
+        for (int c = 0; c < NUM_BUDGET_COLUMNS; c++) columns[c] = BudgetColumns::get(budget, c);
+        return add(budget.getUserName(), budget.getMonth(), columns);
+    }
+
+    // Start a user over from budgets in any order; they are added in month
+    // order, re-saves of a month in the order given
+    void rebuild(const string& user, vector<const Budget*> budgets) {
+        erase(user);
+        stable_sort(budgets.begin(), budgets.end(), [](const Budget* a, const Budget* b) {
+            return HistoryStore::monthKey(a->getMonth()) < HistoryStore::monthKey(b->getMonth());
+        });
+        for (const Budget* budget : budgets) add(*budget);
+    }
+
+    void erase(const string& user) {
+        if (cached && cachedName == user) cached = nullptr;
+        users.erase(user);
+    }
+
+    // Whether month is the latest one added for user, so re-saving it is O(1)
+    bool isLatestMonth(const string& user, string_view month) const {
+        auto it = users.find(user);
+        return it != users.end() && it->second.months > 0 && it->second.lastMonth == month;
+    }
+
+    size_t monthsFor(const string& user) const {
+        auto it = users.find(user);
+        return it == users.end() ? 0 : it->second.months;
+    }
+
+    // Current statistics of one series, false for an unknown user
+    bool trend(const string& user, int series, SeriesTrend& result) const {
+        result = SeriesTrend();
+        auto it = users.find(user);
+        if (it == users.end() || it->second.months == 0) return false;
+        uint32_t m = it->second.months;
+        const SeriesState& s = it->second.series[series];
+
+        result.latest = Money::fromCents(s.ring[(m - 1) % HISTORY_MONTHS]);
+        for (int w = 0; w < 3; w++) {
+            size_t n = min<size_t>(m, WINDOWS[w]);
+            double sum = static_cast<double>(s.sums[w]);
+            double variance = n > 1 ? max(0.0, (s.squares[w] - sum * sum / n) / (n - 1)) : 0.0;
+            result.windows[w] = {n, cents(sum / n), cents(sqrt(variance))};
+        }
+        result.ewma = cents(s.ewma);
+        result.median = cents(s.median.value());
+        result.p90 = cents(s.p90.value());
+
+        double forecasts[NUM_FORECAST_METHODS];
+        forecastsAt(s, m, forecasts);
+        result.method = FORECAST_EWMA;
+        for (int f = 0; f < NUM_FORECAST_METHODS; f++) {
+            result.forecasts[f] = cents(forecasts[f]);
+            if (f < scoredMethods(m) && s.errors[f] < SWITCH_MARGIN * s.errors[result.method]) {
+                result.method = static_cast<ForecastMethod>(f);
+            }
+        }
+        return true;
+    }
+
+    // State kept per user, besides the name and hash table entry
+    static constexpr size_t bytesPerUser() { return sizeof(UserState); }
+
+    size_t size() const { return users.size(); }
+    uint64_t updates() const { return updateCount; }
+    uint64_t skipped() const { return staleCount; }
+};
+
+#endif
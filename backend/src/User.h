@@ -25,13 +25,19 @@ public:
     }
     
     // Getters
-    string getUserName() const { return userName; }
-    string getMonth() const { return month; }
+    const string& getUserName() const { return userName; }
+    const string& getMonth() const { return month; }
     
     // Setters
     void setUserName(string name) { userName = name; }
     void setMonth(string mon) { month = mon; }
     
+    // Keep copies and moves available alongside the virtual destructor
+    User(const User&) = default;
+    User(User&&) = default;
+    User& operator=(const User&) = default;
+    User& operator=(User&&) = default;
+    
     // Virtual destructor
     virtual ~User() {}
 };
@@ -1,8 +1,16 @@
+#include <csignal>
 #include <iostream>
 #include <limits>
 #include <string>
 #include "Budget.h"
 #include "FileHandler.h"
+#include "AggregationEngine.h"
+#include "JsonImporter.h"
+#include "BudgetApi.h"
+#include "BatchPipeline.h"
+#include "StatementImporter.h"
+#include "ReportRenderer.h"
+#include "GroceryLedger.h"
 
 using namespace std;
 
@@ -12,7 +20,7 @@ T getValidatedInput(const string& prompt) {
     T value;
     while (true) {
         cout << prompt;
-        if (cin >> value && value >= 0) {
+        if (cin >> value && value >= T()) {
             cin.ignore(numeric_limits<streamsize>::max(), '\n');
             return value;
         }
@@ -50,6 +58,10 @@ void enterUserDetails(Budget& budget) {
     cout << "\n--- Enter User Details ---" << endl;
     string name = getStringInput("Enter your name: ");
     string month = getStringInput("Enter month (e.g., January 2024): ");
+    if (!Budget::validateName(name) || !Budget::validateName(month)) {
+        cout << "✗ Name and month can't contain control characters or start with \"---\"." << endl;
+        return;
+    }
     
     budget.Income::setUserName(name);
     budget.Income::setMonth(month);
@@ -59,51 +71,61 @@ void enterUserDetails(Budget& budget) {
 void enterIncomeDetails(Budget& budget) {
     cout << "\n--- Enter Income Details ---" << endl;
     
-    double salary = getValidatedInput<double>("Enter salary: $");
+    Money salary = getValidatedInput<Money>("Enter salary: $");
     budget.setSalary(salary);
     
-    double freelance = getValidatedInput<double>("Enter freelance income: $");
+    Money freelance = getValidatedInput<Money>("Enter freelance income: $");
     budget.setFreelance(freelance);
     
-    double investments = getValidatedInput<double>("Enter investment returns: $");
+    Money investments = getValidatedInput<Money>("Enter investment returns: $");
     budget.setInvestments(investments);
     
-    double other = getValidatedInput<double>("Enter other income: $");
+    Money other = getValidatedInput<Money>("Enter other income: $");
     budget.setOtherIncome(other);
     
     cout << "\n✓ Income details saved!" << endl;
     cout << "Total Income: $" << budget.getTotalIncome() << endl;
 }
 
-void enterExpenseDetails(Budget& budget) {
-    cout << "\n--- Enter Expense Details ---" << endl;
-    
-    double rent = getValidatedInput<double>("Enter rent/mortgage: $");
-    budget.setRent(rent);
-    
-    double groceries = getValidatedInput<double>("Enter groceries: $");
-    budget.setGroceries(groceries);
-    
-    double utilities = getValidatedInput<double>("Enter utilities (electricity, water, etc.): $");
-    budget.setUtilities(utilities);
-    
-    double transport = getValidatedInput<double>("Enter transportation: $");
-    budget.setTransportation(transport);
-    
-    double entertainment = getValidatedInput<double>("Enter entertainment: $");
-    budget.setEntertainment(entertainment);
-    
-    double healthcare = getValidatedInput<double>("Enter healthcare: $");
-    budget.setHealthcare(healthcare);
-    
-    double education = getValidatedInput<double>("Enter education: $");
-    budget.setEducation(education);
+// Itemized groceries; the ledger keeps the budget's groceries total in sync
+void enterGroceryItems(Budget& budget, GroceryLedger& groceries) {
+    uint32_t date = 0;
+    while (!GroceryLedger::parseDate(getStringInput("Enter purchase month (YYYY-MM): ") + "-01", date)) {
+        cout << "Invalid month! Please use YYYY-MM." << endl;
+    }
+    uint32_t yearMonth = GroceryLedger::yearMonthOf(date);
+    groceries.bind(budget, yearMonth);
     
-    double shopping = getValidatedInput<double>("Enter shopping: $");
-    budget.setShopping(shopping);
+    while (true) {
+        string item = getStringInput("Enter item name (blank to finish): ");
+        if (item.empty()) break;
+        double quantity = getValidatedInput<double>("Enter quantity: ");
+        Money unitPrice = getValidatedInput<Money>("Enter unit price: $");
+        string store = getStringInput("Enter store: ");
+        uint32_t days = GroceryLedger::daysInMonth(yearMonth);
+        uint32_t day = getValidatedInput<uint32_t>("Enter day of month: ");
+        while (day < 1 || day > days) {
+            cout << "Invalid day! This month has days 1 to " << days << "." << endl;
+            day = getValidatedInput<uint32_t>("Enter day of month: ");
+        }
+        if (groceries.addInMonth(yearMonth, day, item, quantity, unitPrice, store)) {
+            cout << "Groceries so far: $" << groceries.getMonthTotal(yearMonth) << endl;
+        }
+    }
+}
+
+void enterExpenseDetails(Budget& budget, GroceryLedger& groceries) {
+    cout << "\n--- Enter Expense Details ---" << endl;
     
-    double other = getValidatedInput<double>("Enter other expenses: $");
-    budget.setOtherExpenses(other);
+    for (const CategoryDescriptor& category : EXPENSE_CATEGORIES) {
+        if (category.id == EXP_GROCERIES && getStringInput("Itemize groceries? (y/n): ") == "y") {
+            enterGroceryItems(budget, groceries);
+            continue;
+        }
+        if (category.id == EXP_GROCERIES) groceries.unbind(budget);
+        Money amount = getValidatedInput<Money>("Enter " + string(category.prompt) + ": $");
+        budget.setExpense(category.id, amount);
+    }
     
     cout << "\n✓ Expense details saved!" << endl;
     cout << "Total Expenses: $" << budget.getTotalExpenses() << endl;
@@ -111,18 +133,20 @@ void enterExpenseDetails(Budget& budget) {
 
 void setSavingsGoal(Budget& budget) {
     cout << "\n--- Set Savings Goal ---" << endl;
-    double goal = getValidatedInput<double>("Enter your savings goal for this month: $");
+    Money goal = getValidatedInput<Money>("Enter your savings goal for this month: $");
     budget.setSavingsGoal(goal);
     cout << "✓ Savings goal set to $" << goal << endl;
 }
 
 void viewExpenseBreakdown(const Budget& budget) {
+    BUDGET_STAT_TIMER(TIMER_RENDER);
+    BUDGET_STAT_ADD(STAT_REPORTS_RENDERED, 1);
     cout << "\n--- Expense Breakdown ---" << endl;
     
     auto breakdown = budget.getExpenseBreakdown();
-    double total = budget.getTotalExpenses();
+    Money total = budget.getTotalExpenses();
     
-    if (total == 0) {
+    if (total == Money()) {
         cout << "No expenses recorded yet." << endl;
         return;
     }
@@ -130,11 +154,11 @@ void viewExpenseBreakdown(const Budget& budget) {
     cout << left << setw(20) << "Category" << setw(12) << "Amount" << "Percentage" << endl;
     cout << string(45, '-') << endl;
     
-    for (const auto& pair : breakdown) {
-        if (pair.second > 0) {
-            double percentage = (pair.second / total) * 100;
-            cout << left << setw(20) << pair.first 
-                 << "$" << setw(11) << fixed << setprecision(2) << pair.second
+    for (const ExpenseItem& item : breakdown) {
+        if (item.amount > Money()) {
+            double percentage = (item.amount.toDouble() / total.toDouble()) * 100;
+            cout << left << setw(20) << item.name 
+                 << "$" << setw(11) << fixed << setprecision(2) << item.amount
                  << setprecision(1) << percentage << "%" << endl;
         }
     }
@@ -144,26 +168,494 @@ void viewExpenseBreakdown(const Budget& budget) {
          << "$" << fixed << setprecision(2) << total << endl;
 }
 
-void loadPreviousBudgets() {
-    FileHandler fileHandler;
-    vector<Budget> budgets = fileHandler.loadBudgets();
-    
-    if (budgets.empty()) {
+void loadPreviousBudgets(FileHandler& fileHandler) {
+    BUDGET_STAT_TIMER(TIMER_RENDER);
+    ReportRenderer report(stdout, REPORT_TEXT);
+    if (!fileHandler.forEachBudget([&report](const Budget& b) { report.add(b); })) {
+        cerr << "Info: No existing budget file found." << endl;
+    }
+    if (report.finish() == 0) {
         cout << "\nNo previous budgets found." << endl;
-        return;
+    }
+}
+
+// Rewrite the budget log keeping only the latest save of each month
+int compactLog(FileHandler& fileHandler) {
+    if (fileHandler.getFormat() != TEXT_FORMAT) {
+        cout << "Binary budget files are rewritten on every save and never need compacting." << endl;
+        return 0;
+    }
+    CompactionReport report;
+    if (!fileHandler.compact(report)) return 1;
+    cout << fixed << setprecision(1);
+    cout << "✓ Compacted " << fileHandler.getFilename() << ": kept " << report.recordsKept << " of "
+         << report.recordsBefore << " records, " << report.bytesBefore << " -> " << report.bytesAfter
+         << " bytes (" << report.bytesReclaimed() << " reclaimed) in " << setprecision(3) << report.seconds << " s"
+         << endl;
+    if (report.malformedLines > 0) {
+        cerr << "Warning: " << report.malformedLines << " malformed lines found while compacting" << endl;
+    }
+    return 0;
+}
+
+// Snapshot the whole budget file so the next start only replays what follows
+int writeCheckpoint(FileHandler& fileHandler) {
+    if (fileHandler.getFormat() != TEXT_FORMAT) {
+        cout << "Binary budget files need no checkpoint." << endl;
+        return 0;
+    }
+    size_t records = 0;
+    uint64_t coveredBytes = 0;
+    if (!fileHandler.writeCheckpoint(records, coveredBytes)) {
+        cerr << "Error: Could not checkpoint " << fileHandler.getFilename() << "!" << endl;
+        return 1;
+    }
+    cout << "✓ Checkpointed " << records << " budgets (" << coveredBytes << " bytes of "
+         << fileHandler.getFilename() << ")" << endl;
+    return 0;
+}
+
+// Render every saved budget as a text, CSV or Markdown report
+int writeReport(FileHandler& fileHandler, const string& formatName, const string& path) {
+    ReportFormat format;
+    if (!ReportRenderer::parseFormat(formatName, format)) {
+        cerr << "Error: Unknown report format " << formatName << " (use text, csv or md)" << endl;
+        return 1;
+    }
+    FILE* out = path.empty() ? stdout : fopen(path.c_str(), "wb");
+    if (!out) {
+        cerr << "Error: Could not open " << path << " for writing!" << endl;
+        return 1;
     }
     
-    cout << "\n--- Previous Budgets ---" << endl;
-    for (size_t i = 0; i < budgets.size(); i++) {
-        cout << "\n[Budget #" << (i + 1) << "]" << endl;
-        displayBudgetSummary(budgets[i]);
+    BUDGET_STAT_TIMER(TIMER_RENDER);
+    size_t rendered;
+    bool read, ok;
+    {
+        ReportRenderer report(out, format);
+        read = fileHandler.forEachBudget([&report](const Budget& b) { report.add(b); });
+        rendered = report.finish();
+        ok = report.ok();
     }
+    if (out != stdout && fclose(out) != 0) ok = false;
+    if (!read) {
+        cerr << "Error: Could not read budgets from " << fileHandler.getFilename() << "!" << endl;
+        return 1;
+    }
+    if (!ok) {
+        cerr << "Error: Could not write the report!" << endl;
+        return 1;
+    }
+    if (!path.empty()) cout << "✓ Wrote " << rendered << " budgets to " << path << endl;
+    return 0;
+}
+
+// Print the expense distribution of one user or month
+void printRollup(const string& title, const Rollup& group) {
+    BUDGET_STAT_TIMER(TIMER_RENDER);
+    BUDGET_STAT_ADD(STAT_REPORTS_RENDERED, 1);
+    cout << "\n" << title << " (" << group.records << " budgets)" << endl;
+    cout << left << setw(16) << "Category" << right << setw(14) << "Sum" << setw(12) << "Mean"
+         << setw(12) << "P50" << setw(12) << "P90" << setw(12) << "P99" << endl;
+    for (const CategoryDescriptor& category : EXPENSE_CATEGORIES) {
+        const CategoryStats& stats = group.categories[category.id];
+        cout << left << setw(16) << category.displayName << right << setw(14) << stats.sum << setw(12) << stats.mean
+             << setw(12) << stats.p50 << setw(12) << stats.p90 << setw(12) << stats.p99 << endl;
+    }
+    cout << left;
 }
 
-int main() {
+// Per-month and per-user rollups of every saved budget
+int printRollups(FileHandler& fileHandler, size_t threads) {
+    BudgetRecordSet records;
+    if (!fileHandler.loadRecords(records) || records.size() == 0) {
+        cout << "No previous budgets found." << endl;
+        return 1;
+    }
+    
+    BudgetLedger ledger;
+    ledger.add(records);
+    AggregationEngine engine(threads);
+    AggregationResult result = engine.aggregate(ledger);
+    
+    cout << "--- Per-Month Rollups (" << engine.getThreadCount() << " threads) ---" << endl;
+    for (const Rollup& month : result.months) {
+        printRollup(ledger.getMonths().lookup(month.key), month);
+    }
+    cout << "\n--- Per-User Rollups ---" << endl;
+    for (const Rollup& user : result.users) {
+        printRollup(ledger.getUsers().lookup(user.key), user);
+    }
+    return 0;
+}
+
+// The latest save of each of a user's months, in month order; false and
+// a message if there are none
+bool loadUserMonths(FileHandler& fileHandler, const string& user, vector<Budget>& months) {
+    bool ok = fileHandler.forEachBudget([&](const Budget& budget) {
+        if (budget.getUserName() != user) return;
+        for (Budget& existing : months) {
+            if (existing.getMonth() == budget.getMonth()) {
+                existing = budget;
+                return;
+            }
+        }
+        months.push_back(budget);
+    });
+    if (!ok || months.empty()) {
+        cout << "No budgets found for " << user << endl;
+        return false;
+    }
+    stable_sort(months.begin(), months.end(), [](const Budget& a, const Budget& b) {
+        return HistoryStore::monthKey(a.getMonth()) < HistoryStore::monthKey(b.getMonth());
+    });
+    return true;
+}
+
+// Rolling averages, quantiles and next-month forecasts for one user
+int printTrends(FileHandler& fileHandler, const string& user) {
+    vector<Budget> months;
+    if (!loadUserMonths(fileHandler, user, months)) return 1;
+    
+    TrendEngine trends;
+    vector<const Budget*> history;
+    for (const Budget& budget : months) history.push_back(&budget);
+    trends.rebuild(user, history);
+    
+    BUDGET_STAT_TIMER(TIMER_RENDER);
+    BUDGET_STAT_ADD(STAT_REPORTS_RENDERED, 1);
+    cout << "\n--- Trends for " << user << " (" << trends.monthsFor(user) << " months) ---" << endl;
+    cout << left << setw(16) << "Series" << right << setw(12) << "Latest" << setw(12) << "3-mo avg"
+         << setw(12) << "6-mo avg" << setw(12) << "12-mo avg" << setw(12) << "12-mo sd" << setw(12) << "EWMA"
+         << setw(12) << "Median" << setw(12) << "P90" << setw(12) << "Forecast" << "  Method" << endl;
+    for (int series = 0; series < NUM_TREND_SERIES; series++) {
+        SeriesTrend t;
+        trends.trend(user, series, t);
+        cout << left << setw(16) << trendSeriesName(series) << right << setw(12) << t.latest
+             << setw(12) << t.windows[0].mean << setw(12) << t.windows[1].mean << setw(12) << t.windows[2].mean
+             << setw(12) << t.windows[2].stddev << setw(12) << t.ewma << setw(12) << t.median << setw(12) << t.p90
+             << setw(12) << t.forecast() << "  " << forecastMethodName(t.method) << endl;
+    }
+    cout << left;
+    return 0;
+}
+
+// Chance of saving goal within a horizon, simulated from the user's history
+int printProjection(FileHandler& fileHandler, const string& user, const string& goalText, size_t months,
+                    size_t threads) {
+    Money goal;
+    if (!Money::fromChars(goalText, goal) || months == 0 || months > SavingsProjector::MAX_MONTHS) {
+        cerr << "Error: Expected a goal amount and 1 to " << SavingsProjector::MAX_MONTHS << " months!" << endl;
+        return 1;
+    }
+    vector<Budget> history;
+    if (!loadUserMonths(fileHandler, user, history)) return 1;
+    
+    vector<const Budget*> budgets;
+    for (const Budget& budget : history) budgets.push_back(&budget);
+    SavingsModel model;
+    model.build(budgets);
+    SavingsProjector projector(threads);
+    ProjectionResult result;
+    if (!projector.project(model, ProjectionOptions(goal, months), result)) {
+        cerr << "Error: Could not project savings for " << user << "!" << endl;
+        return 1;
+    }
+    
+    BUDGET_STAT_TIMER(TIMER_RENDER);
+    BUDGET_STAT_ADD(STAT_REPORTS_RENDERED, 1);
+    cout << "\n--- Savings projection for " << user << " ---" << endl;
+    cout << "From " << result.historyMonths << " months of history: saves " << result.monthlyMean
+         << " a month on average (sd " << result.monthlyStddev << ")" << endl;
+    cout << "Chance of reaching " << goal << " within " << months << " months: " << fixed << setprecision(1)
+         << result.probability * 100 << "% (" << result.paths << " simulated paths)" << endl;
+    if (result.medianMonths > 0) cout << "Half of the paths get there within " << result.medianMonths << " months" << endl;
+    
+    // Every month of short horizons, every sixth of long ones
+    size_t step = months <= 36 ? 1 : 6;
+    cout << "\n" << right << setw(6) << "Month" << setw(14) << "P10" << setw(14) << "P25" << setw(14) << "Median"
+         << setw(14) << "P75" << setw(14) << "P90" << setw(10) << "Reached" << endl;
+    for (size_t m = step - 1; m < months; m += step) {
+        const ProjectionBand& band = result.bands[m];
+        cout << setw(6) << m + 1 << setw(14) << band.p10 << setw(14) << band.p25 << setw(14) << band.p50
+             << setw(14) << band.p75 << setw(14) << band.p90 << setw(9) << band.reached * 100 << "%" << endl;
+    }
+    cout << left;
+    return 0;
+}
+
+// Import a JSON export, or a directory of them, into the budget file
+int importJson(FileHandler& fileHandler, const string& path, size_t threads) {
+    vector<Budget> budgets;
+    vector<JsonImportError> errors;
+    JsonImportSummary summary = JsonImporter::importPath(path, budgets, errors, threads);
+    for (const JsonImportError& error : errors) {
+        cerr << "Error: " << error.file;
+        if (error.line > 0) cerr << ":" << error.line << ":" << error.column;
+        cerr << ": " << error.message << endl;
+    }
+    if (summary.files == 0) {
+        cout << "No JSON files found in " << path << endl;
+        return 1;
+    }
+    if (!budgets.empty() && !fileHandler.saveBudgets(budgets)) return 1;
+    cout << "✓ Imported " << summary.budgets << " budgets from " << summary.files << " files";
+    if (summary.failedFiles > 0) cout << " (" << summary.failedFiles << " with errors)";
+    cout << endl;
+    return summary.failedFiles > 0 ? 1 : 0;
+}
+
+// Load CSV/TSV rows from a file or stdin through the batch pipeline
+int runBatch(FileHandler& fileHandler, const string& input) {
+    BatchPipeline pipeline(fileHandler);
+    BatchSummary summary;
+    bool ok = pipeline.run(input, summary);
+    if (summary.seconds == 0) return 1;
+    
+    for (const BatchReject& reject : summary.rejects) {
+        cerr << "Warning: " << input << ":" << reject.line << ": " << reject.reason << endl;
+    }
+    if (summary.rejected > summary.rejects.size()) {
+        cerr << "Warning: " << summary.rejected - summary.rejects.size() << " more rows rejected" << endl;
+    }
+    cout << fixed << setprecision(2);
+    cout << "✓ Batch: " << summary.accepted << " of " << summary.rows << " rows saved, "
+         << summary.rejected << " rejected" << endl;
+    cout << "  " << setprecision(0) << summary.rows / summary.seconds << " rows/sec, "
+         << setprecision(1) << summary.bytes / summary.seconds / 1e6 << " MB/s in "
+         << setprecision(3) << summary.seconds << " s" << endl;
+    cout << setprecision(2) << "  Income $" << summary.totalIncome << ", expenses $" << summary.totalExpenses
+         << ", savings goal met in " << summary.goalsMet << " budgets" << endl;
+    cout << "  Queue full waits (parse/validate/compute/persist): " << summary.fullWaits[0] << "/"
+         << summary.fullWaits[1] << "/" << summary.fullWaits[2] << "/" << summary.fullWaits[3] << endl;
+    return ok && summary.rejected == 0 ? 0 : 1;
+}
+
+// Total a bank statement CSV into monthly budgets using the category rules
+int importStatement(FileHandler& fileHandler, const string& path, const string& user, const string& rulesPath,
+                    size_t threads) {
+    CategoryRules rules;
+    if (!rules.load(rulesPath)) {
+        cerr << "Warning: No category rules in " << rulesPath << ", so everything goes to other income/expenses" << endl;
+    }
+    StatementImporter importer(rules);
+    vector<Budget> budgets;
+    StatementSummary summary;
+    if (!importer.importFile(path, user, budgets, summary, threads)) return 1;
+    
+    for (const ParseError& reject : summary.rejects) {
+        cerr << "Warning: " << path << ":" << reject.line << ": " << reject.message << endl;
+    }
+    if (summary.rejected > summary.rejects.size()) {
+        cerr << "Warning: " << summary.rejected - summary.rejects.size() << " more transactions rejected" << endl;
+    }
+    if (summary.clamped > 0) {
+        cerr << "Warning: " << summary.clamped << " monthly expense totals were below zero after refunds and saved as 0" << endl;
+    }
+    if (!budgets.empty() && !fileHandler.saveBudgets(budgets)) return 1;
+    cout << fixed << setprecision(0);
+    cout << "✓ Statement: " << summary.transactions << " transactions (" << summary.categorized
+         << " matched " << rules.size() << " rules) saved as " << budgets.size() << " monthly budgets" << endl;
+    cout << "  " << summary.transactions / max(summary.seconds, 1e-9) << " transactions/sec, "
+         << setprecision(1) << summary.bytes / max(summary.seconds, 1e-9) / 1e6 << " MB/s in "
+         << setprecision(3) << summary.seconds << " s (" << summary.chunks << " chunks)" << endl;
+    return summary.rejected == 0 ? 0 : 1;
+}
+
+static HttpServer* activeServer = nullptr;
+
+void stopServer(int) {
+    if (activeServer) activeServer->requestStop();
+}
+
+// Serve the JSON API on localhost until interrupted
+int serveApi(FileHandler& fileHandler, uint16_t port, size_t threads) {
+    // Group commit: concurrent saves share one write
+    fileHandler.setWriterOptions(WriterOptions(256, chrono::milliseconds(5)));
+    // Re-saved months pile up in the log; rewrite it once half is stale
+    fileHandler.setCompactionPolicy(CompactionPolicy(0.5, 4 << 20));
+    if (!fileHandler.lockForWriting()) return 1;
+    BudgetApi api(fileHandler);
+    api.load();
+    
+    HttpServer server([&api](const HttpRequest& request, HttpResponse& response) { api.handle(request, response); },
+                      HttpServerOptions(port, threads));
+    if (!server.start()) return 1;
+    activeServer = &server;
+    signal(SIGINT, stopServer);
+    signal(SIGTERM, stopServer);
+    cout << "✓ Serving " << api.size() << " budgets on http://127.0.0.1:" << server.getPort() << "/api ("
+         << server.getThreadCount() << " workers). Press Ctrl+C to stop." << endl;
+    server.join();
+    activeServer = nullptr;
+    fileHandler.flush();
+    if (fileHandler.isCompacting()) {
+        CompactionReport report;
+        fileHandler.finishCompaction(report);
+    }
+    cout << "\nServer stopped." << endl;
+    return 0;
+}
+
+static bool statsRequested = false;
+
+// At exit: the --stats summary and the BUDGET_STATS_JSON dump
+void reportStats() {
+    if (statsRequested) Stats::printReport(cout);
+    Stats::dumpFromEnvironment();
+}
+
+void printUsage() {
+    cout << "Usage: budget_tracker [options]" << endl;
+    cout << "  --columnar                  Store budgets in ../data/budgets.bgtc" << endl;
+    cout << "  --history                   Store budgets in ../data/budgets.bgth (delta encoded per user)" << endl;
+    cout << "  --convert <input> <output>  Convert a text budget file to the columnar format, or to the" << endl;
+    cout << "                              history format when output ends in .bgth" << endl;
+    cout << "  --find <user> <month>       Show the latest saved budget for a user and month" << endl;
+    cout << "  --months <user>             List the months saved for a user" << endl;
+    cout << "  --export <file>             Export every budget (.jsonl lines, .json array, add .gz to compress)" << endl;
+    cout << "  --report <format> [file]    Write every saved budget as text, csv or md (default: stdout)" << endl;
+    cout << "  --compact                   Drop superseded saves from the budget file" << endl;
+    cout << "  --checkpoint                Snapshot the budget file now for faster loading" << endl;
+    cout << "  --batch <file|->            Load CSV/TSV rows (user,month,14 amounts or a USER header) from a file or stdin" << endl;
+    cout << "  --import <file|dir>         Import frontend or backend JSON exports (a directory is read in parallel)" << endl;
+    cout << "  --statement <csv> [user]    Categorize a bank statement CSV into monthly budgets" << endl;
+    cout << "  --rules <file>              Category rules for --statement (default: ../categories.rules)" << endl;
+    cout << "  --serve [port]              Serve the JSON HTTP API on 127.0.0.1 (default port 8080)" << endl;
+    cout << "  --rollup                    Print per-month and per-user expense rollups" << endl;
+    cout << "  --trends <user>             Print rolling averages, quantiles and forecasts for a user" << endl;
+    cout << "  --project <user> <goal> [months]" << endl;
+    cout << "                              Simulate the chance of saving goal within months (default 12)" << endl;
+    cout << "  --stats                     Print I/O counters and latency percentiles on exit" << endl;
+    cout << "                              (set BUDGET_STATS_JSON=<file|-> to also dump them as JSON)" << endl;
+    cout << "  --threads <n>               Worker threads for --rollup, --import, --statement, --project and --serve (default: all cores)" << endl;
+}
+
+int main(int argc, char* argv[]) {
     Budget myBudget;
+    GroceryLedger groceries;
     FileHandler fileHandler;
     int choice;
+    size_t threads = 0;
+    bool rollup = false;
+    string importPath;
+    string statementPath;
+    string statementUser;
+    string rulesPath = "../categories.rules";
+    bool serve = false;
+    uint16_t port = 8080;
+    string projectUser;
+    string projectGoal;
+    size_t projectMonths = 12;
+    
+    // Found before the other options, some of which exit straight away
+    for (int i = 1; i < argc; i++) {
+        if (string(argv[i]) == "--stats") statsRequested = true;
+    }
+    atexit(reportStats);
+    
+    // Loads that replay 8 MB of log past the newest checkpoint write a new one
+    fileHandler.setCheckpointInterval(8 << 20);
+    
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--columnar") {
+            fileHandler = FileHandler("../data/budgets.bgtc", COLUMNAR_FORMAT);
+        } else if (arg == "--history") {
+            fileHandler = FileHandler("../data/budgets.bgth", HISTORY_FORMAT);
+            fileHandler.setHistoryOptions(HistoryWriteOptions(HistoryStore::compressionAvailable()));
+        } else if (arg == "--convert" && i + 2 < argc) {
+            string input = argv[i + 1];
+            string output = argv[i + 2];
+            bool history = output.size() > 5 && output.substr(output.size() - 5) == ".bgth";
+            bool converted = history ? FileHandler::convertToHistory(input, output,
+                                                                     HistoryWriteOptions(HistoryStore::compressionAvailable()))
+                                     : FileHandler::convertToColumnar(input, output);
+            if (!converted) return 1;
+            cout << "✓ Converted " << input << " to " << output << endl;
+            return 0;
+        } else if (arg == "--find" && i + 2 < argc) {
+            Budget found;
+            if (!fileHandler.findBudget(argv[i + 1], argv[i + 2], found)) {
+                cout << "No budget found for " << argv[i + 1] << ", " << argv[i + 2] << endl;
+                return 1;
+            }
+            BUDGET_STAT_TIMER(TIMER_RENDER);
+            BUDGET_STAT_ADD(STAT_REPORTS_RENDERED, 1);
+            displayBudgetSummary(found);
+            return 0;
+        } else if (arg == "--months" && i + 1 < argc) {
+            for (const string& month : fileHandler.listMonths(argv[i + 1])) {
+                cout << month << endl;
+            }
+            return 0;
+        } else if (arg == "--export" && i + 1 < argc) {
+            long long exported = fileHandler.exportAllToJSON(argv[i + 1], JsonExportOptions::forPath(argv[i + 1]));
+            if (exported < 0) return 1;
+            cout << "✓ Exported " << exported << " budgets to " << argv[i + 1] << endl;
+            return 0;
+        } else if (arg == "--report" && i + 1 < argc) {
+            string path = i + 2 < argc && argv[i + 2][0] != '-' ? argv[i + 2] : "";
+            return writeReport(fileHandler, argv[i + 1], path);
+        } else if (arg == "--compact") {
+            return compactLog(fileHandler);
+        } else if (arg == "--checkpoint") {
+            return writeCheckpoint(fileHandler);
+        } else if (arg == "--trends" && i + 1 < argc) {
+            return printTrends(fileHandler, argv[i + 1]);
+        } else if (arg == "--project" && i + 2 < argc) {
+            projectUser = argv[++i];
+            projectGoal = argv[++i];
+            if (i + 1 < argc && isdigit(static_cast<unsigned char>(argv[i + 1][0]))) {
+                projectMonths = strtoul(argv[++i], nullptr, 10);
+            }
+        } else if (arg == "--batch" && i + 1 < argc) {
+            return runBatch(fileHandler, argv[i + 1]);
+        } else if (arg == "--import" && i + 1 < argc) {
+            importPath = argv[++i];
+        } else if (arg == "--statement" && i + 1 < argc) {
+            statementPath = argv[++i];
+            if (i + 1 < argc && argv[i + 1][0] != '-') statementUser = argv[++i];
+        } else if (arg == "--rules" && i + 1 < argc) {
+            rulesPath = argv[++i];
+        } else if (arg == "--serve") {
+            serve = true;
+            if (i + 1 < argc && isdigit(static_cast<unsigned char>(argv[i + 1][0]))) {
+                port = static_cast<uint16_t>(strtoul(argv[++i], nullptr, 10));
+            }
+        } else if (arg == "--stats") {
+            continue;
+        } else if (arg == "--rollup") {
+            rollup = true;
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = strtoul(argv[++i], nullptr, 10);
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+    
+    if (!importPath.empty()) {
+        int status = importJson(fileHandler, importPath, threads);
+        if (status != 0 || !rollup) return status;
+    }
+    
+    if (!statementPath.empty()) {
+        int status = importStatement(fileHandler, statementPath, statementUser, rulesPath, threads);
+        if (status != 0 || !rollup) return status;
+    }
+    
+    if (serve) {
+        return serveApi(fileHandler, port, threads);
+    }
+    
+    if (!projectUser.empty()) {
+        return printProjection(fileHandler, projectUser, projectGoal, projectMonths, threads);
+    }
+    
+    if (rollup) {
+        return printRollups(fileHandler, threads);
+    }
     
     cout << "\n";
     cout << "╔═══════════════════════════════════════════════╗" << endl;
@@ -196,7 +688,7 @@ int main() {
                 break;
                 
             case 3:
-                enterExpenseDetails(myBudget);
+                enterExpenseDetails(myBudget, groceries);
                 break;
                 
             case 4:
@@ -231,7 +723,7 @@ int main() {
             }
                 
             case 9:
-                loadPreviousBudgets();
+                loadPreviousBudgets(fileHandler);
                 break;
                 
             case 0:
@@ -26,23 +26,19 @@ int main() {
 
     cin.ignore(); // Clear input buffer
 
-    // Input item names and prices
+    // Input item names and prices, keeping a running total
+    float total = 0;
     for (int i = 0; i < n; i++) {
         cout << "\nEnter name of item " << i + 1 << ": ";
         getline(cin, items[i].name);
 
         cout << "Enter price of " << items[i].name << ": ";
         cin >> items[i].price;
+        total += items[i].price;
 
         cin.ignore(); // Clear buffer for next input
     }
 
-    // Calculate total grocery cost
-    float total = 0;
-    for (int i = 0; i < n; i++) {
-        total += items[i].price;
-    }
-
     // Display grocery summary
     cout << "\n----------- GROCERY SUMMARY -----------\n";
     cout << fixed << setprecision(2);